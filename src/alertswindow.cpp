@@ -0,0 +1,76 @@
+// Copyright (c) 2020 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <alertswindow.h>
+
+#include <chain.h>
+
+CAlertsWindowEntry::CAlertsWindowEntry(const CBlock& block, const uint256& hash) : hashBlock(hash), vatx(block.vatx)
+{
+    if (!block.vtx.empty() && !block.vtx[0]->vout.empty()) {
+        coinbaseScriptPubKey = block.vtx[0]->vout[0].scriptPubKey;
+    }
+}
+
+void CAlertsWindow::Trim(int nTipHeight)
+{
+    const int64_t nMinHeight = (int64_t) nTipHeight - (int64_t) nMaxEntries;
+    while (!mapEntries.empty() && mapEntries.begin()->first <= nMinHeight) {
+        mapEntries.erase(mapEntries.begin());
+    }
+}
+
+void CAlertsWindow::BlockConnected(const CBlock& block, const CBlockIndex* pindex, const Consensus::Params& params)
+{
+    LOCK(cs);
+    nMaxEntries = params.nAlertsInitializationWindow + ALERTS_WINDOW_REORG_MARGIN;
+
+    // Anything above the new tip belongs to a disconnected branch
+    mapEntries.erase(mapEntries.upper_bound(pindex->nHeight), mapEntries.end());
+    mapEntries[pindex->nHeight] = std::make_shared<const CAlertsWindowEntry>(block, pindex->GetBlockHash());
+    Trim(pindex->nHeight);
+}
+
+void CAlertsWindow::BlockDisconnected(const CBlockIndex* pindex)
+{
+    LOCK(cs);
+    mapEntries.erase(mapEntries.lower_bound(pindex->nHeight), mapEntries.end());
+}
+
+CAlertsWindowEntryRef CAlertsWindow::Insert(const CBlock& block, const CBlockIndex* pindex, const Consensus::Params& params)
+{
+    return Insert(std::make_shared<const CAlertsWindowEntry>(block, pindex->GetBlockHash()), pindex, params);
+}
+
+CAlertsWindowEntryRef CAlertsWindow::Insert(const CAlertsWindowEntryRef& entry, const CBlockIndex* pindex, const Consensus::Params& params)
+{
+    LOCK(cs);
+    nMaxEntries = params.nAlertsInitializationWindow + ALERTS_WINDOW_REORG_MARGIN;
+    const int nTipHeight = mapEntries.empty() ? pindex->nHeight : std::max(mapEntries.rbegin()->first, pindex->nHeight);
+    if ((int64_t) pindex->nHeight > (int64_t) nTipHeight - (int64_t) nMaxEntries) {
+        mapEntries[pindex->nHeight] = entry;
+    }
+    return entry;
+}
+
+CAlertsWindowEntryRef CAlertsWindow::Get(const CBlockIndex* pindex) const
+{
+    LOCK(cs);
+    auto it = mapEntries.find(pindex->nHeight);
+    if (it == mapEntries.end() || it->second->hashBlock != pindex->GetBlockHash())
+        return nullptr;
+    return it->second;
+}
+
+void CAlertsWindow::Clear()
+{
+    LOCK(cs);
+    mapEntries.clear();
+}
+
+size_t CAlertsWindow::Size() const
+{
+    LOCK(cs);
+    return mapEntries.size();
+}
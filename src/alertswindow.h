@@ -0,0 +1,90 @@
+// Copyright (c) 2020 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_ALERTSWINDOW_H
+#define BITCOIN_ALERTSWINDOW_H
+
+#include <consensus/params.h>
+#include <primitives/block.h>
+#include <script/script.h>
+#include <sync.h>
+#include <uint256.h>
+
+#include <map>
+#include <memory>
+#include <vector>
+
+class CBlockIndex;
+
+/** Number of blocks kept below the alerts window, so that short reorgs do not cause misses. */
+static const unsigned int ALERTS_WINDOW_REORG_MARGIN = 10;
+
+/** Alerts related data of a single active chain block. Also stored for pruned blocks, see PruneOneBlockFile. */
+struct CAlertsWindowEntry
+{
+    //! Hash of the block the entry was built from
+    uint256 hashBlock;
+    //! Alerts mined in the block, shared with the block itself
+    std::vector<CAlertTransactionRef> vatx;
+    //! Payout script of the block miner (coinbase output 0)
+    CScript coinbaseScriptPubKey;
+
+    CAlertsWindowEntry() = default;
+    CAlertsWindowEntry(const CBlock& block, const uint256& hash);
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(hashBlock);
+        READWRITE(vatx);
+        READWRITE(coinbaseScriptPubKey);
+    }
+};
+
+typedef std::shared_ptr<const CAlertsWindowEntry> CAlertsWindowEntryRef;
+
+/**
+ * In-memory cache of the alerts mined in the last nAlertsInitializationWindow
+ * blocks of the active chain.
+ *
+ * Alerts mined in block h are confirmed in block h + nAlertsInitializationWindow
+ * and recoveries may spend inputs of alerts mined anywhere inside the window,
+ * so without this cache every CreateNewBlock and every ConnectBlock with
+ * confirmed alerts, alert fees or recoveries has to read and deserialize an
+ * ancestor block from disk.
+ *
+ * Entries are keyed by height and validated against the block hash of the
+ * requested ancestor, so stale entries left behind by a reorg are never
+ * returned. A miss is not an error: callers fall back to reading the block.
+ */
+class CAlertsWindow
+{
+private:
+    mutable CCriticalSection cs;
+    std::map<int, CAlertsWindowEntryRef> mapEntries GUARDED_BY(cs);
+    //! Number of blocks kept below (and including) the tip, set on the first connected block
+    size_t nMaxEntries GUARDED_BY(cs) = 0;
+
+    void Trim(int nTipHeight) EXCLUSIVE_LOCKS_REQUIRED(cs);
+
+public:
+    /** Store data of a block which has been connected to the active chain. */
+    void BlockConnected(const CBlock& block, const CBlockIndex* pindex, const Consensus::Params& params);
+
+    /** Forget data of a block which has been disconnected from the active chain. */
+    void BlockDisconnected(const CBlockIndex* pindex);
+
+    /** Store data of an active chain block read from disk after a miss. */
+    CAlertsWindowEntryRef Insert(const CBlock& block, const CBlockIndex* pindex, const Consensus::Params& params);
+    CAlertsWindowEntryRef Insert(const CAlertsWindowEntryRef& entry, const CBlockIndex* pindex, const Consensus::Params& params);
+
+    /** Return data of the given block, or nullptr if it is not cached. */
+    CAlertsWindowEntryRef Get(const CBlockIndex* pindex) const;
+
+    void Clear();
+    size_t Size() const;
+};
+
+#endif // BITCOIN_ALERTSWINDOW_H
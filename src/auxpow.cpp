@@ -3,6 +3,7 @@
 #include <chainparams.h>
 #include <consensus/consensus.h>
 #include <consensus/merkle.h>
+#include <crypto/sha256.h>
 #include <hash.h>
 #include <pow.h>
 #include <primitives/block.h>
@@ -10,6 +11,7 @@
 #include <util/system.h>
 
 #include <algorithm>
+#include <cassert>
 
 typedef std::vector<unsigned char> valtype;
 
@@ -23,21 +25,25 @@ uint32_t DecodeLE32(const unsigned char* bytes) {
 	return res;
 }
 
-bool CAuxPow::check(const CAuxBlockHeader& auxHeader, const uint256& hashAuxBlock,
-		const int nChainId, const Consensus::Params& params) {
+/** The parts of CAuxPow::check done before its merkle branches are hashed. */
+static bool checkBranchSizes(const CAuxBlockHeader& auxHeader, const int nChainId, const Consensus::Params& params) {
 	if (params.fStrictChainId && auxHeader.parentBlock.GetChainId() == nChainId)
 		return error("Aux POW parent has our chain ID");
 
 	if (auxHeader.vChainMerkleBranch.size() > 30)
 		return error("Aux POW chain merkle branch too long");
 
-	const uint256 nRootHash = CAuxPow::checkMerkleBranch(hashAuxBlock, auxHeader.vChainMerkleBranch,
-			auxHeader.nChainIndex);
+	return true;
+}
+
+/** The rest of CAuxPow::check, given the roots of the chain merkle branch and of the parent coinbase branch. */
+static bool checkRoots(const CAuxBlockHeader& auxHeader, const int nChainId, const uint256& nRootHash,
+		const uint256& hashCoinbaseRoot) {
 	valtype vchRootHash(nRootHash.begin(), nRootHash.end());
 	std::reverse(vchRootHash.begin(), vchRootHash.end()); // correct endian
 
 	// Check that we are in the parent block merkle tree
-	if (CAuxPow::checkMerkleBranch(auxHeader.coinbaseTx->GetHash(), auxHeader.vMerkleBranch, 0) != auxHeader.parentBlock.hashMerkleRoot)
+	if (hashCoinbaseRoot != auxHeader.parentBlock.hashMerkleRoot)
 		return error("Aux POW merkle root incorrect");
 
 	// Check that there is at least one input
@@ -84,6 +90,49 @@ bool CAuxPow::check(const CAuxBlockHeader& auxHeader, const uint256& hashAuxBloc
 	return true;
 }
 
+bool CAuxPow::check(const CAuxBlockHeader& auxHeader, const uint256& hashAuxBlock,
+		const int nChainId, const Consensus::Params& params) {
+	if (!checkBranchSizes(auxHeader, nChainId, params))
+		return false;
+
+	const uint256 nRootHash = CAuxPow::checkMerkleBranch(hashAuxBlock, auxHeader.vChainMerkleBranch,
+			auxHeader.nChainIndex);
+	const uint256 hashCoinbaseRoot = CAuxPow::checkMerkleBranch(auxHeader.coinbaseTx->GetHash(),
+			auxHeader.vMerkleBranch, 0);
+
+	return checkRoots(auxHeader, nChainId, nRootHash, hashCoinbaseRoot);
+}
+
+bool CAuxPow::checkBatch(const std::vector<const CBlockHeader*>& vHeaders, const Consensus::Params& params) {
+	/* Both branches of header i are at 2 * i and 2 * i + 1.  */
+	std::vector<uint256> vHash;
+	std::vector<const std::vector<uint256>*> vMerkleBranches;
+	std::vector<int> vIndex;
+	vHash.reserve(2 * vHeaders.size());
+	vMerkleBranches.reserve(2 * vHeaders.size());
+	vIndex.reserve(2 * vHeaders.size());
+	for (const CBlockHeader* pheader : vHeaders) {
+		const CAuxBlockHeader& auxHeader = *pheader->auxHeader;
+		if (!checkBranchSizes(auxHeader, pheader->GetChainId(), params))
+			return false;
+
+		vHash.push_back(pheader->GetHash());
+		vMerkleBranches.push_back(&auxHeader.vChainMerkleBranch);
+		vIndex.push_back(auxHeader.nChainIndex);
+		vHash.push_back(auxHeader.coinbaseTx->GetHash());
+		vMerkleBranches.push_back(&auxHeader.vMerkleBranch);
+		vIndex.push_back(0);
+	}
+
+	checkMerkleBranches(vHash, vMerkleBranches, std::move(vIndex));
+
+	for (size_t i = 0; i < vHeaders.size(); ++i) {
+		if (!checkRoots(*vHeaders[i]->auxHeader, vHeaders[i]->GetChainId(), vHash[2 * i], vHash[2 * i + 1]))
+			return false;
+	}
+	return true;
+}
+
 uint256 CAuxPow::checkMerkleBranch(uint256 hash, const std::vector<uint256>& vMerkleBranch, int nIndex) {
 	if (nIndex == -1)
 		return uint256();
@@ -98,6 +147,44 @@ uint256 CAuxPow::checkMerkleBranch(uint256 hash, const std::vector<uint256>& vMe
 	return hash;
 }
 
+void CAuxPow::checkMerkleBranches(std::vector<uint256>& vHash, const std::vector<const std::vector<uint256>*>& vMerkleBranches,
+		std::vector<int> vIndex) {
+	assert(vHash.size() == vMerkleBranches.size() && vHash.size() == vIndex.size());
+
+	size_t nDepth = 0;
+	for (size_t i = 0; i < vHash.size(); ++i) {
+		if (vIndex[i] == -1)
+			vHash[i] = uint256();
+		else
+			nDepth = std::max(nDepth, vMerkleBranches[i]->size());
+	}
+
+	std::vector<size_t> vActive;
+	std::vector<unsigned char> vInput;
+	std::vector<unsigned char> vOutput;
+	for (size_t nLevel = 0; nLevel < nDepth; ++nLevel) {
+		/* Concatenate the 64-byte nodes of all branches that reach this level.  */
+		vActive.clear();
+		vInput.clear();
+		for (size_t i = 0; i < vHash.size(); ++i) {
+			if (vIndex[i] == -1 || nLevel >= vMerkleBranches[i]->size())
+				continue;
+			const uint256& sibling = (*vMerkleBranches[i])[nLevel];
+			const uint256& left = (vIndex[i] & 1) ? sibling : vHash[i];
+			const uint256& right = (vIndex[i] & 1) ? vHash[i] : sibling;
+			vInput.insert(vInput.end(), left.begin(), left.end());
+			vInput.insert(vInput.end(), right.begin(), right.end());
+			vIndex[i] >>= 1;
+			vActive.push_back(i);
+		}
+
+		vOutput.resize(32 * vActive.size());
+		SHA256D64(vOutput.data(), vInput.data(), vActive.size());
+		for (size_t k = 0; k < vActive.size(); ++k)
+			std::copy(vOutput.begin() + 32 * k, vOutput.begin() + 32 * (k + 1), vHash[vActive[k]].begin());
+	}
+}
+
 int CAuxPow::getExpectedIndex(uint32_t nNonce, int nChainId, unsigned h) {
 	// Choose a pseudo-random slot in the chain merkle tree
 	// but have it be fixed for a size/nonce/chain combination.
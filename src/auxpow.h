@@ -11,6 +11,7 @@
 #include <uint256.h>
 
 #include <memory>
+#include <vector>
 
 class CAuxBlockHeader;
 class CBlockHeader;
@@ -34,6 +35,16 @@ public:
 	static void initBlockHeader(CBlockHeader& header);
 
 	static uint256 checkMerkleBranch(uint256 hash, const std::vector<uint256>& vMerkleBranch, int nIndex);
+
+	/** Calculate the roots of many merkle branches at once. The nodes of all branches at the same
+	 *  depth are hashed together with the multi-way SHA256D64. vHash holds the leaves on input and
+	 *  the roots on output. */
+	static void checkMerkleBranches(std::vector<uint256>& vHash, const std::vector<const std::vector<uint256>*>& vMerkleBranches,
+			std::vector<int> vIndex);
+
+	/** Like check for the auxpow of each of the given headers, batching their merkle branches.
+	 *  Returns true if all of them are valid. */
+	static bool checkBatch(const std::vector<const CBlockHeader*>& vHeaders, const Consensus::Params& params);
 };
 
 
@@ -0,0 +1,104 @@
+// Copyright (c) 2020 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <auxpow.h>
+#include <chainparams.h>
+#include <primitives/block.h>
+#include <random.h>
+#include <script/script.h>
+
+#include <algorithm>
+#include <cassert>
+#include <memory>
+#include <vector>
+
+/** Number of headers in a headers message */
+static constexpr size_t NUM_HEADERS{2000};
+/** Height of the chain merkle tree of the parent coinbase */
+static constexpr size_t CHAIN_MERKLE_HEIGHT{4};
+/** Height of the parent block merkle tree, about 2000 transactions */
+static constexpr size_t PARENT_MERKLE_HEIGHT{11};
+
+static void WriteLE32(std::vector<unsigned char>& data, uint32_t n)
+{
+    for (int i = 0; i < 4; ++i) {
+        data.push_back(n & 0xff);
+        n >>= 8;
+    }
+}
+
+/** Build merge-mined headers with valid auxpow merkle branches */
+static std::vector<CBlockHeader> CreateAuxPowHeaders(const Consensus::Params& params)
+{
+    FastRandomContext rng(true);
+    std::vector<CBlockHeader> headers(NUM_HEADERS);
+    for (CBlockHeader& header : headers) {
+        header.SetBaseVersion(1, params.nAuxpowChainId);
+        header.SetBlockHeaderVersion(true);
+        header.hashPrevBlock = rng.rand256();
+        header.hashMerkleRoot = rng.rand256();
+
+        std::unique_ptr<CAuxBlockHeader> auxHeader(new CAuxBlockHeader());
+        for (size_t i = 0; i < CHAIN_MERKLE_HEIGHT; ++i) {
+            auxHeader->vChainMerkleBranch.push_back(rng.rand256());
+        }
+        const uint32_t nNonce = rng.rand32();
+        auxHeader->nChainIndex = CAuxPow::getExpectedIndex(nNonce, params.nAuxpowChainId, CHAIN_MERKLE_HEIGHT);
+        const uint256 hashChainRoot = CAuxPow::checkMerkleBranch(header.GetHash(), auxHeader->vChainMerkleBranch, auxHeader->nChainIndex);
+
+        std::vector<unsigned char> vchScript(pchMergedMiningHeader, pchMergedMiningHeader + sizeof(pchMergedMiningHeader));
+        vchScript.insert(vchScript.end(), hashChainRoot.begin(), hashChainRoot.end());
+        std::reverse(vchScript.end() - hashChainRoot.size(), vchScript.end());
+        WriteLE32(vchScript, 1u << CHAIN_MERKLE_HEIGHT);
+        WriteLE32(vchScript, nNonce);
+        CMutableTransaction coinbase;
+        coinbase.vin.resize(1);
+        coinbase.vin[0].prevout.SetNull();
+        coinbase.vin[0].scriptSig = CScript() << vchScript;
+        auxHeader->coinbaseTx = MakeTransactionRef(std::move(coinbase));
+
+        for (size_t i = 0; i < PARENT_MERKLE_HEIGHT; ++i) {
+            auxHeader->vMerkleBranch.push_back(rng.rand256());
+        }
+        auxHeader->parentBlock.nVersion = 1;
+        auxHeader->parentBlock.hashMerkleRoot = CAuxPow::checkMerkleBranch(auxHeader->coinbaseTx->GetHash(), auxHeader->vMerkleBranch, 0);
+
+        header.SetAuxBlockHeader(std::move(auxHeader));
+    }
+    return headers;
+}
+
+static void AuxPowCheck(benchmark::State& state)
+{
+    const auto chainParams = CreateChainParams(CBaseChainParams::MAIN);
+    const Consensus::Params& params = chainParams->GetConsensus();
+    const std::vector<CBlockHeader> headers = CreateAuxPowHeaders(params);
+
+    while (state.KeepRunning()) {
+        for (const CBlockHeader& header : headers) {
+            bool ret = CAuxPow::check(*header.auxHeader, header.GetHash(), header.GetChainId(), params);
+            assert(ret);
+        }
+    }
+}
+
+static void AuxPowCheckBatch(benchmark::State& state)
+{
+    const auto chainParams = CreateChainParams(CBaseChainParams::MAIN);
+    const Consensus::Params& params = chainParams->GetConsensus();
+    const std::vector<CBlockHeader> headers = CreateAuxPowHeaders(params);
+    std::vector<const CBlockHeader*> vHeaders;
+    for (const CBlockHeader& header : headers) {
+        vHeaders.push_back(&header);
+    }
+
+    while (state.KeepRunning()) {
+        bool ret = CAuxPow::checkBatch(vHeaders, params);
+        assert(ret);
+    }
+}
+
+BENCHMARK(AuxPowCheck, 5);
+BENCHMARK(AuxPowCheckBatch, 5);
@@ -0,0 +1,333 @@
+// Copyright (c) 2020 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <chainparams.h>
+#include <coins.h>
+#include <consensus/consensus.h>
+#include <consensus/merkle.h>
+#include <consensus/validation.h>
+#include <crypto/sha256.h>
+#include <key.h>
+#include <keystore.h>
+#include <miner.h>
+#include <pow.h>
+#include <random.h>
+#include <scheduler.h>
+#include <script/sigcache.h>
+#include <script/sign.h>
+#include <script/standard.h>
+#include <txdb.h>
+#include <txmempool.h>
+#include <validation.h>
+#include <validationinterface.h>
+
+#include <boost/thread.hpp>
+
+#include <vector>
+
+/** Number of alerts in the vatx section of the benchmarked blocks */
+static constexpr size_t NUM_ALERTS{200};
+/** Number of recoveries in the benchmarked block */
+static constexpr size_t NUM_RECOVERIES{20};
+/** Number of different heights the alerts reverted by each recovery were mined at */
+static constexpr size_t NUM_ALERT_HEIGHTS{10};
+
+static constexpr CAmount VAULT_TX_FEE{10000};
+
+/**
+ * A regtest chain with a funded vault. The vault outputs can be spent by
+ * alerts signed with the first key and by recoveries signed with both keys.
+ */
+class VaultChainSetup
+{
+public:
+    CScript SCRIPT_PUB;
+
+    VaultChainSetup()
+    {
+        const std::vector<unsigned char> op_true{OP_TRUE};
+        m_witness.stack.push_back(op_true);
+        uint256 witness_program;
+        CSHA256().Write(&op_true[0], op_true.size()).Finalize(witness_program.begin());
+        SCRIPT_PUB = CScript(OP_0) << std::vector<unsigned char>{witness_program.begin(), witness_program.end()};
+
+        CKey alertKey, recoveryKey;
+        alertKey.MakeNewKey(true);
+        recoveryKey.MakeNewKey(true);
+        m_keystore.AddKey(alertKey);
+        m_keystore.AddKey(recoveryKey);
+        m_vault_script = GetScriptForVaultAddress({alertKey.GetPubKey(), recoveryKey.GetPubKey()});
+
+        // Alerts are enabled from height 1 on regtest
+        SelectParams(CBaseChainParams::REGTEST);
+        const CChainParams& chainparams = Params();
+
+        InitSignatureCache();
+        InitScriptExecutionCache();
+        InitVaultTxTypeCache();
+
+        // Start from scratch in case another benchmark left a chain behind
+        UnloadBlockIndex();
+        {
+            LOCK(cs_main);
+            ::pblocktree.reset(new CBlockTreeDB(1 << 20, true));
+            ::pcoinsdbview.reset(new CCoinsViewDB(1 << 23, chainparams, true));
+            ::pcoinsTip.reset(new CCoinsViewCache(pcoinsdbview.get()));
+        }
+        {
+            m_thread_group.create_thread(std::bind(&CScheduler::serviceQueue, &m_scheduler));
+            GetMainSignals().RegisterBackgroundSignalScheduler(m_scheduler);
+            LoadGenesisBlock(chainparams);
+            CValidationState state;
+            ActivateBestChain(state, chainparams);
+            assert(::chainActive.Tip() != nullptr);
+        }
+
+        // Fund the vault with the first coinbase once it matured
+        const CTransactionRef coinbase = MineBlock()->vtx[0];
+        for (int i = 0; i < COINBASE_MATURITY; ++i) {
+            MineBlock();
+        }
+
+        const size_t nOutputs = NUM_ALERTS + NUM_RECOVERIES * NUM_ALERT_HEIGHTS;
+        m_vault_value = (coinbase->vout[0].nValue - VAULT_TX_FEE) / nOutputs;
+        CMutableTransaction fund;
+        fund.vin.emplace_back(COutPoint(coinbase->GetHash(), 0));
+        fund.vin[0].scriptWitness = m_witness;
+        fund.vout.assign(nOutputs, CTxOut(m_vault_value, m_vault_script));
+        const CTransactionRef fundTx = MakeTransactionRef(std::move(fund));
+        SubmitTransaction(fundTx);
+        MineBlock();
+
+        for (uint32_t n = 0; n < nOutputs; ++n) {
+            m_vault_outpoints.emplace_back(fundTx->GetHash(), n);
+        }
+    }
+
+    ~VaultChainSetup()
+    {
+        m_thread_group.interrupt_all();
+        m_thread_group.join_all();
+        GetMainSignals().FlushBackgroundCallbacks();
+        GetMainSignals().UnregisterBackgroundSignalScheduler();
+    }
+
+    std::shared_ptr<CBlock> MineBlock()
+    {
+        auto block = std::make_shared<CBlock>(BlockAssembler{Params()}.CreateNewBlock(SCRIPT_PUB)->block);
+        block->hashMerkleRoot = BlockMerkleRoot(block->vtx);
+
+        while (!CheckProofOfWork(block->GetHash(), block->nBits, Params().GetConsensus())) {
+            ++block->nNonce;
+            assert(block->nNonce);
+        }
+
+        bool processed{ProcessNewBlock(Params(), block, true, nullptr)};
+        assert(processed);
+
+        return block;
+    }
+
+    /** Add alerts spending one unused vault output each to the mempool. */
+    std::vector<CTransactionRef> AddAlerts(size_t nAlerts)
+    {
+        std::vector<CTransactionRef> vAlerts;
+        for (size_t i = 0; i < nAlerts; ++i) {
+            assert(!m_vault_outpoints.empty());
+            CMutableTransaction alert;
+            alert.vin.emplace_back(m_vault_outpoints.back());
+            m_vault_outpoints.pop_back();
+            alert.vout.emplace_back(m_vault_value - VAULT_TX_FEE, SCRIPT_PUB);
+            SignVaultInputs(alert, TX_ALERT);
+
+            vAlerts.push_back(MakeTransactionRef(std::move(alert)));
+            SubmitTransaction(vAlerts.back());
+        }
+        return vAlerts;
+    }
+
+    /** Add a recovery reverting all inputs of the given mined alerts to the mempool. */
+    CTransactionRef AddRecovery(const std::vector<CTransactionRef>& vAlerts)
+    {
+        CMutableTransaction recovery;
+        for (const CTransactionRef& alert : vAlerts) {
+            recovery.vin.insert(recovery.vin.end(), alert->vin.begin(), alert->vin.end());
+        }
+        for (CTxIn& txin : recovery.vin) {
+            txin.scriptSig.clear();
+        }
+        recovery.vout.emplace_back(m_vault_value * recovery.vin.size() - VAULT_TX_FEE, SCRIPT_PUB);
+        SignVaultInputs(recovery, TX_RECOVERY);
+
+        const CTransactionRef tx = MakeTransactionRef(std::move(recovery));
+        SubmitTransaction(tx);
+        return tx;
+    }
+
+private:
+    CScriptWitness m_witness;
+    CBasicKeyStore m_keystore;
+    CScript m_vault_script;
+    CAmount m_vault_value;
+    std::vector<COutPoint> m_vault_outpoints;
+
+    boost::thread_group m_thread_group;
+    CScheduler m_scheduler;
+
+    void SignVaultInputs(CMutableTransaction& mtx, vaulttxntype txType) const
+    {
+        for (unsigned int i = 0; i < mtx.vin.size(); ++i) {
+            SignatureData sigdata;
+            bool signed_input{ProduceSignature(m_keystore, MutableTransactionSignatureCreator(&mtx, i, m_vault_value), m_vault_script, sigdata, txType)};
+            assert(signed_input);
+            UpdateInput(mtx.vin[i], sigdata);
+        }
+    }
+
+    static void SubmitTransaction(const CTransactionRef& tx)
+    {
+        LOCK(::cs_main); // Required for ::AcceptToMemoryPool.
+        CValidationState state;
+        bool ret{::AcceptToMemoryPool(::mempool, state, tx, nullptr /* pfMissingInputs */, nullptr /* plTxnReplaced */, false /* bypass_limits */, /* nAbsurdFee */ 0)};
+        assert(ret);
+    }
+};
+
+static CMutableTransaction SpendingTx(const COutPoint& prevout, const CScript& scriptSig)
+{
+    CMutableTransaction tx;
+    tx.vin.emplace_back(prevout, scriptSig);
+    tx.vout.emplace_back(1, CScript() << OP_TRUE);
+    return tx;
+}
+
+// Look up the type of alert, instant, recovery and regular transactions
+// spending outputs of a coins view, as done by mempool acceptance, block
+// assembly, ConnectBlock and DisconnectBlock. Only the first iteration
+// classifies the transactions, later ones measure vault type cache hits,
+// which is what repeated lookups of the same transaction cost.
+static void VaultTxTypeCached(benchmark::State& state)
+{
+    InitVaultTxTypeCache();
+
+    CKey key1, key2, key3;
+    key1.MakeNewKey(true);
+    key2.MakeNewKey(true);
+    key3.MakeNewKey(true);
+    const CScript alertScript = GetScriptForVaultAddress({key1.GetPubKey(), key2.GetPubKey()});
+    const CScript instantScript = GetScriptForVaultAddress({key1.GetPubKey(), key2.GetPubKey(), key3.GetPubKey()}, true);
+    const CScript regularScript = GetScriptForDestination(key1.GetPubKey().GetID());
+    const std::vector<unsigned char> sig(72, 1);
+
+    CCoinsView viewDummy;
+    CCoinsViewCache view(&viewDummy);
+    std::vector<CTransaction> vtx;
+    for (int i = 0; i < 250; ++i) {
+        const COutPoint alertPrevout(GetRandHash(), 0);
+        const COutPoint instantPrevout(GetRandHash(), 0);
+        const COutPoint regularPrevout(GetRandHash(), 0);
+        view.AddCoin(alertPrevout, Coin(CTxOut(COIN, alertScript), 1, false), false);
+        view.AddCoin(instantPrevout, Coin(CTxOut(COIN, instantScript), 1, false), false);
+        view.AddCoin(regularPrevout, Coin(CTxOut(COIN, regularScript), 1, false), false);
+
+        vtx.emplace_back(SpendingTx(alertPrevout, CScript() << OP_0 << sig << OP_1));
+        vtx.emplace_back(SpendingTx(alertPrevout, CScript() << OP_0 << sig << sig << OP_0));
+        vtx.emplace_back(SpendingTx(instantPrevout, CScript() << OP_0 << sig << sig << OP_1 << OP_0));
+        vtx.emplace_back(SpendingTx(regularPrevout, CScript() << sig << ToByteVector(key1.GetPubKey())));
+    }
+
+    while (state.KeepRunning()) {
+        for (const CTransaction& tx : vtx) {
+            assert(GetVaultTxType(tx, view) != TX_INVALID);
+        }
+    }
+}
+
+// Script checks are served from the script execution cache after the first
+// iteration of the ConnectBlock benchmarks, which leaves the vault specific
+// bookkeeping and the UTXO updates.
+
+// ConnectBlock of a block mining NUM_ALERTS alerts in its vatx section.
+static void VaultConnectBlockAlerts(benchmark::State& state)
+{
+    VaultChainSetup setup;
+    setup.AddAlerts(NUM_ALERTS);
+    const CBlock block = BlockAssembler{Params()}.CreateNewBlock(setup.SCRIPT_PUB)->block;
+    assert(block.vatx.size() == NUM_ALERTS);
+
+    while (state.KeepRunning()) {
+        LOCK(cs_main);
+        CValidationState cvstate;
+        bool valid{TestBlockValidity(cvstate, Params(), block, ::chainActive.Tip(), false, false, false)};
+        assert(valid);
+    }
+}
+
+// ConnectBlock of a block with recoveries, each reverting alerts mined at
+// NUM_ALERT_HEIGHTS different heights, which are matched against the vatx
+// sections of the ancestor blocks.
+static void VaultConnectBlockRecoveries(benchmark::State& state)
+{
+    VaultChainSetup setup;
+    std::vector<std::vector<CTransactionRef>> vAlertsByHeight;
+    for (size_t h = 0; h < NUM_ALERT_HEIGHTS; ++h) {
+        vAlertsByHeight.push_back(setup.AddAlerts(NUM_RECOVERIES));
+        setup.MineBlock();
+    }
+    for (size_t r = 0; r < NUM_RECOVERIES; ++r) {
+        std::vector<CTransactionRef> vAlerts;
+        for (const std::vector<CTransactionRef>& alerts : vAlertsByHeight) {
+            vAlerts.push_back(alerts[r]);
+        }
+        setup.AddRecovery(vAlerts);
+    }
+    const CBlock block = BlockAssembler{Params()}.CreateNewBlock(setup.SCRIPT_PUB)->block;
+    assert(block.vtx.size() == NUM_RECOVERIES + 1);
+
+    while (state.KeepRunning()) {
+        LOCK(cs_main);
+        CValidationState cvstate;
+        bool valid{TestBlockValidity(cvstate, Params(), block, ::chainActive.Tip(), false, false, false)};
+        assert(valid);
+    }
+}
+
+// Assemble the block confirming the NUM_ALERTS alerts of its ancestor
+// (BlockAssembler::addTxsFromAlerts), including its validity check.
+static void VaultAssembleBlockConfirmAlerts(benchmark::State& state)
+{
+    VaultChainSetup setup;
+    setup.AddAlerts(NUM_ALERTS);
+    setup.MineBlock();
+    for (uint32_t i = 1; i < Params().GetConsensus().nAlertsInitializationWindow; ++i) {
+        setup.MineBlock();
+    }
+
+    while (state.KeepRunning()) {
+        const CBlock block = BlockAssembler{Params()}.CreateNewBlock(setup.SCRIPT_PUB)->block;
+        assert(block.vtx.size() == NUM_ALERTS + 1);
+    }
+}
+
+// DisconnectBlock of the tip mining NUM_ALERTS alerts in its vatx section,
+// restoring the alert inputs with ApplyTxAlertInUndo. Run through VerifyDB,
+// so reading the block and its undo data from disk is included.
+static void VaultDisconnectBlockAlerts(benchmark::State& state)
+{
+    VaultChainSetup setup;
+    setup.AddAlerts(NUM_ALERTS);
+    assert(setup.MineBlock()->vatx.size() == NUM_ALERTS);
+
+    while (state.KeepRunning()) {
+        bool verified{CVerifyDB().VerifyDB(Params(), pcoinsTip.get(), 3 /* nCheckLevel */, 1 /* nCheckDepth */)};
+        assert(verified);
+    }
+}
+
+BENCHMARK(VaultTxTypeCached, 500);
+BENCHMARK(VaultConnectBlockAlerts, 100);
+BENCHMARK(VaultConnectBlockRecoveries, 100);
+BENCHMARK(VaultAssembleBlockConfirmAlerts, 100);
+BENCHMARK(VaultDisconnectBlockAlerts, 50);
@@ -14,18 +14,41 @@
 #include <validation.h>
 #include <util/system.h>
 
+#include <map>
 #include <unordered_map>
 
-CBlockHeaderAndShortTxIDs::CBlockHeaderAndShortTxIDs(const CBlock& block, bool fUseWTXID) :
+CBlockHeaderAndShortTxIDs::CBlockHeaderAndShortTxIDs(const CBlock& block, bool fUseWTXID, const std::vector<CAlertTransactionRef>* ancestor_vatx) :
         nonce(GetRand(std::numeric_limits<uint64_t>::max())),
-        shorttxids(block.vtx.size() - 1), prefilledtxn(1), header(block) {
+        prefilledtxn(1), header(block) {
     FillShortTxIDSelector();
     //TODO: Use our mempool prior to block acceptance to predictively fill more than just the coinbase
     prefilledtxn[0] = {0, block.vtx[0]};
+
+    // Confirmed alerts which appear in the same order as in the ancestor vatx are derived,
+    // anything else (e.g. an alert placed out of order) falls back to a short id
+    std::map<uint256, size_t> ancestor_positions;
+    if (ancestor_vatx) {
+        for (size_t i = 0; i < ancestor_vatx->size(); i++)
+            ancestor_positions.emplace((*ancestor_vatx)[i]->GetWitnessHash(), i);
+        derivedmask.resize(ancestor_vatx->size());
+    }
+    size_t next_position = 0;
+
+    shorttxids.reserve(block.vtx.size() - 1);
     for (size_t i = 1; i < block.vtx.size(); i++) {
         const CTransaction& tx = *block.vtx[i];
-        shorttxids[i - 1] = GetShortID(fUseWTXID ? tx.GetWitnessHash() : tx.GetHash());
+        auto it = ancestor_positions.find(tx.GetWitnessHash());
+        if (it != ancestor_positions.end() && it->second >= next_position) {
+            derivedmask[it->second] = true;
+            derivedindexes.push_back(i);
+            derivedshorttxids.push_back(GetShortID(fUseWTXID ? tx.GetWitnessHash() : tx.GetHash()));
+            next_position = it->second + 1;
+            continue;
+        }
+        shorttxids.push_back(GetShortID(fUseWTXID ? tx.GetWitnessHash() : tx.GetHash()));
     }
+    if (derivedindexes.empty())
+        derivedmask.clear();
 }
 
 void CBlockHeaderAndShortTxIDs::FillShortTxIDSelector() const {
@@ -39,15 +62,40 @@ void CBlockHeaderAndShortTxIDs::FillShortTxIDSelector() const {
     shorttxidk1 = shorttxidhash.GetUint64(1);
 }
 
+std::vector<uint64_t> CBlockHeaderAndShortTxIDs::GetShortTxIDsWithDerived() const {
+    if (derivedshorttxids.size() != derivedindexes.size())
+        throw std::ios_base::failure("short ids of derived transactions are unknown");
+
+    std::vector<bool> prefilled(BlockTxCount());
+    int32_t lastprefilledindex = -1;
+    for (const auto& prefilledtx : prefilledtxn) {
+        lastprefilledindex += prefilledtx.index + 1;
+        prefilled[lastprefilledindex] = true;
+    }
+
+    std::vector<uint64_t> txids;
+    txids.reserve(shorttxids.size() + derivedshorttxids.size());
+    size_t short_offset = 0, derived_offset = 0;
+    for (size_t i = 0; i < prefilled.size(); i++) {
+        if (prefilled[i])
+            continue;
+        if (derived_offset < derivedindexes.size() && derivedindexes[derived_offset] == i)
+            txids.push_back(derivedshorttxids[derived_offset++]);
+        else
+            txids.push_back(shorttxids[short_offset++]);
+    }
+    return txids;
+}
+
 uint64_t CBlockHeaderAndShortTxIDs::GetShortID(const uint256& txhash) const {
     static_assert(SHORTTXIDS_LENGTH == 6, "shorttxids calculation assumes 6-byte shorttxids");
     return SipHashUint256(shorttxidk0, shorttxidk1, txhash) & 0xffffffffffffL;
 }
 
 ReadStatus PartiallyDownloadedBlock::InitData(const CBlockHeaderAndShortTxIDs& cmpctblock, const std::vector<std::pair<uint256, CTransactionRef>>& extra_txn) {
-    if (cmpctblock.header.IsNull() || (cmpctblock.shorttxids.empty() && cmpctblock.shortatxids.empty() && cmpctblock.prefilledtxn.empty() && cmpctblock.prefilledatxn.empty()))
+    if (cmpctblock.header.IsNull() || (cmpctblock.BlockTxCount() == 0 && cmpctblock.BlockAlertTxCount() == 0))
         return READ_STATUS_INVALID;
-    if (cmpctblock.shorttxids.size() + cmpctblock.prefilledtxn.size() + cmpctblock.shortatxids.size() + cmpctblock.prefilledatxn.size() > MAX_BLOCK_WEIGHT / MIN_SERIALIZABLE_TRANSACTION_WEIGHT)
+    if (cmpctblock.BlockTxCount() + cmpctblock.BlockAlertTxCount() > MAX_BLOCK_WEIGHT / MIN_SERIALIZABLE_TRANSACTION_WEIGHT)
         return READ_STATUS_INVALID;
 
     assert(header.IsNull() && txn_available.empty() && atxn_available.empty());
@@ -72,16 +120,22 @@ ReadStatus PartiallyDownloadedBlock::InitTxData(const CBlockHeaderAndShortTxIDs&
         lastprefilledindex += cmpctblock.prefilledtxn[i].index + 1; //index is a uint16_t, so can't overflow here
         if (lastprefilledindex > std::numeric_limits<uint16_t>::max())
             return READ_STATUS_INVALID;
-        if ((uint32_t)lastprefilledindex > cmpctblock.shorttxids.size() + i) {
+        if ((uint32_t)lastprefilledindex > cmpctblock.shorttxids.size() + cmpctblock.derivedindexes.size() + i) {
             // If we are inserting a tx at an index greater than our full list of shorttxids
-            // plus the number of prefilled txn we've inserted, then we have txn for which we
-            // have neither a prefilled txn or a shorttxid!
+            // and derived txn plus the number of prefilled txn we've inserted, then we have
+            // txn for which we have neither a prefilled txn, a derived txn or a shorttxid!
             return READ_STATUS_INVALID;
         }
         txn_available[lastprefilledindex] = cmpctblock.prefilledtxn[i].tx;
     }
     prefilled_count += cmpctblock.prefilledtxn.size();
 
+    if (!cmpctblock.derivedindexes.empty()) {
+        ReadStatus status = InitDerivedTxData(cmpctblock);
+        if (status != READ_STATUS_OK)
+            return status;
+    }
+
     // Calculate map of txids -> positions and check mempool to see what we have (or don't)
     // Because well-formed cmpctblock messages will have a (relatively) uniform distribution
     // of short IDs, any highly-uneven distribution of elements can be safely treated as a
@@ -176,6 +230,37 @@ ReadStatus PartiallyDownloadedBlock::InitTxData(const CBlockHeaderAndShortTxIDs&
     return READ_STATUS_OK;
 }
 
+ReadStatus PartiallyDownloadedBlock::InitDerivedTxData(const CBlockHeaderAndShortTxIDs& cmpctblock) {
+    LOCK(cs_main);
+    const CBlockIndex* pindexPrev = LookupBlockIndex(cmpctblock.header.hashPrevBlock);
+    if (!pindexPrev)
+        return READ_STATUS_FAILED;
+
+    const Consensus::Params& params = Params().GetConsensus();
+    if (pindexPrev->nHeight + 1 <= (int) params.nAlertsInitializationWindow)
+        return READ_STATUS_INVALID; // No alerts can be confirmed in this block
+
+    // Without the ancestor block we cannot rebuild the transactions, fall back to a full block
+    CAlertsWindowEntryRef ancestorAlerts = TryGetAncestorAlerts(pindexPrev, params);
+    if (!ancestorAlerts)
+        return READ_STATUS_FAILED;
+    if (ancestorAlerts->vatx.size() != cmpctblock.derivedmask.size())
+        return READ_STATUS_INVALID;
+
+    size_t derived_offset = 0;
+    for (size_t i = 0; i < cmpctblock.derivedmask.size(); i++) {
+        if (!cmpctblock.derivedmask[i])
+            continue;
+        uint16_t index = cmpctblock.derivedindexes[derived_offset++];
+        if (index >= txn_available.size() || txn_available[index])
+            return READ_STATUS_INVALID;
+        txn_available[index] = MakeTransactionRef(CTransaction(CMutableTransaction(*ancestorAlerts->vatx[i])));
+    }
+    derived_count += derived_offset;
+
+    return READ_STATUS_OK;
+}
+
 ReadStatus PartiallyDownloadedBlock::InitAlertTxData(const CBlockHeaderAndShortTxIDs& cmpctblock, const std::vector<std::pair<uint256, CTransactionRef>>& extra_txn) {
     atxn_available.resize(cmpctblock.BlockAlertTxCount());
 
@@ -349,7 +434,7 @@ ReadStatus PartiallyDownloadedBlock::FillBlock(CBlock& block, const std::vector<
         return READ_STATUS_CHECKBLOCK_FAILED;
     }
 
-    LogPrint(BCLog::CMPCTBLOCK, "Successfully reconstructed block %s with %lu txn prefilled, %lu txn from mempool (incl at least %lu from extra pool) and %lu txn requested\n", hash.ToString(), prefilled_count, mempool_count, extra_count, vtx_missing.size());
+    LogPrint(BCLog::CMPCTBLOCK, "Successfully reconstructed block %s with %lu txn prefilled, %lu txn derived from ancestor alerts, %lu txn from mempool (incl at least %lu from extra pool) and %lu txn requested\n", hash.ToString(), prefilled_count, derived_count, mempool_count, extra_count, vtx_missing.size());
     if (vtx_missing.size() < 5) {
         for (const auto& tx : vtx_missing) {
             LogPrint(BCLog::CMPCTBLOCK, "Reconstructed block %s required tx %s\n", hash.ToString(), tx->GetHash().ToString());
@@ -6,6 +6,7 @@
 #define BITCOIN_BLOCKENCODINGS_H
 
 #include <primitives/block.h>
+#include <version.h>
 
 #include <memory>
 
@@ -161,6 +162,8 @@ private:
     uint64_t nonce;
 
     void FillShortTxIDSelector() const;
+    // Short ids of all non-prefilled transactions, derived ones included
+    std::vector<uint64_t> GetShortTxIDsWithDerived() const;
 
     friend class PartiallyDownloadedBlock;
 
@@ -171,17 +174,27 @@ protected:
     std::vector<PrefilledTransaction<CTransactionRef>> prefilledtxn;
     std::vector<PrefilledTransaction<CAlertTransactionRef>> prefilledatxn;
 
+    // Confirmed alerts are copies of the alerts mined in the ancestor block
+    // nAlertsInitializationWindow blocks back, so they are sent as a bitmap over
+    // that block's vatx plus their (increasing) indexes in vtx. Peers older than
+    // DERIVED_ALERTS_VERSION get short ids for them instead.
+    std::vector<bool> derivedmask;
+    std::vector<uint16_t> derivedindexes;
+    // Short ids of the derived transactions, only known to the sender
+    std::vector<uint64_t> derivedshorttxids;
+
 public:
     CBlockHeader header;
 
     // Dummy for deserialization
     CBlockHeaderAndShortTxIDs() {}
 
-    CBlockHeaderAndShortTxIDs(const CBlock& block, bool fUseWTXID);
+    // ancestor_vatx is the vatx of the block whose alerts are confirmed in block, if any
+    CBlockHeaderAndShortTxIDs(const CBlock& block, bool fUseWTXID, const std::vector<CAlertTransactionRef>* ancestor_vatx = nullptr);
 
     uint64_t GetShortID(const uint256& txhash) const;
 
-    size_t BlockTxCount() const { return shorttxids.size() + prefilledtxn.size(); }
+    size_t BlockTxCount() const { return shorttxids.size() + prefilledtxn.size() + derivedindexes.size(); }
 
     size_t BlockAlertTxCount() const { return shortatxids.size() + prefilledatxn.size(); }
 
@@ -217,18 +230,60 @@ public:
             }
         };
 
-        readWiteShortTxIds(shorttxids);
+        const bool fDerivedAlerts = s.GetVersion() >= DERIVED_ALERTS_VERSION;
+        if (!ser_action.ForRead() && !fDerivedAlerts && !derivedindexes.empty()) {
+            std::vector<uint64_t> txids = GetShortTxIDsWithDerived();
+            readWiteShortTxIds(txids);
+        } else {
+            readWiteShortTxIds(shorttxids);
+        }
         READWRITE(prefilledtxn);
 
-        if (BlockTxCount() > std::numeric_limits<uint16_t>::max())
-            throw std::ios_base::failure("indexes overflowed 16 bits");
-
         readWiteShortTxIds(shortatxids);
         READWRITE(prefilledatxn);
 
         if (BlockAlertTxCount() > std::numeric_limits<uint16_t>::max())
             throw std::ios_base::failure("alert indexes overflowed 16 bits");
 
+        if (fDerivedAlerts) {
+            uint64_t derivedmask_size = (uint64_t)derivedmask.size();
+            READWRITE(COMPACTSIZE(derivedmask_size));
+            if (derivedmask_size > std::numeric_limits<uint16_t>::max())
+                throw std::ios_base::failure("derived alerts mask overflowed 16 bits");
+
+            std::vector<unsigned char> bits((derivedmask_size + 7) / 8);
+            if (!ser_action.ForRead()) {
+                for (size_t i = 0; i < derivedmask.size(); i++)
+                    bits[i / 8] |= (derivedmask[i] ? 1 : 0) << (i % 8);
+            }
+            for (unsigned char& byte : bits)
+                READWRITE(byte);
+
+            if (ser_action.ForRead()) {
+                derivedmask.resize(derivedmask_size);
+                size_t derived_count = 0;
+                for (size_t i = 0; i < derivedmask.size(); i++) {
+                    derivedmask[i] = (bits[i / 8] >> (i % 8)) & 1;
+                    derived_count += derivedmask[i];
+                }
+                derivedindexes.resize(derived_count);
+            }
+
+            // vtx indexes of the derived transactions, differentially encoded
+            int32_t offset = 0;
+            for (size_t i = 0; i < derivedindexes.size(); i++) {
+                uint64_t index = derivedindexes[i] - offset;
+                READWRITE(COMPACTSIZE(index));
+                if (index + offset > std::numeric_limits<uint16_t>::max())
+                    throw std::ios_base::failure("derived indexes overflowed 16 bits");
+                derivedindexes[i] = index + offset;
+                offset = int32_t(derivedindexes[i]) + 1;
+            }
+        }
+
+        if (BlockTxCount() > std::numeric_limits<uint16_t>::max())
+            throw std::ios_base::failure("indexes overflowed 16 bits");
+
         if (ser_action.ForRead())
             FillShortTxIDSelector();
     }
@@ -238,7 +293,7 @@ class PartiallyDownloadedBlock {
 protected:
     std::vector<CTransactionRef> txn_available;
     std::vector<CAlertTransactionRef> atxn_available;
-    size_t prefilled_count = 0, mempool_count = 0, extra_count = 0;
+    size_t prefilled_count = 0, mempool_count = 0, extra_count = 0, derived_count = 0;
     CTxMemPool* pool;
 public:
     CBlockHeader header;
@@ -251,6 +306,7 @@ public:
     ReadStatus FillBlock(CBlock& block, const std::vector<CTransactionRef>& vtx_missing, const std::vector<CAlertTransactionRef>& vatx_missing);
 private:
     ReadStatus InitTxData(const CBlockHeaderAndShortTxIDs& cmpctblock, const std::vector<std::pair<uint256, CTransactionRef>>& extra_txn);
+    ReadStatus InitDerivedTxData(const CBlockHeaderAndShortTxIDs& cmpctblock);
     ReadStatus InitAlertTxData(const CBlockHeaderAndShortTxIDs& cmpctblock, const std::vector<std::pair<uint256, CTransactionRef>>& extra_txn);
 };
 
@@ -6,6 +6,7 @@
 #include <chain.h>
 
 #include <chainparams.h>
+#include <txdb.h>
 #include <validation.h>
 
 
@@ -87,24 +88,35 @@ int static inline GetSkipHeight(int height) {
 /* Moved here from the header, because we need auxpow and the logic
  * becomes more involved. */
 CBlockHeader CBlockIndex::GetBlockHeader() const {
-	CBlock block;
+	CBlockHeader block;
 	block.nVersion       = nVersion;
-
-	/* The CBlockIndex object's block header is missing the auxpow.
-	 * So if this is an auxpow block, read it from disk instead. We only
-	 * have to read the actual *header*, not the full block. */
-	if (block.IsAuxPow()) {
-		ReadBlockFromDisk(block, this, Params().GetConsensus());
-		return block.GetBlockHeader();
-	}
-
 	if (pprev)
 		block.hashPrevBlock = pprev->GetBlockHash();
 	block.hashMerkleRoot = hashMerkleRoot;
 	block.nTime          = nTime;
 	block.nBits          = nBits;
 	block.nNonce         = nNonce;
-	return block.GetBlockHeader();
+	if (phashBlock)
+		block.CacheHash(*phashBlock);
+
+	/* The CBlockIndex object's block header is missing the auxpow.
+	 * So if this is an auxpow block, read it from the auxpow header store.
+	 * Blocks accepted before the store existed are read from disk once
+	 * and added to it. */
+	if (block.IsAuxPow()) {
+		const uint256 hash = GetBlockHash();
+		auto auxHeader = std::make_shared<CAuxBlockHeader>();
+		if (pblocktree->ReadAuxBlockHeader(hash, *auxHeader)) {
+			block.auxHeader = std::move(auxHeader);
+			return block;
+		}
+		CBlock fullBlock;
+		if (ReadBlockFromDisk(fullBlock, this, Params().GetConsensus()) && fullBlock.auxHeader) {
+			pblocktree->WriteAuxBlockHeader(hash, *fullBlock.auxHeader);
+			block.auxHeader = fullBlock.auxHeader;
+		}
+	}
+	return block;
 }
 
 const CBlockIndex* CBlockIndex::GetAncestor(int height) const
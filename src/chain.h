@@ -234,6 +234,15 @@ public:
     //! (memory only) Maximum nTime in the chain up to and including this block.
     unsigned int nTimeMax;
 
+    //! (memory only) Rolling LWMA sums of the difficulty window ending at this block, see
+    //! LwmaCalculateNextWorkRequired. Filled lazily under cs_main, nLwmaDisorder is -1 until then.
+    //! Sum of target / N / k over the window
+    mutable arith_uint256 nLwmaTargetSum;
+    //! Sum of the timestamps of the N blocks before this one
+    mutable int64_t nLwmaTimeSum;
+    //! Number of blocks in the window whose timestamp is not after their parent's
+    mutable int32_t nLwmaDisorder;
+
     void SetNull()
     {
         phashBlock = nullptr;
@@ -249,6 +258,9 @@ public:
         nStatus = 0;
         nSequenceId = 0;
         nTimeMax = 0;
+        nLwmaTargetSum = arith_uint256();
+        nLwmaTimeSum = 0;
+        nLwmaDisorder = -1;
 
         nVersion       = 0;
         hashMerkleRoot = uint256();
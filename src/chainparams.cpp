@@ -7,11 +7,13 @@
 
 #include <chainparamsseeds.h>
 #include <consensus/merkle.h>
+#include <policy/ddms.h>
 #include <tinyformat.h>
 #include <util/system.h>
 #include <util/strencodings.h>
 #include <versionbitsinfo.h>
 
+#include <algorithm>
 #include <assert.h>
 
 #include <boost/algorithm/string/classification.hpp>
@@ -56,6 +58,17 @@ static CBlock CreateGenesisBlock(uint32_t nTime, uint32_t nNonce, uint32_t nBits
     return CreateGenesisBlock(pszTimestamp, genesisOutputScript, nTime, nNonce, nBits, nVersion, genesisReward);
 }
 
+/** The DDMS allow-list of policy/ddms.h as sorted key hashes */
+static std::vector<uint160> DDMSAllowedKeyIDs()
+{
+    std::vector<uint160> vKeyIDs;
+    for (const auto& script : ddmsAllowedScriptsRaw) {
+        vKeyIDs.emplace_back(std::vector<unsigned char>(script + DDMS_KEYID_OFFSET, script + DDMS_KEYID_OFFSET + 20));
+    }
+    std::sort(vKeyIDs.begin(), vKeyIDs.end());
+    return vKeyIDs;
+}
+
 /**
  * Main network
  */
@@ -73,6 +86,7 @@ public:
         consensus.SegwitHeight = 1;
         consensus.AlertsHeight = 58420; // Not yet enabled
         consensus.DDMSHeight = 29430;
+        consensus.vDDMSAllowedKeyIDs = DDMSAllowedKeyIDs();
         consensus.powLimit = uint256S("00000000ffffffffffffffffffffffffffffffffffffffffffffffffffffffff");
         consensus.nPowTargetTimespan = 14 * 24 * 60 * 60; // two weeks
         consensus.nPowTargetSpacing = 10 * 60; // 10 minutes (block time like Bitcoin)
@@ -316,6 +330,7 @@ public:
         m_assumed_chain_state_size = 0;
 
         UpdateVersionBitsParametersFromArgs(args);
+        UpdateDDMSParametersFromArgs(args);
 
         genesis = CreateGenesisBlock(1296688602, 1, 0x207fffff, 1, 50 * COIN);
         consensus.hashGenesisBlock = genesis.GetHash();
@@ -362,8 +377,29 @@ public:
         consensus.vDeployments[d].nTimeout = nTimeout;
     }
     void UpdateVersionBitsParametersFromArgs(const ArgsManager& args);
+    void UpdateDDMSParametersFromArgs(const ArgsManager& args);
 };
 
+void CRegTestParams::UpdateDDMSParametersFromArgs(const ArgsManager& args)
+{
+    if (args.IsArgSet("-ddmsheight")) {
+        int64_t nHeight;
+        if (!ParseInt64(args.GetArg("-ddmsheight", ""), &nHeight) || nHeight < 0 || nHeight > std::numeric_limits<int>::max()) {
+            throw std::runtime_error(strprintf("Invalid DDMS height (%s)", args.GetArg("-ddmsheight", "")));
+        }
+        consensus.DDMSHeight = static_cast<int>(nHeight);
+        LogPrintf("Setting DDMS activation height to %d\n", consensus.DDMSHeight);
+    }
+
+    for (const std::string& strKeyID : args.GetArgs("-ddmsallowedkeyid")) {
+        if (strKeyID.size() != 40 || !IsHex(strKeyID)) {
+            throw std::runtime_error(strprintf("Invalid DDMS key hash (%s)", strKeyID));
+        }
+        consensus.vDDMSAllowedKeyIDs.emplace_back(ParseHex(strKeyID));
+    }
+    std::sort(consensus.vDDMSAllowedKeyIDs.begin(), consensus.vDDMSAllowedKeyIDs.end());
+}
+
 void CRegTestParams::UpdateVersionBitsParametersFromArgs(const ArgsManager& args)
 {
     if (!args.IsArgSet("-vbparams")) return;
@@ -20,6 +20,8 @@ void SetupChainParamsBaseOptions()
     gArgs.AddArg("-regtest", "Enter regression test mode, which uses a special chain in which blocks can be solved instantly. "
                                    "This is intended for regression testing tools and app development.", true, OptionsCategory::CHAINPARAMS);
     gArgs.AddArg("-testnet", "Use the test chain", false, OptionsCategory::CHAINPARAMS);
+    gArgs.AddArg("-ddmsheight=<n>", "Use given block height for the DDMS activation (regtest-only)", true, OptionsCategory::CHAINPARAMS);
+    gArgs.AddArg("-ddmsallowedkeyid=<hex>", "Allow coinbase outputs to the P2PKH key hash in hex once DDMS is active. Can be specified multiple times (regtest-only)", true, OptionsCategory::CHAINPARAMS);
     gArgs.AddArg("-vbparams=deployment:start:end", "Use given start/end times for specified version bits deployment (regtest-only)", true, OptionsCategory::CHAINPARAMS);
 }
 
@@ -25,7 +25,7 @@
  * Serialized format:
  * - VARINT((coinbase ? 1 : 0) | (height << 1))
  * - the non-spent CTxOut (via CTxOutCompressor)
- * - height > alertsHeight ? confirmed : NOP
+ * - in the chainstate database only, if height > alertsHeight: VARINT(spent height)
  */
 class Coin
 {
@@ -39,21 +39,45 @@ public:
     //! at which height this containing transaction was included in the active block chain
     uint32_t nHeight : 31;
 
-    //! at which height output was and whether is spent
-    uint32_t nSpentHeight;
+    //! at which height output was spent by an alert, 0 if it is not
+    uint32_t nSpentHeight : 30;
 
-    // memory only
-    uint32_t fAlertsHeight;
+private:
+    //! The spare bits of the spent height word hold the flags of the
+    //! CCoinsCacheEntry caching this coin, so that the entry needs no byte of
+    //! its own. They belong to the entry: copying a Coin leaves them out.
+    uint32_t nCacheFlags : 2;
+
+    friend struct CCoinsCacheEntry;
 
+public:
     //! construct a Coin from a CTxOut and height/coinbase/confirmation information.
-    Coin(CTxOut&& outIn, int nHeightIn, bool fCoinBaseIn, uint32_t nSpentHeightIn = 0, uint32_t fAlertsHeightIn = 0) : out(std::move(outIn)), fCoinBase(fCoinBaseIn), nHeight(nHeightIn), nSpentHeight(nSpentHeightIn), fAlertsHeight(fAlertsHeightIn) {}
-    Coin(const CTxOut& outIn, int nHeightIn, bool fCoinBaseIn, uint32_t nSpentHeightIn = 0, uint32_t fAlertsHeightIn = 0) : out(outIn), fCoinBase(fCoinBaseIn), nHeight(nHeightIn), nSpentHeight(nSpentHeightIn), fAlertsHeight(fAlertsHeightIn) {}
+    Coin(CTxOut&& outIn, int nHeightIn, bool fCoinBaseIn, uint32_t nSpentHeightIn = 0) : out(std::move(outIn)), fCoinBase(fCoinBaseIn), nHeight(nHeightIn), nSpentHeight(nSpentHeightIn), nCacheFlags(0) {}
+    Coin(const CTxOut& outIn, int nHeightIn, bool fCoinBaseIn, uint32_t nSpentHeightIn = 0) : out(outIn), fCoinBase(fCoinBaseIn), nHeight(nHeightIn), nSpentHeight(nSpentHeightIn), nCacheFlags(0) {}
+
+    Coin(const Coin& other) : out(other.out), fCoinBase(other.fCoinBase), nHeight(other.nHeight), nSpentHeight(other.nSpentHeight), nCacheFlags(0) {}
+    Coin(Coin&& other) : out(std::move(other.out)), fCoinBase(other.fCoinBase), nHeight(other.nHeight), nSpentHeight(other.nSpentHeight), nCacheFlags(0) {}
+
+    Coin& operator=(const Coin& other) {
+        out = other.out;
+        fCoinBase = other.fCoinBase;
+        nHeight = other.nHeight;
+        nSpentHeight = other.nSpentHeight;
+        return *this;
+    }
+
+    Coin& operator=(Coin&& other) {
+        out = std::move(other.out);
+        fCoinBase = other.fCoinBase;
+        nHeight = other.nHeight;
+        nSpentHeight = other.nSpentHeight;
+        return *this;
+    }
 
     void Clear() {
         out.SetNull();
         fCoinBase = false;
         nHeight = 0;
-        fAlertsHeight = 0;
         nSpentHeight = 0;
     }
 
@@ -62,37 +86,57 @@ public:
     }
 
     //! empty constructor
-    Coin() : fCoinBase(false), nHeight(0), nSpentHeight(0), fAlertsHeight(0) { }
+    Coin() : fCoinBase(false), nHeight(0), nSpentHeight(0), nCacheFlags(0) { }
 
     bool IsCoinBase() const {
         return fCoinBase;
     }
 
+    /**
+     * Whether the spent height is serialized, i.e. the coin was created after
+     * nAlertsHeight of the chain it is stored for (0 if alerts are disabled).
+     */
+    bool HasSpentHeight(uint32_t nAlertsHeight) const {
+        return nAlertsHeight && nHeight > nAlertsHeight;
+    }
+
     template<typename Stream>
-    void Serialize(Stream &s) const {
+    void Serialize(Stream &s, uint32_t nAlertsHeight) const {
         assert(!IsConfirmed());
         uint32_t code = nHeight * 2 + fCoinBase;
         ::Serialize(s, VARINT(code));
         ::Serialize(s, CTxOutCompressor(REF(out)));
-        // TODO-fork: Use AreAlertsEnable function
-        if (fAlertsHeight && nHeight > fAlertsHeight) {
-            ::Serialize(s, VARINT(nSpentHeight));
+        if (HasSpentHeight(nAlertsHeight)) {
+            uint32_t spentHeight = nSpentHeight;
+            ::Serialize(s, VARINT(spentHeight));
         }
     }
 
     template<typename Stream>
-    void Unserialize(Stream &s) {
+    void Unserialize(Stream &s, uint32_t nAlertsHeight) {
         uint32_t code = 0;
         ::Unserialize(s, VARINT(code));
         nHeight = code >> 1;
         fCoinBase = code & 1;
         ::Unserialize(s, CTxOutCompressor(out));
-        // TODO-fork: Use AreAlertsEnable function
-        if (fAlertsHeight && nHeight > fAlertsHeight) {
-            ::Unserialize(s, VARINT(nSpentHeight));
+        nSpentHeight = 0;
+        if (HasSpentHeight(nAlertsHeight)) {
+            uint32_t spentHeight = 0;
+            ::Unserialize(s, VARINT(spentHeight));
+            nSpentHeight = spentHeight;
         }
     }
 
+    template<typename Stream>
+    void Serialize(Stream &s) const {
+        Serialize(s, 0);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream &s) {
+        Unserialize(s, 0);
+    }
+
     bool IsConfirmed() const {
         return out.IsNull();
     }
@@ -106,6 +150,30 @@ public:
     }
 };
 
+/**
+ * Serialization wrapper for a Coin in the chainstate database, which stores
+ * the spent height of coins created after the alerts activation height.
+ */
+template<typename CoinType>
+class CoinDBSerializer
+{
+    CoinType& coin;
+    const uint32_t nAlertsHeight;
+
+public:
+    CoinDBSerializer(CoinType& coinIn, uint32_t nAlertsHeightIn) : coin(coinIn), nAlertsHeight(nAlertsHeightIn) {}
+
+    template<typename Stream>
+    void Serialize(Stream& s) const {
+        coin.Serialize(s, nAlertsHeight);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s) {
+        coin.Unserialize(s, nAlertsHeight);
+    }
+};
+
 class SaltedOutpointHasher
 {
 private:
@@ -127,8 +195,7 @@ public:
 
 struct CCoinsCacheEntry
 {
-    Coin coin; // The actual cached data.
-    unsigned char flags;
+    Coin coin; // The actual cached data, which also stores the flags.
 
     enum Flags {
         DIRTY = (1 << 0), // This cache entry is potentially different from the version in the parent view.
@@ -140,8 +207,27 @@ struct CCoinsCacheEntry
          */
     };
 
-    CCoinsCacheEntry() : flags(0) {}
-    explicit CCoinsCacheEntry(Coin&& coin_) : coin(std::move(coin_)), flags(0) {}
+    CCoinsCacheEntry() {}
+    explicit CCoinsCacheEntry(Coin&& coin_) : coin(std::move(coin_)) {}
+
+    // Coin leaves the flags out when it is copied, so the entry copies them itself
+    CCoinsCacheEntry(const CCoinsCacheEntry& other) : coin(other.coin) { SetFlags(other.GetFlags()); }
+    CCoinsCacheEntry(CCoinsCacheEntry&& other) : coin(std::move(other.coin)) { SetFlags(other.GetFlags()); }
+
+    CCoinsCacheEntry& operator=(const CCoinsCacheEntry& other) {
+        coin = other.coin;
+        SetFlags(other.GetFlags());
+        return *this;
+    }
+
+    CCoinsCacheEntry& operator=(CCoinsCacheEntry&& other) {
+        coin = std::move(other.coin);
+        SetFlags(other.GetFlags());
+        return *this;
+    }
+
+    unsigned char GetFlags() const { return coin.nCacheFlags; }
+    void SetFlags(unsigned char flags) { coin.nCacheFlags = flags; }
 };
 
 typedef std::unordered_map<COutPoint, CCoinsCacheEntry, SaltedOutpointHasher> CCoinsMap;
@@ -10,6 +10,7 @@
 #include <limits>
 #include <map>
 #include <string>
+#include <vector>
 
 namespace Consensus {
 
@@ -68,6 +69,8 @@ struct Params {
     int AlertsHeight;
     /** Block height at which DDMS becomes active */
     int DDMSHeight;
+    /** Sorted key hashes of the P2PKH outputs a coinbase may pay to once DDMS is active */
+    std::vector<uint160> vDDMSAllowedKeyIDs;
     /**
      * Minimum blocks including miner confirmation of the total of 2016 blocks in a retargeting period,
      * (nPowTargetTimespan / nPowTargetSpacing) which is also used for BIP9 deployments.
@@ -0,0 +1,72 @@
+// Copyright (c) 2020 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/alertindex.h>
+#include <util/system.h>
+
+constexpr char DB_ALERT_SPEND = 's';
+
+std::unique_ptr<AlertIndex> g_alertindex;
+
+/**
+ * Access to the alertindex database (indexes/alertindex/)
+ */
+class AlertIndex::DB : public BaseIndex::DB
+{
+public:
+    explicit DB(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    /// Read the alert which spent the given outpoint. Returns false if the
+    /// outpoint is not indexed.
+    bool ReadAlertSpend(const COutPoint& outpoint, CAlertSpend& spend) const;
+
+    /// Write a batch of alert spends to the DB.
+    bool WriteAlertSpends(const std::vector<std::pair<COutPoint, CAlertSpend>>& v_spends);
+};
+
+AlertIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe) :
+    BaseIndex::DB(GetDataDir() / "indexes" / "alertindex", n_cache_size, f_memory, f_wipe)
+{}
+
+bool AlertIndex::DB::ReadAlertSpend(const COutPoint& outpoint, CAlertSpend& spend) const
+{
+    return Read(std::make_pair(DB_ALERT_SPEND, outpoint), spend);
+}
+
+bool AlertIndex::DB::WriteAlertSpends(const std::vector<std::pair<COutPoint, CAlertSpend>>& v_spends)
+{
+    CDBBatch batch(*this);
+    for (const auto& tuple : v_spends) {
+        batch.Write(std::make_pair(DB_ALERT_SPEND, tuple.first), tuple.second);
+    }
+    return WriteBatch(batch);
+}
+
+AlertIndex::AlertIndex(size_t n_cache_size, bool f_memory, bool f_wipe)
+    : m_db(MakeUnique<AlertIndex::DB>(n_cache_size, f_memory, f_wipe))
+{}
+
+AlertIndex::~AlertIndex() {}
+
+bool AlertIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex)
+{
+    if (block.vatx.empty()) return true;
+
+    std::vector<std::pair<COutPoint, CAlertSpend>> vSpends;
+    for (const auto& atx : block.vatx) {
+        const CAlertSpend spend(atx->GetHash(), pindex->GetBlockHash(), pindex->nHeight, atx->vin.size());
+        for (const auto& txin : atx->vin) {
+            vSpends.emplace_back(txin.prevout, spend);
+        }
+    }
+
+    return m_db->WriteAlertSpends(vSpends);
+}
+
+BaseIndex::DB& AlertIndex::GetDB() const { return *m_db; }
+
+bool AlertIndex::FindAlertSpend(const COutPoint& outpoint, CAlertSpend& spend) const
+{
+    return m_db->ReadAlertSpend(outpoint, spend);
+}
@@ -0,0 +1,86 @@
+// Copyright (c) 2020 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_ALERTINDEX_H
+#define BITCOIN_INDEX_ALERTINDEX_H
+
+#include <chain.h>
+#include <index/base.h>
+#include <serialize.h>
+
+namespace alertindex_tests {
+class AlertIndexForTest;
+}
+
+/** Alert which spent an outpoint, as recorded by AlertIndex. */
+struct CAlertSpend
+{
+    //! Hash of the alert transaction
+    uint256 alertTxid;
+    //! Hash and height of the block whose vatx contains the alert
+    uint256 hashBlock;
+    int nHeight;
+    //! Number of inputs of the alert
+    uint32_t nInputs;
+
+    CAlertSpend() : nHeight(0), nInputs(0) {}
+    CAlertSpend(const uint256& alertTxidIn, const uint256& hashBlockIn, int nHeightIn, uint32_t nInputsIn) :
+        alertTxid(alertTxidIn), hashBlock(hashBlockIn), nHeight(nHeightIn), nInputs(nInputsIn) {}
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(alertTxid);
+        READWRITE(hashBlock);
+        READWRITE(VARINT(nHeight, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT(nInputs));
+    }
+};
+
+/**
+ * AlertIndex maps every outpoint spent by an alert mined in a block's vatx to
+ * the alert and the block, so that recoveries can be matched with the alerts
+ * they revert with a single lookup per input instead of reading the ancestor
+ * blocks. The index is written to a LevelDB database.
+ *
+ * Entries of blocks which have been reorganized out are not erased. Callers
+ * must check that CAlertSpend::hashBlock is part of the chain they work on.
+ */
+class AlertIndex final : public BaseIndex
+{
+protected:
+    class DB;
+
+private:
+    const std::unique_ptr<DB> m_db;
+
+protected:
+    bool WriteBlock(const CBlock& block, const CBlockIndex* pindex) override;
+
+    BaseIndex::DB& GetDB() const override;
+
+    const char* GetName() const override { return "alertindex"; }
+
+public:
+    /// Constructs the index, which becomes available to be queried.
+    explicit AlertIndex(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    // Destructor is declared because this class contains a unique_ptr to an incomplete type.
+    virtual ~AlertIndex() override;
+
+    /// Look up the alert which spent an outpoint.
+    ///
+    /// @param[in]   outpoint  The outpoint spent by the alert.
+    /// @param[out]  spend  The alert and the block it was mined in.
+    /// @return  true if an alert spending the outpoint is found, false otherwise
+    bool FindAlertSpend(const COutPoint& outpoint, CAlertSpend& spend) const;
+
+    friend class alertindex_tests::AlertIndexForTest;
+};
+
+/// The global alert index, used in recovery validation. May be null.
+extern std::unique_ptr<AlertIndex> g_alertindex;
+
+#endif // BITCOIN_INDEX_ALERTINDEX_H
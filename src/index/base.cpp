@@ -191,6 +191,36 @@ void BaseIndex::BlockConnected(const std::shared_ptr<const CBlock>& block, const
     }
 }
 
+void BaseIndex::BlockDisconnected(const std::shared_ptr<const CBlock>& block)
+{
+    if (!m_synced) {
+        return;
+    }
+
+    const CBlockIndex* pindex;
+    {
+        LOCK(cs_main);
+        pindex = LookupBlockIndex(block->GetHash());
+    }
+
+    // Blocks are disconnected from the tip, so the block must be the best block of the index.
+    // See BlockConnected for why this may not be the case right after the sync thread caught up.
+    const CBlockIndex* best_block_index = m_best_block_index.load();
+    if (!pindex || pindex != best_block_index) {
+        LogPrintf("%s: WARNING: Block %s is not the best block of the index; not updating index\n",
+                  __func__, block->GetHash().ToString());
+        return;
+    }
+
+    if (DisconnectBlock(*block, pindex)) {
+        m_best_block_index = pindex->pprev;
+    } else {
+        FatalError("%s: Failed to disconnect block %s from index",
+                   __func__, pindex->GetBlockHash().ToString());
+        return;
+    }
+}
+
 void BaseIndex::ChainStateFlushed(const CBlockLocator& locator)
 {
     if (!m_synced) {
@@ -61,6 +61,8 @@ protected:
     void BlockConnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex,
                         const std::vector<CTransactionRef>& txn_conflicted) override;
 
+    void BlockDisconnected(const std::shared_ptr<const CBlock>& block) override;
+
     void ChainStateFlushed(const CBlockLocator& locator) override;
 
     /// Initialize internal state from the database and block index.
@@ -69,8 +71,16 @@ protected:
     /// Write update index entries for a newly connected block.
     virtual bool WriteBlock(const CBlock& block, const CBlockIndex* pindex) { return true; }
 
+    /// Revert index entries of the best block, which has been disconnected from the
+    /// active chain. Only called once the index is in sync; entries written by the
+    /// sync thread for blocks of a stale branch are overwritten instead.
+    virtual bool DisconnectBlock(const CBlock& block, const CBlockIndex* pindex) { return true; }
+
     virtual DB& GetDB() const = 0;
 
+    /// Get the last block the index has processed, null before the first one.
+    const CBlockIndex* GetBestBlockIndex() const { return m_best_block_index.load(); }
+
     /// Get the name of the index for display in logs.
     virtual const char* GetName() const = 0;
 
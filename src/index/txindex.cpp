@@ -2,6 +2,7 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <chainparams.h>
 #include <index/txindex.h>
 #include <shutdown.h>
 #include <ui_interface.h>
@@ -14,6 +15,9 @@ constexpr char DB_BEST_BLOCK = 'B';
 constexpr char DB_TXINDEX = 't';
 constexpr char DB_TXALERTINDEX = 'a';
 constexpr char DB_TXINDEX_BLOCK = 'T';
+constexpr char DB_ALERT_STATUS = 's';
+constexpr char DB_ALERT_OUTPOINT = 'o';
+constexpr char DB_BLOCK_ALERTS = 'v';
 
 std::unique_ptr<TxIndex> g_txindex;
 
@@ -70,6 +74,29 @@ public:
     /// Write a batch of transaction alerts positions to the DB.
     bool WriteTxAlerts(const std::vector<std::pair<uint256, CDiskTxPos>>& v_pos);
 
+    /// Read the status of the alert with the given hash. Returns false if the alert is not indexed.
+    bool ReadAlertStatus(const uint256& alert_hash, CAlertStatus& status) const;
+
+    /// Read the hash of the alert which spent the given outpoint. Returns false if the outpoint
+    /// has not been spent by an indexed alert.
+    bool ReadOutpointAlert(const COutPoint& outpoint, uint256& alert_hash) const;
+
+    /// Read the hashes of the alerts mined in the vatx of the given block. Returns false if the
+    /// block has no indexed alerts.
+    bool ReadBlockAlerts(const uint256& block_hash, std::vector<uint256>& v_alerts) const;
+
+    /// Write the alerts mined in a block, the outpoints they spent and a batch of alert statuses
+    /// to the DB.
+    bool WriteAlerts(const uint256& block_hash, const std::vector<uint256>& v_alerts,
+                     const std::vector<std::pair<COutPoint, uint256>>& v_outpoints,
+                     const std::vector<std::pair<uint256, CAlertStatus>>& v_status);
+
+    /// Erase the alerts mined in a block and the outpoints they spent, and write a batch of
+    /// alert statuses to the DB.
+    bool EraseAlerts(const uint256& block_hash, const std::vector<uint256>& v_alerts,
+                     const std::vector<COutPoint>& v_outpoints,
+                     const std::vector<std::pair<uint256, CAlertStatus>>& v_status);
+
     /// Migrate txindex data from the block tree DB, where it may be for older nodes that have not
     /// been upgraded yet to the new database.
     bool MigrateData(CBlockTreeDB& block_tree_db, const CBlockLocator& best_locator);
@@ -107,6 +134,56 @@ bool TxIndex::DB::WriteTxAlerts(const std::vector<std::pair<uint256, CDiskTxPos>
     return WriteBatch(batch);
 }
 
+bool TxIndex::DB::ReadAlertStatus(const uint256& alert_hash, CAlertStatus& status) const
+{
+    return Read(std::make_pair(DB_ALERT_STATUS, alert_hash), status);
+}
+
+bool TxIndex::DB::ReadOutpointAlert(const COutPoint& outpoint, uint256& alert_hash) const
+{
+    return Read(std::make_pair(DB_ALERT_OUTPOINT, outpoint), alert_hash);
+}
+
+bool TxIndex::DB::ReadBlockAlerts(const uint256& block_hash, std::vector<uint256>& v_alerts) const
+{
+    return Read(std::make_pair(DB_BLOCK_ALERTS, block_hash), v_alerts);
+}
+
+bool TxIndex::DB::WriteAlerts(const uint256& block_hash, const std::vector<uint256>& v_alerts,
+                              const std::vector<std::pair<COutPoint, uint256>>& v_outpoints,
+                              const std::vector<std::pair<uint256, CAlertStatus>>& v_status)
+{
+    CDBBatch batch(*this);
+    if (!v_alerts.empty()) {
+        batch.Write(std::make_pair(DB_BLOCK_ALERTS, block_hash), v_alerts);
+    }
+    for (const auto& tuple : v_outpoints) {
+        batch.Write(std::make_pair(DB_ALERT_OUTPOINT, tuple.first), tuple.second);
+    }
+    for (const auto& tuple : v_status) {
+        batch.Write(std::make_pair(DB_ALERT_STATUS, tuple.first), tuple.second);
+    }
+    return WriteBatch(batch);
+}
+
+bool TxIndex::DB::EraseAlerts(const uint256& block_hash, const std::vector<uint256>& v_alerts,
+                              const std::vector<COutPoint>& v_outpoints,
+                              const std::vector<std::pair<uint256, CAlertStatus>>& v_status)
+{
+    CDBBatch batch(*this);
+    batch.Erase(std::make_pair(DB_BLOCK_ALERTS, block_hash));
+    for (const COutPoint& outpoint : v_outpoints) {
+        batch.Erase(std::make_pair(DB_ALERT_OUTPOINT, outpoint));
+    }
+    for (const auto& tuple : v_status) {
+        batch.Write(std::make_pair(DB_ALERT_STATUS, tuple.first), tuple.second);
+    }
+    for (const uint256& alert_hash : v_alerts) {
+        batch.Erase(std::make_pair(DB_ALERT_STATUS, alert_hash));
+    }
+    return WriteBatch(batch);
+}
+
 /*
  * Safely persist a transfer of data from the old txindex database to the new one, and compact the
  * range of keys updated. This is used internally by MigrateData.
@@ -270,6 +347,16 @@ bool TxIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex)
     // Exclude genesis block transaction because outputs are not spendable.
     if (pindex->nHeight == 0) return true;
 
+    // Offsets are those of the canonical serialization, which blocks stored with -dedupalerts do not have on disk.
+    // The block file is only checked if any block was ever stored that way.
+    bool fAlertRefs = false;
+    if (fHaveAlertRefs && !ReadBlockAlertRefsFlag(pindex->GetBlockPos(), fAlertRefs))
+        return false;
+    if (fAlertRefs) {
+        return error("%s: block %s was stored with -dedupalerts, which is incompatible with -txindex. Resync the block files without -dedupalerts to use -txindex",
+                     __func__, pindex->GetBlockHash().ToString());
+    }
+
     size_t txSize = block.vtx.size();
 
     CDiskTxPos pos(pindex->GetBlockPos(), GetSizeOfCompactSize(txSize));
@@ -299,11 +386,125 @@ bool TxIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex)
             return false;
     }
 
-    return true;
+    // Alerts mined in the block are pending
+    std::vector<uint256> vAlerts;
+    std::vector<std::pair<COutPoint, uint256>> vOutpoints;
+    std::vector<std::pair<uint256, CAlertStatus>> vStatus;
+    for (const auto& atx : block.vatx) {
+        vAlerts.push_back(atx->GetHash());
+        vStatus.emplace_back(atx->GetHash(), CAlertStatus(pindex->GetBlockHash(), pindex->nHeight));
+        for (const CTxIn& txin : atx->vin) {
+            vOutpoints.emplace_back(txin.prevout, atx->GetHash());
+        }
+    }
+    GetAlertStatusUpdates(block, pindex, true, vStatus);
+
+    return m_db->WriteAlerts(pindex->GetBlockHash(), vAlerts, vOutpoints, vStatus);
+}
+
+bool TxIndex::DisconnectBlock(const CBlock& block, const CBlockIndex* pindex)
+{
+    std::vector<uint256> vAlerts;
+    std::vector<COutPoint> vOutpoints;
+    std::vector<std::pair<uint256, CAlertStatus>> vStatus;
+    for (const auto& atx : block.vatx) {
+        vAlerts.push_back(atx->GetHash());
+        for (const CTxIn& txin : atx->vin) {
+            vOutpoints.push_back(txin.prevout);
+        }
+    }
+    GetAlertStatusUpdates(block, pindex, false, vStatus);
+
+    return m_db->EraseAlerts(pindex->GetBlockHash(), vAlerts, vOutpoints, vStatus);
+}
+
+/** Whether the block with the given hash and height is pindex or one of its ancestors. */
+static bool IsBlockInChainOf(const CBlockIndex* pindex, const uint256& hash, int nHeight)
+{
+    const CBlockIndex* pancestor = pindex ? pindex->GetAncestor(nHeight) : nullptr;
+    return pancestor && pancestor->GetBlockHash() == hash;
+}
+
+void TxIndex::GetAlertStatusUpdates(const CBlock& block, const CBlockIndex* pindex, bool fConnect,
+                                    std::vector<std::pair<uint256, CAlertStatus>>& vStatus) const
+{
+    const uint256 hashBlock = pindex->GetBlockHash();
+
+    // Move a pending alert to the new status when connecting, and back when disconnecting
+    auto update = [&](const uint256& alert_hash, vaulttxnstatus newStatus, const uint256& recoveryTxid) {
+        CAlertStatus status;
+        if (!m_db->ReadAlertStatus(alert_hash, status)) {
+            return;
+        }
+        if (fConnect) {
+            // Records are not reverted for blocks disconnected while the index is syncing or
+            // rewound on startup, so the stored status is recomputed from the chain of the block:
+            // it is only kept if it was set by an ancestor of the block.
+            if (!IsBlockInChainOf(pindex, status.hashBlock, status.nHeight)) return;
+            if (status.status != TX_PENDING &&
+                    IsBlockInChainOf(pindex->pprev, status.hashStatusBlock, status.nStatusHeight)) return;
+            status.status = newStatus;
+            status.hashStatusBlock = hashBlock;
+            status.nStatusHeight = pindex->nHeight;
+            status.recoveryTxid = recoveryTxid;
+        } else {
+            if (status.status != newStatus || status.hashStatusBlock != hashBlock) return;
+            status = CAlertStatus(status.hashBlock, status.nHeight);
+        }
+        vStatus.emplace_back(alert_hash, status);
+    };
+
+    // Alerts mined at the start of the window are confirmed by the block, unless they have been recovered
+    const int nWindow = Params().GetConsensus().nAlertsInitializationWindow;
+    std::vector<uint256> vAncestorAlerts;
+    if (pindex->nHeight > nWindow &&
+            m_db->ReadBlockAlerts(pindex->GetAncestor(pindex->nHeight - nWindow)->GetBlockHash(), vAncestorAlerts)) {
+        std::set<uint256> setTxids;
+        for (const auto& tx : block.vtx) {
+            setTxids.insert(tx->GetHash());
+        }
+        for (const uint256& alert_hash : vAncestorAlerts) {
+            if (setTxids.count(alert_hash)) {
+                update(alert_hash, TX_CONFIRMED, uint256());
+            }
+        }
+    }
+
+    // Recoveries revert the pending alerts which spent their inputs
+    for (const auto& tx : block.vtx) {
+        if (GetVaultTxTypeNonContextual(*tx) != TX_RECOVERY) {
+            continue;
+        }
+        for (const CTxIn& txin : tx->vin) {
+            uint256 alert_hash;
+            if (m_db->ReadOutpointAlert(txin.prevout, alert_hash)) {
+                update(alert_hash, TX_RECOVERED, tx->GetHash());
+            }
+        }
+    }
 }
 
 BaseIndex::DB& TxIndex::GetDB() const { return *m_db; }
 
+bool TxIndex::FindAlertStatus(const uint256& alert_hash, CAlertStatus& status) const
+{
+    if (!m_db->ReadAlertStatus(alert_hash, status)) {
+        return false;
+    }
+
+    // The record may be stale if the index missed a disconnection, so it is checked
+    // against the chain the index has processed, which needs no cs_main
+    const CBlockIndex* pindexBest = GetBestBlockIndex();
+    if (!IsBlockInChainOf(pindexBest, status.hashBlock, status.nHeight)) {
+        return false;
+    }
+    if (status.status == TX_PENDING) {
+        // Pending alerts are confirmed or recovered within nAlertsInitializationWindow blocks
+        return pindexBest->nHeight < status.nHeight + Params().GetConsensus().nAlertsInitializationWindow;
+    }
+    return IsBlockInChainOf(pindexBest, status.hashStatusBlock, status.nStatusHeight);
+}
+
 bool TxIndex::FindTx(const uint256& tx_hash, uint256& block_hash, CBaseTransactionRef& tx, vaulttxnstatus* txStatus) const
 {
     CDiskTxPos postx;
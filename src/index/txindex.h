@@ -10,10 +10,48 @@
 #include <txdb.h>
 #include <script/standard.h>
 
+/** Lifecycle of an alert mined in a block's vatx, as recorded by TxIndex. */
+struct CAlertStatus
+{
+    //! TX_PENDING, TX_CONFIRMED or TX_RECOVERED
+    vaulttxnstatus status;
+    //! Hash and height of the block whose vatx contains the alert
+    uint256 hashBlock;
+    int nHeight;
+    //! Hash and height of the block which confirmed or recovered the alert, null while pending
+    uint256 hashStatusBlock;
+    int nStatusHeight;
+    //! Hash of the transaction which recovered the alert, null unless recovered
+    uint256 recoveryTxid;
+
+    CAlertStatus() : status(TX_PENDING), nHeight(0), nStatusHeight(0) {}
+    CAlertStatus(const uint256& hashBlockIn, int nHeightIn) :
+        status(TX_PENDING), hashBlock(hashBlockIn), nHeight(nHeightIn), nStatusHeight(0) {}
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        uint8_t nStatus = static_cast<uint8_t>(status);
+        READWRITE(nStatus);
+        status = static_cast<vaulttxnstatus>(nStatus);
+        READWRITE(hashBlock);
+        READWRITE(VARINT(nHeight, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(hashStatusBlock);
+        READWRITE(VARINT(nStatusHeight, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(recoveryTxid);
+    }
+};
+
 /**
  * TxIndex is used to look up transactions included in the blockchain by hash.
  * The index is written to a LevelDB database and records the filesystem
  * location of each transaction by transaction hash.
+ *
+ * For alerts mined in a block's vatx the index also records their status
+ * (pending, confirmed in block h + nAlertsInitializationWindow or recovered),
+ * updated as blocks are connected and disconnected, so that the status can
+ * be looked up without holding cs_main or reading blocks and coins.
  */
 class TxIndex final : public BaseIndex
 {
@@ -23,12 +61,18 @@ protected:
 private:
     const std::unique_ptr<DB> m_db;
 
+    /// Collect the status changes of the alerts confirmed or recovered by a block.
+    void GetAlertStatusUpdates(const CBlock& block, const CBlockIndex* pindex, bool fConnect,
+                               std::vector<std::pair<uint256, CAlertStatus>>& vStatus) const;
+
 protected:
     /// Override base class init to migrate from old database.
     bool Init() override;
 
     bool WriteBlock(const CBlock& block, const CBlockIndex* pindex) override;
 
+    bool DisconnectBlock(const CBlock& block, const CBlockIndex* pindex) override;
+
     BaseIndex::DB& GetDB() const override;
 
     const char* GetName() const override { return "txindex"; }
@@ -48,6 +92,15 @@ public:
     /// @param[out]  txStatus  The status of transaction.
     /// @return  true if transaction is found, false otherwise
     bool FindTx(const uint256& tx_hash, uint256& block_hash, CBaseTransactionRef& tx, vaulttxnstatus* txStatus = nullptr) const;
+
+    /// Look up the status of an alert mined in a block's vatx. Records whose blocks are not
+    /// in the chain the index has processed, or which are still pending when they should
+    /// have been confirmed, are not returned. Does not take cs_main.
+    ///
+    /// @param[in]   alert_hash  The hash of the alert.
+    /// @param[out]  status  The status of the alert.
+    /// @return  true if the alert is found and its status matches the index's chain, false otherwise
+    bool FindAlertStatus(const uint256& alert_hash, CAlertStatus& status) const;
 };
 
 /// The global transaction index, used in GetTransaction. May be null.
@@ -21,6 +21,7 @@
 #include <httpserver.h>
 #include <httprpc.h>
 #include <interfaces/chain.h>
+#include <index/alertindex.h>
 #include <index/txindex.h>
 #include <key.h>
 #include <validation.h>
@@ -31,9 +32,11 @@
 #include <policy/feerate.h>
 #include <policy/fees.h>
 #include <policy/policy.h>
+#include <pow.h>
 #include <rpc/server.h>
 #include <rpc/register.h>
 #include <rpc/blockchain.h>
+#include <rpc/mining_stats.h>
 #include <rpc/util.h>
 #include <script/standard.h>
 #include <script/sigcache.h>
@@ -49,6 +52,7 @@
 #include <validationinterface.h>
 #include <warnings.h>
 #include <walletinitinterface.h>
+#include <watchtower.h>
 #include <stdint.h>
 #include <stdio.h>
 
@@ -189,6 +193,9 @@ void Interrupt()
     if (g_txindex) {
         g_txindex->Interrupt();
     }
+    if (g_alertindex) {
+        g_alertindex->Interrupt();
+    }
 }
 
 void Shutdown(InitInterfaces& interfaces)
@@ -220,6 +227,11 @@ void Shutdown(InitInterfaces& interfaces)
     if (peerLogic) UnregisterValidationInterface(peerLogic.get());
     if (g_connman) g_connman->Stop();
     if (g_txindex) g_txindex->Stop();
+    if (g_alertindex) g_alertindex->Stop();
+    if (gArgs.GetBoolArg("-prefetchblocktemplate", DEFAULT_PREFETCH_BLOCK_TEMPLATE)) {
+        BlockTemplateEngine::get().Stop();
+        BlockTemplateEngine::getForGBT().Stop();
+    }
 
     StopTorControl();
 
@@ -234,6 +246,7 @@ void Shutdown(InitInterfaces& interfaces)
     g_connman.reset();
     g_banman.reset();
     g_txindex.reset();
+    g_alertindex.reset();
 
     if (g_is_mempool_loaded && gArgs.GetArg("-persistmempool", DEFAULT_PERSIST_MEMPOOL)) {
         DumpMempool();
@@ -288,6 +301,13 @@ void Shutdown(InitInterfaces& interfaces)
     }
 #endif
 
+    if (g_watchtower) {
+        UnregisterValidationInterface(g_watchtower.get());
+        g_watchtower.reset();
+    }
+
+    UnregisterValidationInterface(&g_mining_stats);
+
     try {
         if (!fs::remove(GetPidFile())) {
             LogPrintf("%s: Unable to remove PID file: File does not exist\n", __func__);
@@ -381,6 +401,7 @@ void SetupServerArgs()
     gArgs.AddArg("-datadir=<dir>", "Specify data directory", false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-dbbatchsize", strprintf("Maximum database write batch size in bytes (default: %u)", nDefaultDbBatchSize), true, OptionsCategory::OPTIONS);
     gArgs.AddArg("-dbcache=<n>", strprintf("Maximum database cache size <n> MiB (%d to %d, default: %d). In addition, unused mempool memory is shared for this cache (see -maxmempool).", nMinDbCache, nMaxDbCache, nDefaultDbCache), false, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-dedupalerts", strprintf("Store confirmed alerts of new blocks as references to the block which mined them instead of a second copy. Block files written with this option cannot be read by older versions. This mode is incompatible with -prune and -txindex (default: %u)", DEFAULT_DEDUP_ALERTS), false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-debuglogfile=<file>", strprintf("Specify location of debug log file. Relative paths will be prefixed by a net-specific datadir location. (-nodebuglogfile to disable; default: %s)", DEFAULT_DEBUGLOGFILE), false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-feefilter", strprintf("Tell other nodes to filter invs to us by our mempool min fee (default: %u)", DEFAULT_FEEFILTER), true, OptionsCategory::OPTIONS);
     gArgs.AddArg("-includeconf=<file>", "Specify additional configuration file, relative to the -datadir path (only useable from configuration file, not command line)", false, OptionsCategory::OPTIONS);
@@ -404,6 +425,8 @@ void SetupServerArgs()
     hidden_args.emplace_back("-sysperms");
 #endif
     gArgs.AddArg("-txindex", strprintf("Maintain a full transaction index, used by the getrawtransaction rpc call (default: %u)", DEFAULT_TXINDEX), false, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-watchtower", strprintf("Submit registered recovery transactions as soon as a matching alert is seen (default: %u)", DEFAULT_WATCHTOWER), false, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-alertindex", strprintf("Maintain an index of outputs spent by alerts, used to validate recovery transactions without reading ancestor blocks (default: %u)", DEFAULT_ALERTINDEX), false, OptionsCategory::OPTIONS);
 
     gArgs.AddArg("-addnode=<ip>", "Add a node to connect to and attempt to keep the connection open (see the `addnode` RPC command help for more info). This option can be specified multiple times to add multiple nodes.", false, OptionsCategory::CONNECTION);
     gArgs.AddArg("-banscore=<n>", strprintf("Threshold for disconnecting misbehaving peers (default: %u)", DEFAULT_BANSCORE_THRESHOLD), false, OptionsCategory::CONNECTION);
@@ -455,10 +478,18 @@ void SetupServerArgs()
     gArgs.AddArg("-zmqpubhashtx=<address>", "Enable publish hash transaction in <address>", false, OptionsCategory::ZMQ);
     gArgs.AddArg("-zmqpubrawblock=<address>", "Enable publish raw block in <address>", false, OptionsCategory::ZMQ);
     gArgs.AddArg("-zmqpubrawtx=<address>", "Enable publish raw transaction in <address>", false, OptionsCategory::ZMQ);
+    gArgs.AddArg("-zmqpubhashalert=<address>", "Enable publish hash of alerts mined in a block in <address>", false, OptionsCategory::ZMQ);
+    gArgs.AddArg("-zmqpubrawalert=<address>", "Enable publish raw alerts mined in a block in <address>", false, OptionsCategory::ZMQ);
+    gArgs.AddArg("-zmqpubalertconfirmed=<address>", "Enable publish hash of confirmed alerts in <address>", false, OptionsCategory::ZMQ);
+    gArgs.AddArg("-zmqpubalertrecovered=<address>", "Enable publish hash of recovered alerts in <address> (requires -alertindex)", false, OptionsCategory::ZMQ);
     gArgs.AddArg("-zmqpubhashblockhwm=<n>", strprintf("Set publish hash block outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), false, OptionsCategory::ZMQ);
     gArgs.AddArg("-zmqpubhashtxhwm=<n>", strprintf("Set publish hash transaction outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), false, OptionsCategory::ZMQ);
     gArgs.AddArg("-zmqpubrawblockhwm=<n>", strprintf("Set publish raw block outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), false, OptionsCategory::ZMQ);
     gArgs.AddArg("-zmqpubrawtxhwm=<n>", strprintf("Set publish raw transaction outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), false, OptionsCategory::ZMQ);
+    gArgs.AddArg("-zmqpubhashalerthwm=<n>", strprintf("Set publish hash alert outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), false, OptionsCategory::ZMQ);
+    gArgs.AddArg("-zmqpubrawalerthwm=<n>", strprintf("Set publish raw alert outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), false, OptionsCategory::ZMQ);
+    gArgs.AddArg("-zmqpubalertconfirmedhwm=<n>", strprintf("Set publish confirmed alert outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), false, OptionsCategory::ZMQ);
+    gArgs.AddArg("-zmqpubalertrecoveredhwm=<n>", strprintf("Set publish recovered alert outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), false, OptionsCategory::ZMQ);
 #else
     hidden_args.emplace_back("-zmqpubhashblock=<address>");
     hidden_args.emplace_back("-zmqpubhashtx=<address>");
@@ -468,6 +499,14 @@ void SetupServerArgs()
     hidden_args.emplace_back("-zmqpubhashtxhwm=<n>");
     hidden_args.emplace_back("-zmqpubrawblockhwm=<n>");
     hidden_args.emplace_back("-zmqpubrawtxhwm=<n>");
+    hidden_args.emplace_back("-zmqpubhashalert=<address>");
+    hidden_args.emplace_back("-zmqpubrawalert=<address>");
+    hidden_args.emplace_back("-zmqpubalertconfirmed=<address>");
+    hidden_args.emplace_back("-zmqpubalertrecovered=<address>");
+    hidden_args.emplace_back("-zmqpubhashalerthwm=<n>");
+    hidden_args.emplace_back("-zmqpubrawalerthwm=<n>");
+    hidden_args.emplace_back("-zmqpubalertconfirmedhwm=<n>");
+    hidden_args.emplace_back("-zmqpubalertrecoveredhwm=<n>");
 #endif
 
     gArgs.AddArg("-checkblocks=<n>", strprintf("How many blocks to check at startup (default: %u, 0 = all)", DEFAULT_CHECKBLOCKS), true, OptionsCategory::DEBUG_TEST);
@@ -480,6 +519,7 @@ void SetupServerArgs()
         "each level includes the checks of the previous levels "
         "(0-4, default: %u)", DEFAULT_CHECKLEVEL), true, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-checkblockindex", strprintf("Do a full consistency check for mapBlockIndex, setBlockIndexCandidates, chainActive and mapBlocksUnlinked occasionally. (default: %u, regtest: %u)", defaultChainParams->DefaultConsistencyChecks(), regtestChainParams->DefaultConsistencyChecks()), true, OptionsCategory::DEBUG_TEST);
+    gArgs.AddArg("-checklwma", strprintf("Verify every incrementally computed LWMA difficulty against the full averaging window. (default: %u, regtest: %u)", defaultChainParams->DefaultConsistencyChecks(), regtestChainParams->DefaultConsistencyChecks()), true, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-checkmempool=<n>", strprintf("Run checks every <n> transactions (default: %u, regtest: %u)", defaultChainParams->DefaultConsistencyChecks(), regtestChainParams->DefaultConsistencyChecks()), true, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-checkpoints", strprintf("Disable expensive verification for known chain history (default: %u)", DEFAULT_CHECKPOINTS_ENABLED), true, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-deprecatedrpc=<method>", "Allows deprecated RPC method(s) to be used", true, OptionsCategory::DEBUG_TEST);
@@ -524,6 +564,7 @@ void SetupServerArgs()
 
     gArgs.AddArg("-blockmaxweight=<n>", strprintf("Set maximum BIP141 block weight (default: %d)", DEFAULT_BLOCK_MAX_WEIGHT), false, OptionsCategory::BLOCK_CREATION);
     gArgs.AddArg("-blockmintxfee=<amt>", strprintf("Set lowest fee rate (in %s/kB) for transactions to be included in block creation. (default: %s)", CURRENCY_UNIT, FormatMoney(DEFAULT_BLOCK_MIN_TX_FEE)), false, OptionsCategory::BLOCK_CREATION);
+    gArgs.AddArg("-prefetchblocktemplate", strprintf("Build the block template for the next block as soon as a new tip is connected, starting with only the ancestor alerts (default: %u)", DEFAULT_PREFETCH_BLOCK_TEMPLATE), false, OptionsCategory::BLOCK_CREATION);
     gArgs.AddArg("-blockversion=<n>", "Override block version to test forking scenarios", true, OptionsCategory::BLOCK_CREATION);
 
     gArgs.AddArg("-rest", strprintf("Accept public REST requests (default: %u)", DEFAULT_REST_ENABLE), false, OptionsCategory::RPC);
@@ -958,8 +999,16 @@ bool AppInitParameterInteraction()
     if (gArgs.GetArg("-prune", 0)) {
         if (gArgs.GetBoolArg("-txindex", DEFAULT_TXINDEX))
             return InitError(_("Prune mode is incompatible with -txindex."));
+        if (gArgs.GetBoolArg("-alertindex", DEFAULT_ALERTINDEX))
+            return InitError(_("Prune mode is incompatible with -alertindex."));
+        if (gArgs.GetBoolArg("-dedupalerts", DEFAULT_DEDUP_ALERTS))
+            return InitError(_("Prune mode is incompatible with -dedupalerts."));
     }
 
+    // txindex offsets assume the canonical block serialization in blk*.dat
+    if (gArgs.GetBoolArg("-dedupalerts", DEFAULT_DEDUP_ALERTS) && gArgs.GetBoolArg("-txindex", DEFAULT_TXINDEX))
+        return InitError(_("-txindex is incompatible with -dedupalerts."));
+
     // -bind and -whitebind can't be set when not listening
     size_t nUserBind = gArgs.GetArgs("-bind").size() + gArgs.GetArgs("-whitebind").size();
     if (nUserBind != 0 && !gArgs.GetBoolArg("-listen", DEFAULT_LISTEN)) {
@@ -1015,7 +1064,9 @@ bool AppInitParameterInteraction()
         mempool.setSanityCheck(1.0 / ratio);
     }
     fCheckBlockIndex = gArgs.GetBoolArg("-checkblockindex", chainparams.DefaultConsistencyChecks());
+    fCheckLwma = gArgs.GetBoolArg("-checklwma", chainparams.DefaultConsistencyChecks());
     fCheckpointsEnabled = gArgs.GetBoolArg("-checkpoints", DEFAULT_CHECKPOINTS_ENABLED);
+    fDedupAlerts = gArgs.GetBoolArg("-dedupalerts", DEFAULT_DEDUP_ALERTS);
 
     hashAssumeValid = uint256S(gArgs.GetArg("-assumevalid", chainparams.GetConsensus().defaultAssumeValid.GetHex()));
     if (!hashAssumeValid.IsNull())
@@ -1270,11 +1321,14 @@ bool AppInitMain(InitInterfaces& interfaces)
 
     InitSignatureCache();
     InitScriptExecutionCache();
+    InitVaultTxTypeCache();
 
     LogPrintf("Using %u threads for script verification\n", nScriptCheckThreads);
     if (nScriptCheckThreads) {
-        for (int i=0; i<nScriptCheckThreads-1; i++)
+        for (int i=0; i<nScriptCheckThreads-1; i++) {
             threadGroup.create_thread(&ThreadScriptCheck);
+            threadGroup.create_thread(&ThreadHeaderCheck);
+        }
     }
 
     // Start the lightweight task scheduler thread
@@ -1428,6 +1482,19 @@ bool AppInitMain(InitInterfaces& interfaces)
         RegisterValidationInterface(g_zmq_notification_interface);
     }
 #endif
+
+    if (gArgs.GetBoolArg("-watchtower", DEFAULT_WATCHTOWER)) {
+        g_watchtower = MakeUnique<CWatchtower>();
+        g_watchtower->Load();
+        RegisterValidationInterface(g_watchtower.get());
+    }
+
+    if (gArgs.GetBoolArg("-prefetchblocktemplate", DEFAULT_PREFETCH_BLOCK_TEMPLATE)) {
+        BlockTemplateEngine::get().Start();
+        BlockTemplateEngine::getForGBT().Start();
+    }
+    RegisterValidationInterface(&g_mining_stats);
+
     uint64_t nMaxOutboundLimit = 0; //unlimited unless -maxuploadtarget is set
     uint64_t nMaxOutboundTimeframe = MAX_UPLOAD_TIMEFRAME;
 
@@ -1448,6 +1515,8 @@ bool AppInitMain(InitInterfaces& interfaces)
     nTotalCache -= nBlockTreeDBCache;
     int64_t nTxIndexCache = std::min(nTotalCache / 8, gArgs.GetBoolArg("-txindex", DEFAULT_TXINDEX) ? nMaxTxIndexCache << 20 : 0);
     nTotalCache -= nTxIndexCache;
+    int64_t nAlertIndexCache = std::min(nTotalCache / 8, gArgs.GetBoolArg("-alertindex", DEFAULT_ALERTINDEX) ? nMaxAlertIndexCache << 20 : 0);
+    nTotalCache -= nAlertIndexCache;
     int64_t nCoinDBCache = std::min(nTotalCache / 2, (nTotalCache / 4) + (1 << 23)); // use 25%-50% of the remainder for disk cache
     nCoinDBCache = std::min(nCoinDBCache, nMaxCoinsDBCache << 20); // cap total coins db cache
     nTotalCache -= nCoinDBCache;
@@ -1458,6 +1527,9 @@ bool AppInitMain(InitInterfaces& interfaces)
     if (gArgs.GetBoolArg("-txindex", DEFAULT_TXINDEX)) {
         LogPrintf("* Using %.1f MiB for transaction index database\n", nTxIndexCache * (1.0 / 1024 / 1024));
     }
+    if (gArgs.GetBoolArg("-alertindex", DEFAULT_ALERTINDEX)) {
+        LogPrintf("* Using %.1f MiB for alert index database\n", nAlertIndexCache * (1.0 / 1024 / 1024));
+    }
     LogPrintf("* Using %.1f MiB for chain state database\n", nCoinDBCache * (1.0 / 1024 / 1024));
     LogPrintf("* Using %.1f MiB for in-memory UTXO set (plus up to %.1f MiB of unused mempool space)\n", nCoinCacheUsage * (1.0 / 1024 / 1024), nMempoolSizeMax * (1.0 / 1024 / 1024));
 
@@ -1644,6 +1716,10 @@ bool AppInitMain(InitInterfaces& interfaces)
         g_txindex = MakeUnique<TxIndex>(nTxIndexCache, false, fReindex);
         g_txindex->Start();
     }
+    if (gArgs.GetBoolArg("-alertindex", DEFAULT_ALERTINDEX)) {
+        g_alertindex = MakeUnique<AlertIndex>(nAlertIndexCache, false, fReindex);
+        g_alertindex->Start();
+    }
 
     // ********************************************************* Step 9: load wallet
     for (const auto& client : interfaces.chain_clients) {
@@ -27,6 +27,7 @@
 #include <validationinterface.h>
 
 #include <algorithm>
+#include <functional>
 #include <queue>
 #include <utility>
 
@@ -48,11 +49,13 @@ int64_t UpdateTime(CBlockHeader* pblock, const Consensus::Params& consensusParam
 BlockAssembler::Options::Options() {
     blockMinFeeRate = CFeeRate(DEFAULT_BLOCK_MIN_TX_FEE);
     nBlockMaxWeight = DEFAULT_BLOCK_MAX_WEIGHT;
+    fIncludeMempool = true;
 }
 
 BlockAssembler::BlockAssembler(const CChainParams& params, const Options& options) : chainparams(params)
 {
     blockMinFeeRate = options.blockMinFeeRate;
+    fIncludeMempool = options.fIncludeMempool;
     // Limit weight to between 4K and MAX_BLOCK_WEIGHT-4K for sanity:
     nBlockMaxWeight = std::max<size_t>(4000, std::min<size_t>(MAX_BLOCK_WEIGHT - 4000, options.nBlockMaxWeight));
 }
@@ -90,9 +93,12 @@ void BlockAssembler::resetBlock()
     nAncestorAlertsFees = 0;
 }
 
-Optional<int64_t> BlockAssembler::m_last_block_num_txs{nullopt};
-Optional<int64_t> BlockAssembler::m_last_block_num_atxs{nullopt};
-Optional<int64_t> BlockAssembler::m_last_block_weight{nullopt};
+std::shared_ptr<const BlockAssemblerStats> BlockAssembler::m_last_block_stats;
+
+std::shared_ptr<const BlockAssemblerStats> BlockAssembler::GetLastBlockStats()
+{
+    return std::atomic_load(&m_last_block_stats);
+}
 
 std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& scriptPubKeyIn)
 {
@@ -148,17 +154,21 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
     bool fAlertsInitialized = nHeight - chainparams.GetConsensus().AlertsHeight
                               >= (int) chainparams.GetConsensus().nAlertsInitializationWindow;
 
-    addPackageTxs(nPackagesSelected, nDescendantsUpdated, fAlertsEnabled);
+    if (fIncludeMempool)
+        addPackageTxs(nPackagesSelected, nDescendantsUpdated, fAlertsEnabled);
 
     CScript ancestorScriptPubKey;
+    pblocktemplate->ancestorAlertsFee = 0;
     if (fAlertsEnabled && fAlertsInitialized) {
-        CBlock ancestorBlock;
-        if(!GetAncestorBlock(pindexPrev, chainparams.GetConsensus(), ancestorBlock)) {
+        CAlertsWindowEntryRef ancestorAlerts = GetAncestorAlerts(pindexPrev, chainparams.GetConsensus());
+        if (!ancestorAlerts) {
             assert(!"CreateNewBlock(): cannot get ancestor block");
         }
-        addTxsFromAlerts(ancestorBlock, chainparams.GetConsensus());
+        addTxsFromAlerts(ancestorAlerts->vatx, chainparams.GetConsensus());
 
-        ancestorScriptPubKey = ancestorBlock.vtx[0]->vout[0].scriptPubKey;
+        ancestorScriptPubKey = ancestorAlerts->coinbaseScriptPubKey;
+        pblocktemplate->ancestorAlertsFee = nAncestorAlertsFees;
+        pblocktemplate->ancestorAlertsPubKey = ancestorScriptPubKey;
         // If the current miner is the same as original one then merge fee outputs
         if (ancestorScriptPubKey == scriptPubKeyIn) {
             nFees += nAncestorAlertsFees;
@@ -168,9 +178,8 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
 
     int64_t nTime1 = GetTimeMicros();
 
-    m_last_block_num_txs = nBlockTx;
-    m_last_block_num_atxs = nBlockAlertTx;
-    m_last_block_weight = nBlockWeight;
+    std::atomic_store(&m_last_block_stats, std::shared_ptr<const BlockAssemblerStats>(new BlockAssemblerStats{
+        (int64_t)nBlockWeight, (int64_t)nBlockTx, (int64_t)nBlockAlertTx, pblocktemplate->ancestorAlertsFee}));
 
     // Create coinbase transaction.
     CMutableTransaction coinbaseTx;
@@ -362,7 +371,7 @@ void BlockAssembler::SortForBlock(const CTxMemPool::setEntries& package, std::ve
     std::sort(sortedEntries.begin(), sortedEntries.end(), CompareTxIterByAncestorCount());
 }
 
-void BlockAssembler::addTxsFromAlerts(const CBlock& ancestorBlock, const Consensus::Params& params)
+void BlockAssembler::addTxsFromAlerts(const std::vector<CAlertTransactionRef>& vatx, const Consensus::Params& params)
 {
     CCoinsViewCache view(pcoinsTip.get());
     auto checkAlertTx = [&] (CAlertTransactionRef atx) -> bool {
@@ -375,7 +384,7 @@ void BlockAssembler::addTxsFromAlerts(const CBlock& ancestorBlock, const Consens
         return true;
     };
 
-    for (const CAlertTransactionRef& atx : ancestorBlock.vatx) {
+    for (const CAlertTransactionRef& atx : vatx) {
         if(!checkAlertTx(atx)) {
             LogPrintf("addTxsFromAlerts(): skipping reverted tx alert %s\n, ", atx->GetHash().ToString());
             continue;
@@ -511,18 +520,10 @@ void BlockAssembler::addPackageTxs(int &nPackagesSelected, int &nDescendantsUpda
         std::vector<CTxMemPool::txiter> sortedEntries;
         SortForBlock(ancestors, sortedEntries);
 
-        CCoinsView viewDummy;
-        CCoinsViewCache view(&viewDummy);
-        CCoinsViewCache &viewChain = *pcoinsTip;
-        CCoinsViewMemPool viewMempool(&viewChain, mempool);
-        view.SetBackend(viewMempool);
-
         // Decide if add transaction as alert or regular transaction
         auto addToBlock = [&] (CTxMemPool::txiter entry) {
-            if (alertsEnabled) {
-                vaulttxntype vaultTxType = GetVaultTxType(entry->GetTx(), view);
-                if (vaultTxType == TX_ALERT)
-                    return AddAlertTxToBlock(entry);
+            if (alertsEnabled && entry->GetVaultType() == TX_ALERT) {
+                return AddAlertTxToBlock(entry);
             }
 
             return AddTxToBlock(entry);
@@ -542,6 +543,189 @@ void BlockAssembler::addPackageTxs(int &nPackagesSelected, int &nDescendantsUpda
     }
 }
 
+void SetCoinbaseScript(CBlockTemplate& blocktemplate, const CScript& scriptPubKeyIn)
+{
+    CBlock& block = blocktemplate.block;
+    CMutableTransaction coinbaseTx(*block.vtx[0]);
+
+    // The payout outputs come first, followed by the witness commitment (if any)
+    const bool fMerged = blocktemplate.ancestorAlertsFee > 0 && blocktemplate.alertsMinerFee == 0;
+    const size_t nPayoutOutputs = (blocktemplate.ancestorAlertsFee > 0 && !fMerged) ? 2 : 1;
+    const CAmount nValue = coinbaseTx.vout[0].nValue - (fMerged ? blocktemplate.ancestorAlertsFee : 0);
+
+    std::vector<CTxOut> vout;
+    blocktemplate.alertsMinerFee = 0;
+    blocktemplate.alertsMinerPubKey.clear();
+    if (blocktemplate.ancestorAlertsFee > 0 && blocktemplate.ancestorAlertsPubKey == scriptPubKeyIn) {
+        vout.emplace_back(nValue + blocktemplate.ancestorAlertsFee, scriptPubKeyIn);
+    } else {
+        vout.emplace_back(nValue, scriptPubKeyIn);
+        if (blocktemplate.ancestorAlertsFee > 0) {
+            vout.emplace_back(blocktemplate.ancestorAlertsFee, blocktemplate.ancestorAlertsPubKey);
+            blocktemplate.alertsMinerFee = blocktemplate.ancestorAlertsFee;
+            blocktemplate.alertsMinerPubKey = blocktemplate.ancestorAlertsPubKey;
+        }
+    }
+    vout.insert(vout.end(), coinbaseTx.vout.begin() + nPayoutOutputs, coinbaseTx.vout.end());
+    coinbaseTx.vout = std::move(vout);
+
+    block.vtx[0] = MakeTransactionRef(std::move(coinbaseTx));
+    blocktemplate.vTxSigOpsCost[0] = WITNESS_SCALE_FACTOR * GetLegacySigOpCount(*block.vtx[0]);
+}
+
+bool BlockTemplateEngine::Rebuild(const CTxMemPool& pool, bool fIncludeMempool)
+{
+    // Store the tip used before CreateNewBlock, to avoid races
+    const unsigned int nTransactionsUpdatedNew = pool.GetTransactionsUpdated();
+    const CBlockIndex* pindexPrevNew = chainActive.Tip();
+
+    // The coinbase is paid to an empty script here, SetCoinbaseScript
+    // replaces it for each caller
+    BlockAssembler::Options options = DefaultOptions();
+    options.fIncludeMempool = fIncludeMempool;
+    std::unique_ptr<CBlockTemplate> pblocktemplateNew = BlockAssembler(Params(), options).CreateNewBlock(CScript());
+    if (!pblocktemplateNew)
+        return false;
+
+    // Update state only after CreateNewBlock succeeded
+    pblocktemplateNew->nSequence = ++nSequence;
+    pblocktemplate = std::move(pblocktemplateNew);
+    nTransactionsUpdatedLast = nTransactionsUpdatedNew;
+    pindexPrev = pindexPrevNew;
+    nStart = GetTime();
+    fPartial = !fIncludeMempool;
+    return true;
+}
+
+std::shared_ptr<const CBlockTemplate> BlockTemplateEngine::GetBlockTemplate(const CTxMemPool& pool)
+{
+    LOCK2(cs_main, cs);
+    if (!pblocktemplate || pindexPrev != chainActive.Tip() || (fPartial && !fPrefetchPending) ||
+        (pool.GetTransactionsUpdated() != nTransactionsUpdatedLast && GetTime() - nStart > nMaxAge))
+    {
+        if (!Rebuild(pool, true))
+            return nullptr;
+    }
+    return pblocktemplate;
+}
+
+void BlockTemplateEngine::UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload)
+{
+    if (fInitialDownload)
+        return;
+
+    // Serve the ancestor alerts for the new tip right away and leave the
+    // mempool selection to threadPrefetch, so that the scheduler thread does
+    // not hold cs_main while it is built. A later tip is handled by its own
+    // notification.
+    try {
+        LOCK2(cs_main, cs);
+        if (chainActive.Tip() != pindexNew || pindexPrev == pindexNew)
+            return;
+        if (!Rebuild(mempool, false))
+            return;
+        fPrefetchPending = fPrefetchRunning;
+    } catch (const std::exception& e) {
+        LogPrintf("%s: failed to prefetch block template: %s\n", __func__, e.what());
+        return;
+    }
+    condPrefetch.notify_one();
+}
+
+void BlockTemplateEngine::ThreadPrefetch()
+{
+    while (true) {
+        {
+            WAIT_LOCK(cs, lock);
+            while (fPrefetchRunning && !fPrefetchPending) {
+                condPrefetch.wait(lock);
+            }
+            if (!fPrefetchRunning)
+                return;
+        }
+
+        bool fPrefetched = false;
+        try {
+            LOCK2(cs_main, cs);
+            // A caller or a later tip may have replaced the partial template meanwhile
+            if (!fPrefetchPending)
+                continue;
+            fPrefetchPending = false;
+            if (fPartial && pindexPrev == chainActive.Tip())
+                fPrefetched = Rebuild(mempool, true);
+        } catch (const std::exception& e) {
+            LogPrintf("%s: failed to prefetch block template: %s\n", __func__, e.what());
+        }
+
+        // Long polls returned the partial template, let them pick up the full one
+        if (fPrefetched) {
+            LOCK(g_best_block_mutex);
+            g_best_block_cv.notify_all();
+        }
+    }
+}
+
+void BlockTemplateEngine::Start()
+{
+    {
+        LOCK(cs);
+        fPrefetchRunning = true;
+    }
+    threadPrefetch = std::thread(&TraceThread<std::function<void()>>, "tmplprefetch",
+                                 std::bind(&BlockTemplateEngine::ThreadPrefetch, this));
+    RegisterValidationInterface(this);
+}
+
+void BlockTemplateEngine::Stop()
+{
+    UnregisterValidationInterface(this);
+    {
+        LOCK(cs);
+        fPrefetchRunning = false;
+        fPrefetchPending = false;
+    }
+    condPrefetch.notify_all();
+
+    if (threadPrefetch.joinable()) {
+        threadPrefetch.join();
+    }
+}
+
+unsigned int BlockTemplateEngine::GetTransactionsUpdated()
+{
+    LOCK(cs);
+    return nTransactionsUpdatedLast;
+}
+
+uint64_t BlockTemplateEngine::GetSequence()
+{
+    LOCK(cs);
+    return nSequence;
+}
+
+std::unique_ptr<CBlockTemplate> BlockTemplateEngine::CreateNewBlock(const CTxMemPool& pool, const CScript& scriptPubKeyIn)
+{
+    std::shared_ptr<const CBlockTemplate> pblocktemplateShared = GetBlockTemplate(pool);
+    if (!pblocktemplateShared)
+        return nullptr;
+
+    std::unique_ptr<CBlockTemplate> pblocktemplateNew(new CBlockTemplate(*pblocktemplateShared));
+    SetCoinbaseScript(*pblocktemplateNew, scriptPubKeyIn);
+    return pblocktemplateNew;
+}
+
+BlockTemplateEngine& BlockTemplateEngine::get()
+{
+    static BlockTemplateEngine instance;
+    return instance;
+}
+
+BlockTemplateEngine& BlockTemplateEngine::getForGBT()
+{
+    static BlockTemplateEngine instance(GBT_BLOCK_TEMPLATE_MAX_AGE);
+    return instance;
+}
+
 void IncrementExtraNonce(CBlock* pblock, const CBlockIndex* pindexPrev, unsigned int& nExtraNonce, const Consensus::Params& consensusParams)
 {
     // Update nExtraNonce
@@ -10,9 +10,12 @@
 #include <primitives/block.h>
 #include <txmempool.h>
 #include <validation.h>
+#include <validationinterface.h>
 
+#include <condition_variable>
 #include <memory>
 #include <stdint.h>
+#include <thread>
 
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/ordered_index.hpp>
@@ -24,6 +27,7 @@ class CScript;
 namespace Consensus { struct Params; };
 
 static const bool DEFAULT_PRINTPRIORITY = false;
+static const bool DEFAULT_PREFETCH_BLOCK_TEMPLATE = false;
 
 struct CBlockTemplate
 {
@@ -35,6 +39,22 @@ struct CBlockTemplate
     CScript alertsMinerPubKey;
     uint256 hashAlertsMerkleRoot;
     std::vector<unsigned char> vchCoinbaseCommitment;
+    // Fees of the ancestor alerts and the coinbase script of their miner, kept
+    // whether or not they were merged into the first coinbase output
+    CAmount ancestorAlertsFee;
+    CScript ancestorAlertsPubKey;
+    // Build number of the BlockTemplateEngine template this was copied from,
+    // 0 if it was assembled directly
+    uint64_t nSequence;
+};
+
+/** Statistics of the last block assembled by BlockAssembler */
+struct BlockAssemblerStats
+{
+    int64_t nBlockWeight;
+    int64_t nBlockTx;
+    int64_t nBlockAlertTx;
+    CAmount nAncestorAlertsFees;
 };
 
 // Container for tracking updates to ancestor feerate as we include (parent)
@@ -137,6 +157,7 @@ private:
 
     // Configuration parameters for the block size
     bool fIncludeWitness;
+    bool fIncludeMempool;
     unsigned int nBlockMaxWeight;
     CFeeRate blockMinFeeRate;
 
@@ -159,6 +180,9 @@ public:
         Options();
         size_t nBlockMaxWeight;
         CFeeRate blockMinFeeRate;
+        // Select mempool transactions; without it the block only holds the
+        // transactions of the ancestor alerts
+        bool fIncludeMempool;
     };
 
     explicit BlockAssembler(const CChainParams& params);
@@ -167,11 +191,13 @@ public:
     /** Construct a new block template with coinbase to scriptPubKeyIn */
     std::unique_ptr<CBlockTemplate> CreateNewBlock(const CScript& scriptPubKeyIn);
 
-    static Optional<int64_t> m_last_block_num_txs;
-    static Optional<int64_t> m_last_block_num_atxs;
-    static Optional<int64_t> m_last_block_weight;
+    /** Statistics of the last assembled block, or nullptr if none was assembled yet.
+     *  Published atomically, so no lock is needed to read them. */
+    static std::shared_ptr<const BlockAssemblerStats> GetLastBlockStats();
 
 private:
+    static std::shared_ptr<const BlockAssemblerStats> m_last_block_stats;
+
     // utility functions
     /** Clear the block's state and prepare for assembling a new block */
     void resetBlock();
@@ -183,7 +209,7 @@ private:
     void AddAlertTxToBlock(CTxMemPool::txiter iter);
 
     // Methods for how to add alerted transactions to a block.
-    void addTxsFromAlerts(const CBlock& ancestorBlock, const Consensus::Params& params);
+    void addTxsFromAlerts(const std::vector<CAlertTransactionRef>& vatx, const Consensus::Params& params);
 
     // Methods for how to add transactions to a block.
     /** Add transactions based on feerate including unconfirmed ancestors
@@ -212,6 +238,87 @@ private:
     int UpdatePackagesForAdded(const CTxMemPool::setEntries& alreadyAdded, indexed_modified_transaction_set &mapModifiedTx) EXCLUSIVE_LOCKS_REQUIRED(mempool.cs);
 };
 
+namespace miner_tests {
+class BlockTemplateEngineForTest;
+}
+
+/** Default for the age after which mempool changes rebuild the shared block template, in seconds */
+static const int64_t DEFAULT_BLOCK_TEMPLATE_MAX_AGE = 60;
+/** Age after which mempool changes rebuild the getblocktemplate template, in seconds */
+static const int64_t GBT_BLOCK_TEMPLATE_MAX_AGE = 5;
+
+/**
+ * Keeps a single block template on top of the current tip that is shared by
+ * the mining RPCs. The transaction selection is only rebuilt when the tip
+ * moves, or when the mempool changed and the template is older than nMaxAge;
+ * callers then stamp their own coinbase onto a copy. All callers of an engine
+ * share its refresh policy, so none of them rebuilds the template under the
+ * others; getblocktemplate, which refreshes more often than createauxblock,
+ * has an engine of its own.
+ *
+ * When started (-prefetchblocktemplate), a new tip immediately gets a
+ * template holding only the ancestor alert transactions. The full selection
+ * replacing it is built on threadPrefetch rather than on the scheduler
+ * thread. Until then the partial template is served; if the full selection
+ * was not prefetched, the next caller rebuilds it. Once it is prefetched,
+ * long polls waiting on g_best_block_cv are woken up, and see from the
+ * template's sequence number that it changed.
+ */
+class BlockTemplateEngine : public CValidationInterface
+{
+private:
+    Mutex cs;
+    const int64_t nMaxAge;
+    std::shared_ptr<const CBlockTemplate> pblocktemplate GUARDED_BY(cs);
+    const CBlockIndex* pindexPrev GUARDED_BY(cs) = nullptr;
+    unsigned int nTransactionsUpdatedLast GUARDED_BY(cs) = 0;
+    int64_t nStart GUARDED_BY(cs) = 0;
+    // Incremented for every template built, so long polls can tell them apart
+    uint64_t nSequence GUARDED_BY(cs) = 0;
+    // Whether pblocktemplate was built without mempool transactions
+    bool fPartial GUARDED_BY(cs) = false;
+    // Whether threadPrefetch runs and has yet to build the full selection
+    bool fPrefetchRunning GUARDED_BY(cs) = false;
+    bool fPrefetchPending GUARDED_BY(cs) = false;
+    std::condition_variable condPrefetch;
+    std::thread threadPrefetch;
+
+    /** Replace the shared template by a new one on top of the current tip */
+    bool Rebuild(const CTxMemPool& pool, bool fIncludeMempool) EXCLUSIVE_LOCKS_REQUIRED(cs_main, cs);
+    /** Build the full selection on top of partial templates, run on threadPrefetch */
+    void ThreadPrefetch();
+
+protected:
+    void UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload) override;
+
+public:
+    explicit BlockTemplateEngine(int64_t nMaxAgeIn = DEFAULT_BLOCK_TEMPLATE_MAX_AGE) : nMaxAge(nMaxAgeIn) {}
+
+    /** Return the shared template, rebuilding it first if it is out of date */
+    std::shared_ptr<const CBlockTemplate> GetBlockTemplate(const CTxMemPool& pool);
+    /** Return the mempool update count the shared template was built at */
+    unsigned int GetTransactionsUpdated();
+    /** Return the sequence number of the shared template */
+    uint64_t GetSequence();
+    /** Return a copy of the shared template with the coinbase paid to scriptPubKeyIn */
+    std::unique_ptr<CBlockTemplate> CreateNewBlock(const CTxMemPool& pool, const CScript& scriptPubKeyIn);
+
+    /** Start threadPrefetch and prefetch the template of every new tip */
+    void Start();
+    /** Stop prefetching and wait for threadPrefetch to exit */
+    void Stop();
+
+    /** Returns the instance shared by the auxpow mining RPCs */
+    static BlockTemplateEngine& get();
+    /** Returns the instance used by getblocktemplate */
+    static BlockTemplateEngine& getForGBT();
+
+    friend class miner_tests::BlockTemplateEngineForTest;
+};
+
+/** Pay the coinbase of a template built by CreateNewBlock to scriptPubKeyIn,
+ *  keeping its transactions. The merkle root must be updated afterwards. */
+void SetCoinbaseScript(CBlockTemplate& blocktemplate, const CScript& scriptPubKeyIn);
 /** Modify the extranonce in a block */
 void IncrementExtraNonce(CBlock* pblock, const CBlockIndex* pindexPrev, unsigned int& nExtraNonce, const Consensus::Params& consensusParams);
 int64_t UpdateTime(CBlockHeader* pblock, const Consensus::Params& consensusParams, const CBlockIndex* pindexPrev);
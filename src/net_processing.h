@@ -89,4 +89,7 @@ struct CNodeStateStats {
 /** Get statistics from node state */
 bool GetNodeStateStats(NodeId nodeid, CNodeStateStats &stats);
 
+/** Relay transaction to every node */
+void RelayTransaction(const CTransaction& tx, CConnman* connman);
+
 #endif // BITCOIN_NET_PROCESSING_H
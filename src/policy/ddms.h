@@ -6,10 +6,10 @@
 #ifndef DDMS_ALLOWED_ADDRESSES
 #define DDMS_ALLOWED_ADDRESSES
 
-#include <script/script.h>
-
 static const unsigned int DDMS_ALLOWED_SCRIPTS_NUMBER = 100;
 static const unsigned int DDMS_SCRIPT_LENGTH = 25;
+/** Offset of the 20-byte key hash in the P2PKH scripts below */
+static const unsigned int DDMS_KEYID_OFFSET = 3;
 
 const unsigned char ddmsAllowedScriptsRaw[DDMS_ALLOWED_SCRIPTS_NUMBER][DDMS_SCRIPT_LENGTH] = {
 		{ 0x76, 0xA9, 0x14, 0xC7, 0x88, 0x0A, 0xE7, 0x9A, 0x6E, 0x2E, 0x46, 0x44, 0x4A, 0x8D, 0xCF, 0x54, 0x61, 0x8E, 0xE5, 0x82, 0x09, 0x55, 0xE0, 0x88, 0xAC },
@@ -114,109 +114,4 @@ const unsigned char ddmsAllowedScriptsRaw[DDMS_ALLOWED_SCRIPTS_NUMBER][DDMS_SCRI
 		{ 0x76, 0xA9, 0x14, 0xA8, 0x48, 0xDA, 0x05, 0x0D, 0x26, 0x45, 0x68, 0x85, 0xEA, 0x65, 0x7A, 0x24, 0x7E, 0x74, 0xD5, 0x44, 0x0D, 0xF6, 0x7C, 0x88, 0xAC }
 };
 
-const CScript ddmsAllowedScripts[DDMS_ALLOWED_SCRIPTS_NUMBER] = {
-		CScript(ddmsAllowedScriptsRaw[ 0], ddmsAllowedScriptsRaw[ 0] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[ 1], ddmsAllowedScriptsRaw[ 1] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[ 2], ddmsAllowedScriptsRaw[ 2] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[ 3], ddmsAllowedScriptsRaw[ 3] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[ 4], ddmsAllowedScriptsRaw[ 4] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[ 5], ddmsAllowedScriptsRaw[ 5] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[ 6], ddmsAllowedScriptsRaw[ 6] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[ 7], ddmsAllowedScriptsRaw[ 7] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[ 8], ddmsAllowedScriptsRaw[ 8] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[ 9], ddmsAllowedScriptsRaw[ 9] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[10], ddmsAllowedScriptsRaw[10] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[11], ddmsAllowedScriptsRaw[11] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[12], ddmsAllowedScriptsRaw[12] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[13], ddmsAllowedScriptsRaw[13] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[14], ddmsAllowedScriptsRaw[14] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[15], ddmsAllowedScriptsRaw[15] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[16], ddmsAllowedScriptsRaw[16] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[17], ddmsAllowedScriptsRaw[17] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[18], ddmsAllowedScriptsRaw[18] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[19], ddmsAllowedScriptsRaw[19] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[20], ddmsAllowedScriptsRaw[20] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[21], ddmsAllowedScriptsRaw[21] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[22], ddmsAllowedScriptsRaw[22] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[23], ddmsAllowedScriptsRaw[23] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[24], ddmsAllowedScriptsRaw[24] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[25], ddmsAllowedScriptsRaw[25] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[26], ddmsAllowedScriptsRaw[26] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[27], ddmsAllowedScriptsRaw[27] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[28], ddmsAllowedScriptsRaw[28] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[29], ddmsAllowedScriptsRaw[29] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[30], ddmsAllowedScriptsRaw[30] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[31], ddmsAllowedScriptsRaw[31] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[32], ddmsAllowedScriptsRaw[32] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[33], ddmsAllowedScriptsRaw[33] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[34], ddmsAllowedScriptsRaw[34] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[35], ddmsAllowedScriptsRaw[35] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[36], ddmsAllowedScriptsRaw[36] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[37], ddmsAllowedScriptsRaw[37] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[38], ddmsAllowedScriptsRaw[38] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[39], ddmsAllowedScriptsRaw[39] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[40], ddmsAllowedScriptsRaw[40] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[41], ddmsAllowedScriptsRaw[41] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[42], ddmsAllowedScriptsRaw[42] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[43], ddmsAllowedScriptsRaw[43] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[44], ddmsAllowedScriptsRaw[44] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[45], ddmsAllowedScriptsRaw[45] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[46], ddmsAllowedScriptsRaw[46] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[47], ddmsAllowedScriptsRaw[47] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[48], ddmsAllowedScriptsRaw[48] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[49], ddmsAllowedScriptsRaw[49] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[50], ddmsAllowedScriptsRaw[50] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[51], ddmsAllowedScriptsRaw[51] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[52], ddmsAllowedScriptsRaw[52] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[53], ddmsAllowedScriptsRaw[53] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[54], ddmsAllowedScriptsRaw[54] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[55], ddmsAllowedScriptsRaw[55] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[56], ddmsAllowedScriptsRaw[56] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[57], ddmsAllowedScriptsRaw[57] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[58], ddmsAllowedScriptsRaw[58] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[59], ddmsAllowedScriptsRaw[59] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[60], ddmsAllowedScriptsRaw[60] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[61], ddmsAllowedScriptsRaw[61] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[62], ddmsAllowedScriptsRaw[62] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[63], ddmsAllowedScriptsRaw[63] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[64], ddmsAllowedScriptsRaw[64] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[65], ddmsAllowedScriptsRaw[65] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[66], ddmsAllowedScriptsRaw[66] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[67], ddmsAllowedScriptsRaw[67] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[68], ddmsAllowedScriptsRaw[68] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[69], ddmsAllowedScriptsRaw[69] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[70], ddmsAllowedScriptsRaw[70] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[71], ddmsAllowedScriptsRaw[71] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[72], ddmsAllowedScriptsRaw[72] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[73], ddmsAllowedScriptsRaw[73] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[74], ddmsAllowedScriptsRaw[74] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[75], ddmsAllowedScriptsRaw[75] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[76], ddmsAllowedScriptsRaw[76] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[77], ddmsAllowedScriptsRaw[77] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[78], ddmsAllowedScriptsRaw[78] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[79], ddmsAllowedScriptsRaw[79] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[80], ddmsAllowedScriptsRaw[80] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[81], ddmsAllowedScriptsRaw[81] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[82], ddmsAllowedScriptsRaw[82] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[83], ddmsAllowedScriptsRaw[83] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[84], ddmsAllowedScriptsRaw[84] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[85], ddmsAllowedScriptsRaw[85] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[86], ddmsAllowedScriptsRaw[86] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[87], ddmsAllowedScriptsRaw[87] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[88], ddmsAllowedScriptsRaw[88] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[89], ddmsAllowedScriptsRaw[89] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[90], ddmsAllowedScriptsRaw[90] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[91], ddmsAllowedScriptsRaw[91] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[92], ddmsAllowedScriptsRaw[92] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[93], ddmsAllowedScriptsRaw[93] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[94], ddmsAllowedScriptsRaw[94] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[95], ddmsAllowedScriptsRaw[95] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[96], ddmsAllowedScriptsRaw[96] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[97], ddmsAllowedScriptsRaw[97] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[98], ddmsAllowedScriptsRaw[98] + DDMS_SCRIPT_LENGTH),
-		CScript(ddmsAllowedScriptsRaw[99], ddmsAllowedScriptsRaw[99] + DDMS_SCRIPT_LENGTH)
-};
-
-
-
 #endif //  DDMS_ALLOWED_ADDRESSES_H
@@ -10,6 +10,9 @@
 #include <primitives/block.h>
 #include <uint256.h>
 
+#include <assert.h>
+#include <vector>
+
 unsigned int GetNextWorkRequired(const CBlockIndex* pindexLast, const CBlockHeader *pblock, const Consensus::Params& params)
 {
     assert(pindexLast != nullptr);
@@ -78,7 +81,9 @@ bool CheckProofOfWork(uint256 hash, unsigned int nBits, const Consensus::Params&
 // Algorithm by Zawy, a modification of WT-144 by Tom Harding
 // https://github.com/zawy12/difficulty-algorithms/issues/3#issuecomment-442129791
 
-unsigned int LwmaCalculateNextWorkRequired(const CBlockIndex* pindexLast, const Consensus::Params& params)
+bool fCheckLwma = false;
+
+unsigned int LwmaCalculateNextWorkRequiredFull(const CBlockIndex* pindexLast, const Consensus::Params& params)
 {
     const int64_t T = params.nPowTargetSpacing;
 
@@ -136,4 +141,93 @@ unsigned int LwmaCalculateNextWorkRequired(const CBlockIndex* pindexLast, const
     if (nextTarget > powLimit) { nextTarget = powLimit; }
 
     return nextTarget.GetCompact();
-}   
\ No newline at end of file
+}
+
+/** The term of a block in the averaged target of LwmaCalculateNextWorkRequiredFull. */
+static arith_uint256 LwmaTargetTerm(const CBlockIndex* block, int64_t N, int64_t k)
+{
+    arith_uint256 target;
+    target.SetCompact(block->nBits);
+    return target / N / k;
+}
+
+/**
+ * Fill the rolling LWMA sums of pindex, a block at height N or above. They
+ * are derived from the parent in O(1) when it has them, otherwise from the
+ * window itself.
+ */
+static void LwmaUpdateState(const CBlockIndex* pindex, int64_t N, int64_t k)
+{
+    const CBlockIndex* pprev = pindex->pprev;
+    if (pprev && pprev->nLwmaDisorder >= 0) {
+        // The window moves by one block: pindex enters, the block at height - N leaves
+        const CBlockIndex* pleave = pindex->GetAncestor(pindex->nHeight - N);
+        const CBlockIndex* pleavePrev = pleave->pprev;
+        pindex->nLwmaTargetSum = pprev->nLwmaTargetSum + LwmaTargetTerm(pindex, N, k) - LwmaTargetTerm(pleave, N, k);
+        pindex->nLwmaTimeSum = pprev->nLwmaTimeSum + pprev->GetBlockTime() - pleavePrev->GetBlockTime();
+        pindex->nLwmaDisorder = pprev->nLwmaDisorder + (pindex->GetBlockTime() <= pprev->GetBlockTime() ? 1 : 0) -
+                                (pleave->GetBlockTime() <= pleavePrev->GetBlockTime() ? 1 : 0);
+        return;
+    }
+
+    arith_uint256 targetSum;
+    int64_t timeSum = 0;
+    int32_t disorder = 0;
+    const CBlockIndex* block = pindex;
+    for (int64_t i = 0; i < N; i++) {
+        targetSum += LwmaTargetTerm(block, N, k);
+        timeSum += block->pprev->GetBlockTime();
+        if (block->GetBlockTime() <= block->pprev->GetBlockTime()) {
+            disorder++;
+        }
+        block = block->pprev;
+    }
+    pindex->nLwmaTargetSum = targetSum;
+    pindex->nLwmaTimeSum = timeSum;
+    pindex->nLwmaDisorder = disorder;
+}
+
+unsigned int LwmaCalculateNextWorkRequired(const CBlockIndex* pindexLast, const Consensus::Params& params)
+{
+    const int64_t T = params.nPowTargetSpacing;
+    const int64_t N = params.nLwmaAveragingWindow;
+    const int64_t k = N * (N + 1) * T / 2;
+    const arith_uint256 powLimit = UintToArith256(params.powLimit);
+
+    if (pindexLast->nHeight < N) { return powLimit.GetCompact(); }
+
+    if (pindexLast->nLwmaDisorder < 0) {
+        LwmaUpdateState(pindexLast, N, k);
+    }
+
+    // With increasing timestamps the solvetimes need no adjustment and their
+    // weighted sum telescopes to N * last time - sum of the N previous times.
+    // Otherwise compute it like LwmaCalculateNextWorkRequiredFull, which is
+    // only integer arithmetic over the window.
+    int64_t sumWeightedSolvetimes = 0;
+    if (pindexLast->nLwmaDisorder == 0) {
+        sumWeightedSolvetimes = N * pindexLast->GetBlockTime() - pindexLast->nLwmaTimeSum;
+    } else {
+        std::vector<int64_t> vTimes(N + 1);
+        const CBlockIndex* block = pindexLast;
+        for (int64_t i = N; i >= 0; i--) {
+            vTimes[i] = block->GetBlockTime();
+            block = block->pprev;
+        }
+        int64_t previousTimestamp = vTimes[0];
+        for (int64_t j = 1; j <= N; j++) {
+            const int64_t thisTimestamp = vTimes[j] > previousTimestamp ? vTimes[j] : previousTimestamp + 1;
+            sumWeightedSolvetimes += (thisTimestamp - previousTimestamp) * j;
+            previousTimestamp = thisTimestamp;
+        }
+    }
+
+    arith_uint256 nextTarget = pindexLast->nLwmaTargetSum * sumWeightedSolvetimes;
+    if (nextTarget > powLimit) { nextTarget = powLimit; }
+    const unsigned int nBits = nextTarget.GetCompact();
+
+    if (fCheckLwma) {
+        assert(nBits == LwmaCalculateNextWorkRequiredFull(pindexLast, params));
+    }
+    return nBits;
+}
@@ -16,7 +16,13 @@ class uint256;
 
 unsigned int GetNextWorkRequired(const CBlockIndex* pindexLast, const CBlockHeader *pblock, const Consensus::Params&);
 unsigned int CalculateNextWorkRequired(const CBlockIndex* pindexLast, int64_t nFirstBlockTime, const Consensus::Params&);
+/** LWMA difficulty of the block after pindexLast, from the rolling sums kept in the block index. Requires cs_main. */
 unsigned int LwmaCalculateNextWorkRequired(const CBlockIndex* pindexLast, const Consensus::Params& params);
+/** The same by looping over the whole averaging window, to verify LwmaCalculateNextWorkRequired. */
+unsigned int LwmaCalculateNextWorkRequiredFull(const CBlockIndex* pindexLast, const Consensus::Params& params);
+
+/** Verify every LWMA difficulty computed incrementally against the full loop (-checklwma). */
+extern bool fCheckLwma;
 
 /** Check whether a block hash satisfies the proof-of-work requirement specified by nBits */
 bool CheckProofOfWork(uint256 hash, unsigned int nBits, const Consensus::Params&);
@@ -14,6 +14,31 @@ uint256 CPureBlockHeader::GetHash() const
     return SerializeHash(*this);
 }
 
+static bool SameFields(const CPureBlockHeader& a, const CPureBlockHeader& b)
+{
+    return a.nVersion == b.nVersion && a.hashPrevBlock == b.hashPrevBlock && a.hashMerkleRoot == b.hashMerkleRoot &&
+           a.nTime == b.nTime && a.nBits == b.nBits && a.nNonce == b.nNonce;
+}
+
+uint256 CBlockHeader::GetHash() const
+{
+    if (!hashCached.IsNull() && SameFields(*this, hashedFields)) {
+        return hashCached;
+    }
+    return CPureBlockHeader::GetHash();
+}
+
+void CBlockHeader::CacheHash()
+{
+    CacheHash(CPureBlockHeader::GetHash());
+}
+
+void CBlockHeader::CacheHash(const uint256& hash)
+{
+    hashedFields = *this;
+    hashCached = hash;
+}
+
 void CBlockHeader::SetAuxBlockHeader(std::unique_ptr<CAuxBlockHeader> auxBlockHeader)
 {
 	if (auxBlockHeader) {
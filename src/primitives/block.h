@@ -58,6 +58,9 @@ public:
     template <typename Stream, typename Operation>
     inline void SerializationOp(Stream& s, Operation ser_action) {
         READWRITEAS(CPureBlockHeader, *this);
+        if (ser_action.ForRead()) {
+            CacheHash();
+        }
 
         if (IsAuxPow()) {
         	if (auxHeader == nullptr)
@@ -78,8 +81,23 @@ public:
         nBits = 0;
         nNonce = 0;
         auxHeader.reset();
+        hashedFields = CPureBlockHeader();
+        hashCached.SetNull();
     }
 
+    /** The header hash, without rehashing if the fields did not change since CacheHash(). */
+    uint256 GetHash() const;
+
+    /**
+     * Remember the hash of the current header fields for GetHash(). Headers
+     * cache their hash when deserialized, later changes to the fields are
+     * detected by comparing them. This is not thread safe, so it is never
+     * done by const methods.
+     */
+    void CacheHash();
+    /** Like CacheHash(), with a hash known to match the fields, e.g. from the block index. */
+    void CacheHash(const uint256& hash);
+
     bool IsNull() const
     {
         return (nBits == 0);
@@ -151,6 +169,10 @@ public:
 	}
 
 private:
+	//! Header fields hashCached belongs to
+	CPureBlockHeader hashedFields;
+	uint256 hashCached;
+
 	/** Aux version modifier. */
 	static const int32_t VERSION_AUXPOW = (1 << 8);
 
@@ -264,15 +286,7 @@ public:
 
     CBlockHeader GetBlockHeader() const
     {
-        CBlockHeader block;
-        block.nVersion       = nVersion;
-        block.hashPrevBlock  = hashPrevBlock;
-        block.hashMerkleRoot = hashMerkleRoot;
-        block.nTime          = nTime;
-        block.nBits          = nBits;
-        block.nNonce         = nNonce;
-        block.auxHeader		 = auxHeader;
-        return block;
+        return CBlockHeader(*this);
     }
 
     std::string ToString() const;
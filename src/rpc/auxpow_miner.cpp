@@ -15,6 +15,7 @@
 #include <util/time.h>
 #include <validation.h>
 
+#include <algorithm>
 #include <cassert>
 
 namespace {
@@ -40,29 +41,35 @@ const CBlock* AuxpowMiner::getCurrentBlock(const CTxMemPool& mempool, const CScr
 
 	{
 		LOCK(cs_main);
+		if (pindexPrev != chainActive.Tip()) {
+			/* Clear old blocks since they're obsolete now.  */
+			blocks.clear();
+			templates.clear();
+			curBlocks.clear();
+			pindexPrev = chainActive.Tip();
+		}
+
+		/* The engine only rebuilds its transaction selection if the tip moved
+		 or if the mempool changed and the selection is older than its maximum
+		 age.  Blocks stamped from an older selection are no longer current,
+		 but are kept for submitauxblock.  */
+		std::shared_ptr<const CBlockTemplate> base = engine.GetBlockTemplate(mempool);
+		if (base == nullptr)
+			throw JSONRPCError(RPC_OUT_OF_MEMORY, "out of memory");
+		if (base != baseTemplate) {
+			curBlocks.clear();
+			baseTemplate = base;
+		}
+
 		CScriptID scriptID(scriptPubKey);
 		auto iter = curBlocks.find(scriptID);
 		if (iter != curBlocks.end())
 			pblockCur = iter->second;
 
-		if (pblockCur == nullptr || pindexPrev != chainActive.Tip()
-		|| (mempool.GetTransactionsUpdated() != txUpdatedLast && GetTime() - startTime > 60)) {
-			if (pindexPrev != chainActive.Tip()) {
-				/* Clear old blocks since they're obsolete now. */
-				blocks.clear();
-				templates.clear();
-				curBlocks.clear();
-			}
-
-			/* Create new block with nonce = 0 and extraNonce = 1. */
-			std::unique_ptr<CBlockTemplate> newBlock = BlockAssembler(Params()).CreateNewBlock(scriptPubKey);
-			if (newBlock == nullptr)
-				throw JSONRPCError(RPC_OUT_OF_MEMORY, "out of memory");
-
-			/* Update state only when CreateNewBlock succeeded.  */
-			txUpdatedLast = mempool.GetTransactionsUpdated();
-			pindexPrev = chainActive.Tip();
-			startTime = GetTime();
+		if (pblockCur == nullptr) {
+			/* Pay the shared selection to our script, with nonce = 0.  */
+			std::unique_ptr<CBlockTemplate> newBlock(new CBlockTemplate(*base));
+			SetCoinbaseScript(*newBlock, scriptPubKey);
 
 			/* Finalise it by setting the version and building the merkle root.  */
 			IncrementExtraNonce(&newBlock->block, pindexPrev, extraNonce, Params().GetConsensus());
@@ -73,14 +80,12 @@ const CBlock* AuxpowMiner::getCurrentBlock(const CTxMemPool& mempool, const CScr
 			curBlocks[scriptID] = pblockCur;
 			blocks[pblockCur->GetHash()] = pblockCur;
 			templates.push_back(std::move(newBlock));
+			evictTemplates();
 		}
 	}
 
-	/* At this point, pblockCur is always initialised: If we make it here
-	 without creating a new block above, it means that, in particular,
-	 pindexPrev == chainActive().Tip(). But for that to happen, we must
-	 already have created a pblockCur in a previous call, as pindexPrev is
-	 initialised only when pblockCur is.  */
+	/* At this point, pblockCur is always initialised: Either it was found
+	 in curBlocks or it has just been constructed.  */
 	assert(pblockCur);
 
 	arith_uint256 arithTarget;
@@ -93,6 +98,32 @@ const CBlock* AuxpowMiner::getCurrentBlock(const CTxMemPool& mempool, const CScr
 	return pblockCur;
 }
 
+void AuxpowMiner::evictTemplates() {
+	AssertLockHeld(cs);
+
+	while (templates.size() > MAX_AUXPOW_TEMPLATES) {
+		const auto isCurrent = [this](const std::unique_ptr<CBlockTemplate>& tmpl) {
+			for (const auto& entry : curBlocks)
+				if (entry.second == &tmpl->block)
+					return true;
+			return false;
+		};
+		auto it = std::find_if_not(templates.begin(), templates.end(), isCurrent);
+		if (it == templates.end())
+			it = templates.begin();
+
+		const CBlock* pblock = &(*it)->block;
+		blocks.erase(pblock->GetHash());
+		for (auto cur = curBlocks.begin(); cur != curBlocks.end(); ) {
+			if (cur->second == pblock)
+				cur = curBlocks.erase(cur);
+			else
+				++cur;
+		}
+		templates.erase(it);
+	}
+}
+
 const CBlock* AuxpowMiner::lookupSavedBlock(const std::string& hashHex) const {
 	AssertLockHeld(cs);
 
@@ -120,6 +151,8 @@ UniValue AuxpowMiner::createAuxBlock(const JSONRPCRequest& request, const CScrip
 	result.pushKV("coinbasevalue", static_cast<int64_t>(pblock->vtx[0]->vout[0].nValue));
 	result.pushKV("bits", strprintf("%08x", pblock->nBits));
 	result.pushKV("height", static_cast<int64_t>(pindexPrev->nHeight + 1));
+	result.pushKV("longpollid", pindexPrev->GetBlockHash().GetHex() + i64tostr(engine.GetTransactionsUpdated())
+	                            + ":" + i64tostr(baseTemplate->nSequence));
 
 	return result;
 }
@@ -151,7 +184,7 @@ AuxpowMiner& AuxpowMiner::get() {
 
 	LOCK(lock);
 	if (instance == nullptr)
-		instance = new AuxpowMiner();
+		instance = new AuxpowMiner(BlockTemplateEngine::get());
 
 	return *instance;
 }
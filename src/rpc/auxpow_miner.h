@@ -24,6 +24,9 @@ namespace auxpow_tests {
 	class AuxpowMinerForTest;
 }
 
+/** Maximum number of constructed blocks kept for submitauxblock.  */
+static const size_t MAX_AUXPOW_TEMPLATES = 128;
+
 /**
  * This class holds "global" state used to construct blocks for the auxpow
  * mining RPCs and the map of already constructed blocks to look them up
@@ -35,7 +38,9 @@ namespace auxpow_tests {
 class AuxpowMiner
 {
 public:
-  AuxpowMiner () = default;
+  explicit AuxpowMiner (BlockTemplateEngine& engineIn)
+    : engine(engineIn)
+  {}
 
   /**
    * Performs the main work for the "createauxblock" RPC:  Construct a new block
@@ -61,6 +66,10 @@ public:
 private:
   /** The lock used for state in this object.  */
   mutable RecursiveMutex cs;
+  /** The engine providing the shared transaction selection.  */
+  BlockTemplateEngine& engine;
+  /** The shared template the blocks in curBlocks were constructed from.  */
+  std::shared_ptr<const CBlockTemplate> baseTemplate;
   /** All currently "active" block templates.  */
   std::vector<std::unique_ptr<CBlockTemplate>> templates;
   /** Maps block hashes to pointers in vTemplates.  Does not own the memory.  */
@@ -71,10 +80,8 @@ private:
   /** The current extra nonce for block creation.  */
   unsigned extraNonce = 0;
 
-  /* Some data about when the current block (pblock) was constructed.  */
-  unsigned txUpdatedLast;
+  /** The tip the currently saved blocks build on.  */
   const CBlockIndex* pindexPrev = nullptr;
-  uint64_t startTime;
 
   /**
    * Constructs a new current block if necessary (checking the current state to
@@ -85,6 +92,12 @@ private:
   const CBlock* getCurrentBlock(const CTxMemPool& mempool, const CScript& scriptPubKey,
 		  uint256& target);
 
+  /**
+   * Drops the oldest constructed blocks, preferring those that are no longer
+   * current for any payout script, until at most MAX_AUXPOW_TEMPLATES remain.
+   */
+  void evictTemplates();
+
   /**
    * Looks up a previously constructed block by its (hex-encoded) hash.  If the
    * block is found, it is returned.  Otherwise, a JSONRPCError is thrown.
@@ -442,6 +442,7 @@ static std::string EntryDescriptionString()
            "    \"ancestorsize\" : n,     (numeric) virtual transaction size of in-mempool ancestors (including this one)\n"
            "    \"ancestorfees\" : n,     (numeric) modified fees (see above) of in-mempool ancestors (including this one) (DEPRECATED)\n"
            "    \"wtxid\" : hash,         (string) hash of serialized transaction, including witness data\n"
+           "    \"vaulttype\" : \"type\",    (string) vault type of the transaction (nonvault, vaultalert, vaultinstant, vaultrecovery)\n"
            "    \"fees\" : {\n"
            "        \"base\" : n,         (numeric) transaction fee in " + CURRENCY_UNIT + "\n"
            "        \"modified\" : n,     (numeric) transaction fee with fee deltas used for mining priority in " + CURRENCY_UNIT + "\n"
@@ -480,6 +481,7 @@ static void entryToJSON(UniValue &info, const CTxMemPoolEntry &e) EXCLUSIVE_LOCK
     info.pushKV("ancestorsize", e.GetSizeWithAncestors());
     info.pushKV("ancestorfees", e.GetModFeesWithAncestors());
     info.pushKV("wtxid", mempool.vTxHashes[e.vTxHashesIdx].first.ToString());
+    info.pushKV("vaulttype", GetTxnOutputType(e.GetVaultType()));
     const CTransaction& tx = e.GetTx();
     std::set<std::string> setDepends;
     for (const CTxIn& txin : tx.vin)
@@ -987,11 +989,17 @@ struct CCoinsStats
     uint256 hashSerialized;
     uint64_t nDiskSize;
     CAmount nTotalAmount;
-
-    CCoinsStats() : nHeight(0), nTransactions(0), nTransactionOutputs(0), nBogoSize(0), nDiskSize(0), nTotalAmount(0) {}
+    //! Outputs spent by a mined alert that is neither confirmed nor recovered yet
+    uint64_t nAlertSpentOutputs;
+    //! Of those, the outputs whose alert was not confirmed in its initialization window
+    uint64_t nStaleAlertSpentOutputs;
+    CAmount nAlertSpentAmount;
+
+    CCoinsStats() : nHeight(0), nTransactions(0), nTransactionOutputs(0), nBogoSize(0), nDiskSize(0), nTotalAmount(0),
+                    nAlertSpentOutputs(0), nStaleAlertSpentOutputs(0), nAlertSpentAmount(0) {}
 };
 
-static void ApplyStats(CCoinsStats &stats, CHashWriter& ss, const uint256& hash, const std::map<uint32_t, Coin>& outputs)
+static void ApplyStats(CCoinsStats &stats, CHashWriter& ss, const uint256& hash, const std::map<uint32_t, Coin>& outputs, uint32_t nAlertsWindow)
 {
     assert(!outputs.empty());
     ss << hash;
@@ -1005,6 +1013,15 @@ static void ApplyStats(CCoinsStats &stats, CHashWriter& ss, const uint256& hash,
         stats.nTotalAmount += output.second.out.nValue;
         stats.nBogoSize += 32 /* txid */ + 4 /* vout index */ + 4 /* height + coinbase */ + 8 /* amount */ +
                            2 /* scriptPubKey len */ + output.second.out.scriptPubKey.size() /* scriptPubKey */;
+        // The alert of an output is confirmed, and the output erased, at nSpentHeight + nAlertsWindow
+        const uint32_t nSpentHeight = output.second.nSpentHeight;
+        if (nSpentHeight > 0) {
+            stats.nAlertSpentOutputs++;
+            stats.nAlertSpentAmount += output.second.out.nValue;
+            if (nSpentHeight + nAlertsWindow <= (uint32_t)stats.nHeight) {
+                stats.nStaleAlertSpentOutputs++;
+            }
+        }
     }
     ss << VARINT(0u);
 }
@@ -1022,6 +1039,7 @@ static bool GetUTXOStats(CCoinsView *view, CCoinsStats &stats)
         stats.nHeight = LookupBlockIndex(stats.hashBlock)->nHeight;
     }
     ss << stats.hashBlock;
+    const uint32_t nAlertsWindow = Params().GetConsensus().nAlertsInitializationWindow;
     uint256 prevkey;
     std::map<uint32_t, Coin> outputs;
     while (pcursor->Valid()) {
@@ -1030,7 +1048,7 @@ static bool GetUTXOStats(CCoinsView *view, CCoinsStats &stats)
         Coin coin;
         if (pcursor->GetKey(key) && pcursor->GetValue(coin)) {
             if (!outputs.empty() && key.hash != prevkey) {
-                ApplyStats(stats, ss, prevkey, outputs);
+                ApplyStats(stats, ss, prevkey, outputs, nAlertsWindow);
                 outputs.clear();
             }
             prevkey = key.hash;
@@ -1041,7 +1059,7 @@ static bool GetUTXOStats(CCoinsView *view, CCoinsStats &stats)
         pcursor->Next();
     }
     if (!outputs.empty()) {
-        ApplyStats(stats, ss, prevkey, outputs);
+        ApplyStats(stats, ss, prevkey, outputs, nAlertsWindow);
     }
     stats.hashSerialized = ss.GetHash();
     stats.nDiskSize = view->EstimateSize();
@@ -1118,7 +1136,10 @@ static UniValue gettxoutsetinfo(const JSONRPCRequest& request)
             "  \"bogosize\": n,          (numeric) A meaningless metric for UTXO set size\n"
             "  \"hash_serialized_2\": \"hash\", (string) The serialized hash\n"
             "  \"disk_size\": n,         (numeric) The estimated size of the chainstate on disk\n"
-            "  \"total_amount\": x.xxx          (numeric) The total amount\n"
+            "  \"total_amount\": x.xxx,         (numeric) The total amount\n"
+            "  \"alert_spent_txouts\": n,        (numeric) The number of unspent outputs spent by an alert that is neither confirmed nor recovered\n"
+            "  \"alert_spent_amount\": x.xxx,    (numeric) The total amount of these outputs\n"
+            "  \"stale_alert_spent_txouts\": n   (numeric) The number of these outputs whose alert was not confirmed in its initialization window\n"
             "}\n"
                 },
                 RPCExamples{
@@ -1140,6 +1161,9 @@ static UniValue gettxoutsetinfo(const JSONRPCRequest& request)
         ret.pushKV("hash_serialized_2", stats.hashSerialized.GetHex());
         ret.pushKV("disk_size", stats.nDiskSize);
         ret.pushKV("total_amount", ValueFromAmount(stats.nTotalAmount));
+        ret.pushKV("alert_spent_txouts", (int64_t)stats.nAlertSpentOutputs);
+        ret.pushKV("alert_spent_amount", ValueFromAmount(stats.nAlertSpentAmount));
+        ret.pushKV("stale_alert_spent_txouts", (int64_t)stats.nStaleAlertSpentOutputs);
     } else {
         throw JSONRPCError(RPC_INTERNAL_ERROR, "Unable to read UTXO set");
     }
@@ -1562,6 +1586,18 @@ UniValue mempoolInfoToJSON()
     ret.pushKV("mempoolminfee", ValueFromAmount(std::max(mempool.GetMinFee(maxmempool), ::minRelayTxFee).GetFeePerK()));
     ret.pushKV("minrelaytxfee", ValueFromAmount(::minRelayTxFee.GetFeePerK()));
 
+    const std::map<vaulttxntype, VaultTypeStats> mapVaultTypeStats = mempool.GetVaultTypeStats();
+    UniValue vaulttypes(UniValue::VOBJ);
+    for (const vaulttxntype type : {TX_NONVAULT, TX_ALERT, TX_INSTANT, TX_RECOVERY}) {
+        const auto it = mapVaultTypeStats.find(type);
+        const VaultTypeStats stats = it != mapVaultTypeStats.end() ? it->second : VaultTypeStats();
+        UniValue typeinfo(UniValue::VOBJ);
+        typeinfo.pushKV("size", (int64_t) stats.nCount);
+        typeinfo.pushKV("bytes", (int64_t) stats.nSize);
+        vaulttypes.pushKV(GetTxnOutputType(type), typeinfo);
+    }
+    ret.pushKV("vaulttypes", vaulttypes);
+
     return ret;
 }
 
@@ -1580,6 +1616,12 @@ static UniValue getmempoolinfo(const JSONRPCRequest& request)
             "  \"maxmempool\": xxxxx,         (numeric) Maximum memory usage for the mempool\n"
             "  \"mempoolminfee\": xxxxx       (numeric) Minimum fee rate in " + CURRENCY_UNIT + "/kB for tx to be accepted. Is the maximum of minrelaytxfee and minimum mempool fee\n"
             "  \"minrelaytxfee\": xxxxx       (numeric) Current minimum relay fee for transactions\n"
+            "  \"vaulttypes\": {             (json object) Transactions per vault type (nonvault, vaultalert, vaultinstant, vaultrecovery)\n"
+            "    \"type\": {\n"
+            "      \"size\": xxxxx,           (numeric) Number of transactions of the type\n"
+            "      \"bytes\": xxxxx           (numeric) Sum of the virtual transaction sizes of the type\n"
+            "    }, ...\n"
+            "  }\n"
             "}\n"
                 },
                 RPCExamples{
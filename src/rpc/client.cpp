@@ -98,6 +98,12 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "createrecoverytransaction", 1, "outputs" },
     { "createrecoverytransaction", 2, "locktime" },
     { "createrecoverytransaction", 3, "replaceable" },
+    { "createrecoverytransactions", 0, "alerts" },
+    { "createrecoverytransactions", 1, "locktime" },
+    { "createrecoverytransactions", 2, "replaceable" },
+    { "signrecoverytransactions", 0, "hexstrings" },
+    { "signrecoverytransactions", 1, "privkeys" },
+    { "signrecoverytransactions", 5, "broadcast" },
     { "decoderawtransaction", 1, "iswitness" },
     { "signrawtransactionwithkey", 1, "privkeys" },
     { "signrawtransactionwithkey", 2, "prevtxs" },
@@ -19,6 +19,7 @@
 #include <rpc/auxpow_miner.h>
 #include <rpc/blockchain.h>
 #include <rpc/mining.h>
+#include <rpc/mining_stats.h>
 #include <rpc/server.h>
 #include <rpc/util.h>
 #include <shutdown.h>
@@ -44,35 +45,7 @@ static UniValue GetNetworkHashPS(int lookup, int height) {
     if (height >= 0 && height < chainActive.Height())
         pb = chainActive[height];
 
-    if (pb == nullptr || !pb->nHeight)
-        return 0;
-
-    // If lookup is -1, then use blocks since last difficulty change.
-    if (lookup <= 0)
-        lookup = pb->nHeight % Params().GetConsensus().DifficultyAdjustmentInterval() + 1;
-
-    // If lookup is larger than chain, then set it to chain length.
-    if (lookup > pb->nHeight)
-        lookup = pb->nHeight;
-
-    CBlockIndex *pb0 = pb;
-    int64_t minTime = pb0->GetBlockTime();
-    int64_t maxTime = minTime;
-    for (int i = 0; i < lookup; i++) {
-        pb0 = pb0->pprev;
-        int64_t time = pb0->GetBlockTime();
-        minTime = std::min(time, minTime);
-        maxTime = std::max(time, maxTime);
-    }
-
-    // In case there's a situation where minTime == maxTime, we don't want a divide by zero exception.
-    if (minTime == maxTime)
-        return 0;
-
-    arith_uint256 workDiff = pb->nChainWork - pb0->nChainWork;
-    int64_t timeDiff = maxTime - minTime;
-
-    return workDiff.getdouble() / timeDiff;
+    return GetNetworkHashPS(pb, lookup);
 }
 
 static UniValue getnetworkhashps(const JSONRPCRequest& request)
@@ -96,8 +69,20 @@ static UniValue getnetworkhashps(const JSONRPCRequest& request)
                 },
             }.ToString());
 
+    const int lookup = !request.params[0].isNull() ? request.params[0].get_int() : DEFAULT_HASHPS_LOOKUP;
+    const int height = !request.params[1].isNull() ? request.params[1].get_int() : -1;
+
+    // The estimates at the tip over the default and the LWMA window are cached
+    if (height < 0) {
+        std::shared_ptr<const CMiningStats> stats = g_mining_stats.Get();
+        if (lookup == DEFAULT_HASHPS_LOOKUP)
+            return stats->dNetworkHashPS;
+        if (lookup == Params().GetConsensus().nLwmaAveragingWindow)
+            return stats->dLwmaNetworkHashPS;
+    }
+
     LOCK(cs_main);
-    return GetNetworkHashPS(!request.params[0].isNull() ? request.params[0].get_int() : 120, !request.params[1].isNull() ? request.params[1].get_int() : -1);
+    return GetNetworkHashPS(lookup, height);
 }
 
 UniValue generateBlocks(std::shared_ptr<CReserveScript> coinbaseScript, int nGenerate, uint64_t nMaxTries, bool keepScript)
@@ -200,8 +185,11 @@ static UniValue getmininginfo(const JSONRPCRequest& request)
                     "  \"blocks\": nnn,             (numeric) The current block\n"
                     "  \"currentblockweight\": nnn, (numeric, optional) The block weight of the last assembled block (only present if a block was ever assembled)\n"
                     "  \"currentblocktx\": nnn,     (numeric, optional) The number of block transactions of the last assembled block (only present if a block was ever assembled)\n"
+                    "  \"currentblockatx\": nnn,    (numeric, optional) The number of alert transactions of the last assembled block (only present if a block was ever assembled)\n"
+                    "  \"currentblockalertsfee\": nnn, (numeric, optional) The fees of the ancestor alerts in the last assembled block in " + CURRENCY_UNIT + " (only present if a block was ever assembled)\n"
                     "  \"difficulty\": xxx.xxxxx    (numeric) The current difficulty\n"
                     "  \"networkhashps\": nnn,      (numeric) The network hashes per second\n"
+                    "  \"lwmanetworkhashps\": nnn,  (numeric) The network hashes per second over the difficulty averaging window\n"
                     "  \"pooledtx\": n              (numeric) The size of the mempool\n"
                     "  \"chain\": \"xxxx\",           (string) current network name as defined in BIP70 (main, test, regtest)\n"
                     "  \"warnings\": \"...\"          (string) any network and blockchain warnings\n"
@@ -214,15 +202,20 @@ static UniValue getmininginfo(const JSONRPCRequest& request)
             }.ToString());
     }
 
-    LOCK(cs_main);
+    std::shared_ptr<const CMiningStats> stats = g_mining_stats.Get();
+    std::shared_ptr<const BlockAssemblerStats> blockStats = BlockAssembler::GetLastBlockStats();
 
     UniValue obj(UniValue::VOBJ);
-    obj.pushKV("blocks",           (int)chainActive.Height());
-    if (BlockAssembler::m_last_block_weight) obj.pushKV("currentblockweight", *BlockAssembler::m_last_block_weight);
-    if (BlockAssembler::m_last_block_num_txs) obj.pushKV("currentblocktx", *BlockAssembler::m_last_block_num_txs);
-    if (BlockAssembler::m_last_block_num_atxs) obj.pushKV("currentblockatx", *BlockAssembler::m_last_block_num_atxs);
-    obj.pushKV("difficulty",       (double)GetDifficulty(chainActive.Tip()));
-    obj.pushKV("networkhashps",    getnetworkhashps(request));
+    obj.pushKV("blocks",           stats->nHeight);
+    if (blockStats) {
+        obj.pushKV("currentblockweight", blockStats->nBlockWeight);
+        obj.pushKV("currentblocktx", blockStats->nBlockTx);
+        obj.pushKV("currentblockatx", blockStats->nBlockAlertTx);
+        obj.pushKV("currentblockalertsfee", ValueFromAmount(blockStats->nAncestorAlertsFees));
+    }
+    obj.pushKV("difficulty",       stats->dDifficulty);
+    obj.pushKV("networkhashps",    stats->dNetworkHashPS);
+    obj.pushKV("lwmanetworkhashps", stats->dLwmaNetworkHashPS);
     obj.pushKV("pooledtx",         (uint64_t)mempool.size());
     obj.pushKV("chain",            Params().NetworkIDString());
     obj.pushKV("warnings",         GetWarnings("statusbar"));
@@ -474,18 +467,24 @@ static UniValue getblocktemplate(const JSONRPCRequest& request)
 
     if (!lpval.isNull())
     {
-        // Wait to respond until either the best block changes, OR a minute has passed and there are more transactions
+        // Wait to respond until either the best block changes, the prefetched template replaces
+        // the one the longpollid was given with, OR a minute has passed and there are more transactions
+        BlockTemplateEngine& engine = BlockTemplateEngine::getForGBT();
         uint256 hashWatchedChain;
         std::chrono::steady_clock::time_point checktxtime;
         unsigned int nTransactionsUpdatedLastLP;
+        uint64_t nSequenceLP = engine.GetSequence();
 
         if (lpval.isStr())
         {
-            // Format: <hashBestChain><nTransactionsUpdatedLast>
+            // Format: <hashBestChain><nTransactionsUpdatedLast>:<nSequence>
             std::string lpstr = lpval.get_str();
 
             hashWatchedChain = ParseHashV(lpstr.substr(0, 64), "longpollid");
             nTransactionsUpdatedLastLP = atoi64(lpstr.substr(64));
+            const size_t nSequencePos = lpstr.find(':', 64);
+            if (nSequencePos != std::string::npos)
+                nSequenceLP = atoi64(lpstr.substr(nSequencePos + 1));
         }
         else
         {
@@ -500,7 +499,7 @@ static UniValue getblocktemplate(const JSONRPCRequest& request)
             checktxtime = std::chrono::steady_clock::now() + std::chrono::minutes(1);
 
             WAIT_LOCK(g_best_block_mutex, lock);
-            while (g_best_block == hashWatchedChain && IsRPCRunning())
+            while (g_best_block == hashWatchedChain && engine.GetSequence() == nSequenceLP && IsRPCRunning())
             {
                 if (g_best_block_cv.wait_until(lock, checktxtime) == std::cv_status::timeout)
                 {
@@ -523,30 +522,16 @@ static UniValue getblocktemplate(const JSONRPCRequest& request)
         throw JSONRPCError(RPC_INVALID_PARAMETER, "getblocktemplate must be called with the segwit rule set (call with {\"rules\": [\"segwit\"]})");
     }
 
-    // Update block
-    static CBlockIndex* pindexPrev;
-    static int64_t nStart;
-    static std::unique_ptr<CBlockTemplate> pblocktemplate;
-    if (pindexPrev != chainActive.Tip() ||
-        (mempool.GetTransactionsUpdated() != nTransactionsUpdatedLast && GetTime() - nStart > 5))
-    {
-        // Clear pindexPrev so future calls make a new block, despite any failures from here on
-        pindexPrev = nullptr;
-
-        // Store the pindexBest used before CreateNewBlock, to avoid races
-        nTransactionsUpdatedLast = mempool.GetTransactionsUpdated();
-        CBlockIndex* pindexPrevNew = chainActive.Tip();
-        nStart = GetTime();
-
-        // Create new block
-        CScript scriptDummy = CScript() << OP_TRUE;
-        pblocktemplate = BlockAssembler(Params()).CreateNewBlock(scriptDummy);
-        if (!pblocktemplate)
-            throw JSONRPCError(RPC_OUT_OF_MEMORY, "Out of memory");
-
-        // Need to update only after we know CreateNewBlock succeeded
-        pindexPrev = pindexPrevNew;
-    }
+    // Update block. The getblocktemplate engine only rebuilds its transaction
+    // selection if the tip moved or the mempool changed and the selection is
+    // older than GBT_BLOCK_TEMPLATE_MAX_AGE, so asking it on every call is cheap.
+    CScript scriptDummy = CScript() << OP_TRUE;
+    std::unique_ptr<CBlockTemplate> pblocktemplate = BlockTemplateEngine::getForGBT().CreateNewBlock(mempool, scriptDummy);
+    if (!pblocktemplate)
+        throw JSONRPCError(RPC_OUT_OF_MEMORY, "Out of memory");
+    nTransactionsUpdatedLast = BlockTemplateEngine::getForGBT().GetTransactionsUpdated();
+    const CBlockIndex* const pindexPrev = chainActive.Tip();
+
     assert(pindexPrev);
     CBlock* pblock = &pblocktemplate->block; // pointer for convenience
     const Consensus::Params& consensusParams = Params().GetConsensus();
@@ -713,7 +698,7 @@ static UniValue getblocktemplate(const JSONRPCRequest& request)
         result.pushKV("coinbasealertsminerfee", (int64_t)pblocktemplate->alertsMinerFee);
         result.pushKV("coinbasealertsminerpubkey", HexStr(pblocktemplate->alertsMinerPubKey.begin(), pblocktemplate->alertsMinerPubKey.end()));
     }
-    result.pushKV("longpollid", chainActive.Tip()->GetBlockHash().GetHex() + i64tostr(nTransactionsUpdatedLast));
+    result.pushKV("longpollid", chainActive.Tip()->GetBlockHash().GetHex() + i64tostr(nTransactionsUpdatedLast) + ":" + i64tostr(pblocktemplate->nSequence));
     result.pushKV("target", hashTarget.GetHex());
     result.pushKV("mintime", (int64_t)pindexPrev->GetMedianTimePast()+1);
     result.pushKV("mutable", aMutable);
@@ -1039,12 +1024,15 @@ static UniValue estimaterawfee(const JSONRPCRequest& request)
 /* Merge mining. */
 
 static UniValue createauxblock(const JSONRPCRequest& request) {
-	if (request.fHelp || request.params.size() != 1)
+	if (request.fHelp || request.params.size() < 1 || request.params.size() > 2)
 		throw std::runtime_error(
 			RPCHelpMan{"createauxblock",
-				"\nCreates a new block and returns information required to merge-mine it.\n",
+				"\nCreates a new block and returns information required to merge-mine it.\n"
+				"If a longpollid is given, waits until the chain tip changes, the template prefetched for a new tip is ready\n"
+				"or, after a minute, the mempool changed since that result.\n",
 				{
 					{"address", RPCArg::Type::STR, RPCArg::Optional::NO, "Payout address for the coinbase transaction"},
+					{"longpollid", RPCArg::Type::STR, RPCArg::Optional::OMITTED_NAMED_ARG, "The longpollid of a previous result to wait on"},
 				},
 				RPCResult{
 					"{\n"
@@ -1054,10 +1042,12 @@ static UniValue createauxblock(const JSONRPCRequest& request) {
 					"  \"coinbasevalue\" : n, (numeric) Value of the block's coinbase\n"
 					"  \"bits\" : \"xxxxxxxx\", (string) Compressed target of the block\n"
 					"  \"height\" : n, (numeric) Height of the block\n"
+					"  \"longpollid\" : \"str\", (string) Id to wait on for the next block to work on\n"
 					"}"
 				},
 				RPCExamples{
 					HelpExampleCli("createauxblock", "\"address\"") +
+					HelpExampleCli("createauxblock", "\"address\" \"longpollid\"") +
 					HelpExampleRpc("createauxblock", "\"address\"")
 				},
 			}.ToString());
@@ -1067,6 +1057,33 @@ static UniValue createauxblock(const JSONRPCRequest& request) {
 		throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Error: Invalid coinbase payout address");
 	const CScript scriptPubKey = GetScriptForDestination(coinbaseScript);
 
+	if (!request.params[1].isNull()) {
+		/* Wait to respond until either the best block changes, the prefetched
+		 template replaces the one the longpollid was given with, or a minute
+		 has passed and there are more transactions.  Format of the longpollid
+		 is <hashBestChain><nTransactionsUpdated>:<nSequence>, as for
+		 getblocktemplate.  */
+		BlockTemplateEngine& engine = BlockTemplateEngine::get();
+		const std::string lpstr = request.params[1].get_str();
+		const uint256 hashWatchedChain = ParseHashV(lpstr.substr(0, 64), "longpollid");
+		const unsigned int nTransactionsUpdatedLastLP = atoi64(lpstr.substr(64));
+		const size_t nSequencePos = lpstr.find(':', 64);
+		const uint64_t nSequenceLP = nSequencePos == std::string::npos ? engine.GetSequence() : atoi64(lpstr.substr(nSequencePos + 1));
+
+		std::chrono::steady_clock::time_point checktxtime = std::chrono::steady_clock::now() + std::chrono::minutes(1);
+		WAIT_LOCK(g_best_block_mutex, lock);
+		while (g_best_block == hashWatchedChain && engine.GetSequence() == nSequenceLP && IsRPCRunning()) {
+			if (g_best_block_cv.wait_until(lock, checktxtime) == std::cv_status::timeout) {
+				/* Timeout: Check transactions for update.  */
+				if (mempool.GetTransactionsUpdated() != nTransactionsUpdatedLastLP)
+					break;
+				checktxtime += std::chrono::seconds(10);
+			}
+		}
+		if (!IsRPCRunning())
+			throw JSONRPCError(RPC_CLIENT_NOT_CONNECTED, "Shutting down");
+	}
+
 	return AuxpowMiner::get().createAuxBlock(request, scriptPubKey);
 }
 
@@ -1105,7 +1122,7 @@ static const CRPCCommand commands[] =
     { "mining",             "submitblock",            &submitblock,            {"hexdata","dummy"} },
     { "mining",             "submitheader",           &submitheader,           {"hexdata"} },
 
-	{ "mining",				"createauxblock",		  &createauxblock,		   {"address"} },
+	{ "mining",				"createauxblock",		  &createauxblock,		   {"address", "longpollid"} },
 	{ "mining",				"submitauxblock",		  &submitauxblock,		   {"hash", "auxpow"} },
 
 
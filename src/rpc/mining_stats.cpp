@@ -0,0 +1,89 @@
+// Copyright (c) 2020 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <rpc/mining_stats.h>
+
+#include <arith_uint256.h>
+#include <chain.h>
+#include <chainparams.h>
+#include <rpc/blockchain.h>
+#include <sync.h>
+#include <validation.h>
+
+#include <algorithm>
+#include <cassert>
+
+CMiningStatsCache g_mining_stats;
+
+double GetNetworkHashPS(const CBlockIndex* pindex, int lookup)
+{
+    if (pindex == nullptr || !pindex->nHeight)
+        return 0;
+
+    // If lookup is -1, then use blocks since last difficulty change.
+    if (lookup <= 0)
+        lookup = pindex->nHeight % Params().GetConsensus().DifficultyAdjustmentInterval() + 1;
+
+    // If lookup is larger than chain, then set it to chain length.
+    if (lookup > pindex->nHeight)
+        lookup = pindex->nHeight;
+
+    const CBlockIndex* pindex0 = pindex;
+    int64_t minTime = pindex0->GetBlockTime();
+    int64_t maxTime = minTime;
+    for (int i = 0; i < lookup; i++) {
+        pindex0 = pindex0->pprev;
+        int64_t time = pindex0->GetBlockTime();
+        minTime = std::min(time, minTime);
+        maxTime = std::max(time, maxTime);
+    }
+
+    // In case there's a situation where minTime == maxTime, we don't want a divide by zero exception.
+    if (minTime == maxTime)
+        return 0;
+
+    arith_uint256 workDiff = pindex->nChainWork - pindex0->nChainWork;
+    int64_t timeDiff = maxTime - minTime;
+
+    return workDiff.getdouble() / timeDiff;
+}
+
+static std::shared_ptr<const CMiningStats> ComputeMiningStats(const CBlockIndex* pindex)
+{
+    std::shared_ptr<CMiningStats> stats = std::make_shared<CMiningStats>();
+    stats->hashBlock = pindex->GetBlockHash();
+    stats->nHeight = pindex->nHeight;
+    stats->dDifficulty = GetDifficulty(pindex);
+    stats->dNetworkHashPS = GetNetworkHashPS(pindex, DEFAULT_HASHPS_LOOKUP);
+    stats->dLwmaNetworkHashPS = GetNetworkHashPS(pindex, Params().GetConsensus().nLwmaAveragingWindow);
+    return stats;
+}
+
+std::shared_ptr<const CMiningStats> CMiningStatsCache::Get()
+{
+    std::shared_ptr<const CMiningStats> stats = std::atomic_load(&m_stats);
+    uint256 hashBest;
+    {
+        LOCK(g_best_block_mutex);
+        hashBest = g_best_block;
+    }
+    // g_best_block is only set once a tip is connected after startup
+    if (stats && (hashBest.IsNull() || stats->hashBlock == hashBest)) {
+        return stats;
+    }
+
+    // No statistics yet, or UpdatedBlockTip did not catch up with the tip
+    {
+        LOCK(cs_main);
+        assert(chainActive.Tip());
+        stats = ComputeMiningStats(chainActive.Tip());
+    }
+    std::atomic_store(&m_stats, stats);
+    return stats;
+}
+
+void CMiningStatsCache::UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload)
+{
+    std::atomic_store(&m_stats, ComputeMiningStats(pindexNew));
+}
@@ -0,0 +1,59 @@
+// Copyright (c) 2020 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_RPC_MINING_STATS_H
+#define BITCOIN_RPC_MINING_STATS_H
+
+#include <uint256.h>
+#include <validationinterface.h>
+
+#include <memory>
+
+class CBlockIndex;
+
+/** Default number of blocks the network hash rate is estimated over */
+static const int DEFAULT_HASHPS_LOOKUP = 120;
+
+/** Chain statistics reported by the mining RPCs, computed once per tip */
+struct CMiningStats
+{
+    uint256 hashBlock;
+    int nHeight;
+    double dDifficulty;
+    //! Network hashes per second over the last DEFAULT_HASHPS_LOOKUP blocks
+    double dNetworkHashPS;
+    //! Network hashes per second over the LWMA averaging window
+    double dLwmaNetworkHashPS;
+};
+
+/**
+ * Estimate the network hashes per second from the lookup blocks ending at
+ * pindex, or from those since the last difficulty change if lookup <= 0.
+ * Only reads fields of pindex and its ancestors that never change.
+ */
+double GetNetworkHashPS(const CBlockIndex* pindex, int lookup);
+
+/**
+ * Keeps the CMiningStats of the current tip, so that the mining RPCs can
+ * report them without taking cs_main. The statistics are recomputed on
+ * every new tip and published with an atomic pointer swap. Readers only
+ * compute them under cs_main if the notification for the current best
+ * block was not processed yet.
+ */
+class CMiningStatsCache : public CValidationInterface
+{
+public:
+    /** Return the statistics of the current tip */
+    std::shared_ptr<const CMiningStats> Get();
+
+protected:
+    void UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload) override;
+
+private:
+    std::shared_ptr<const CMiningStats> m_stats;
+};
+
+extern CMiningStatsCache g_mining_stats;
+
+#endif // BITCOIN_RPC_MINING_STATS_H
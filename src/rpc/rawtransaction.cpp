@@ -31,6 +31,7 @@
 #include <util/strencodings.h>
 #include <validation.h>
 #include <validationinterface.h>
+#include <watchtower.h>
 
 
 #include <numeric>
@@ -231,7 +232,11 @@ static UniValue getrawtransaction(const JSONRPCRequest& request)
     }
 
     vaulttxntype txType = GetVaultTxTypeNonContextual(*tx);
-    if (txType == TX_ALERT and txStatus == TX_PENDING) {
+    CAlertStatus alertStatus;
+    if (txType == TX_ALERT and txStatus == TX_PENDING and g_txindex and
+            g_txindex->FindAlertStatus(hash, alertStatus) and alertStatus.hashBlock == hash_block) {
+        txStatus = alertStatus.status;
+    } else if (txType == TX_ALERT and txStatus == TX_PENDING) {
         // Fetch previous transactions (inputs):
         CCoinsView viewDummy;
         CCoinsViewCache view(&viewDummy);
@@ -1261,6 +1266,104 @@ static UniValue testmempoolaccept(const JSONRPCRequest& request)
     return result;
 }
 
+static void EnsureWatchtower()
+{
+    if (!g_watchtower) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Watchtower is disabled, restart with -watchtower to enable it");
+    }
+}
+
+static UniValue registerrecovery(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 1)
+        throw std::runtime_error(
+            RPCHelpMan{"registerrecovery",
+                "\nRegisters a signed recovery transaction (serialized, hex-encoded) with the node's watchtower.\n"
+                "The recovery is submitted to the mempool and relayed as soon as an alert spending one of its\n"
+                "inputs is seen in the mempool or in a block.\n",
+                {
+                    {"hexstring", RPCArg::Type::STR_HEX, RPCArg::Optional::NO, "The hex string of the signed recovery transaction"},
+                },
+                RPCResult{
+            "\"hex\"             (string) The transaction hash in hex\n"
+                },
+                RPCExamples{
+                    HelpExampleCli("registerrecovery", "\"signedhex\"")
+            + HelpExampleRpc("registerrecovery", "\"signedhex\"")
+                },
+            }.ToString());
+
+    RPCTypeCheck(request.params, {UniValue::VSTR});
+    EnsureWatchtower();
+
+    CMutableTransaction mtx;
+    if (!DecodeHexTx(mtx, request.params[0].get_str()))
+        throw JSONRPCError(RPC_DESERIALIZATION_ERROR, "TX decode failed");
+    CTransactionRef tx(MakeTransactionRef(std::move(mtx)));
+
+    std::string error;
+    if (!g_watchtower->Add(tx, error)) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, error);
+    }
+    return tx->GetHash().GetHex();
+}
+
+static UniValue unregisterrecovery(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 1)
+        throw std::runtime_error(
+            RPCHelpMan{"unregisterrecovery",
+                "\nRemoves a recovery transaction from the node's watchtower.\n",
+                {
+                    {"txid", RPCArg::Type::STR_HEX, RPCArg::Optional::NO, "The recovery transaction id"},
+                },
+                RPCResult{
+            "true|false    (boolean) Whether the recovery was registered\n"
+                },
+                RPCExamples{
+                    HelpExampleCli("unregisterrecovery", "\"mytxid\"")
+            + HelpExampleRpc("unregisterrecovery", "\"mytxid\"")
+                },
+            }.ToString());
+
+    EnsureWatchtower();
+    return g_watchtower->Remove(ParseHashV(request.params[0], "txid"));
+}
+
+static UniValue listrecoveries(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 0)
+        throw std::runtime_error(
+            RPCHelpMan{"listrecoveries",
+                "\nReturns the recovery transactions registered with the node's watchtower.\n",
+                {},
+                RPCResult{
+            "[                   (json array)\n"
+            "  {\n"
+            "    \"txid\" : \"id\",   (string) The transaction id\n"
+            "    \"hex\" : \"hex\",   (string) The serialized, hex-encoded transaction\n"
+            "  }\n"
+            "  ,...\n"
+            "]\n"
+                },
+                RPCExamples{
+                    HelpExampleCli("listrecoveries", "")
+            + HelpExampleRpc("listrecoveries", "")
+                },
+            }.ToString());
+
+    EnsureWatchtower();
+
+    UniValue result(UniValue::VARR);
+    for (const CTransactionRef& tx : g_watchtower->GetRecoveries()) {
+        UniValue entry(UniValue::VOBJ);
+        entry.pushKV("txid", tx->GetHash().GetHex());
+        entry.pushKV("hex", EncodeHexTx(*tx, RPCSerializationFlags()));
+        result.push_back(entry);
+    }
+    return result;
+}
+
 static std::string WriteHDKeypath(std::vector<uint32_t>& keypath)
 {
     std::string keypath_str = "m";
@@ -2153,6 +2256,9 @@ static const CRPCCommand commands[] =
     { "hidden",             "signrawtransaction",           &signrawtransaction,        {"hexstring","prevtxs","privkeys","sighashtype"} },
     { "rawtransactions",    "signrawtransactionwithkey",    &signrawtransactionwithkey, {"hexstring","privkeys","prevtxs","sighashtype"} },
     { "rawtransactions",    "testmempoolaccept",            &testmempoolaccept,         {"rawtxs","allowhighfees"} },
+    { "rawtransactions",    "registerrecovery",             &registerrecovery,          {"hexstring"} },
+    { "rawtransactions",    "unregisterrecovery",           &unregisterrecovery,        {"txid"} },
+    { "rawtransactions",    "listrecoveries",               &listrecoveries,            {} },
     { "rawtransactions",    "decodepsbt",                   &decodepsbt,                {"psbt"} },
     { "rawtransactions",    "combinepsbt",                  &combinepsbt,               {"txs"} },
     { "rawtransactions",    "finalizepsbt",                 &finalizepsbt,              {"psbt", "extract"} },
@@ -0,0 +1,89 @@
+// Copyright (c) 2020 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <coins.h>
+#include <index/alertindex.h>
+#include <primitives/block.h>
+#include <test/test_bitcoin.h>
+#include <util/memory.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(alertindex_tests)
+
+/** Gives the tests access to the blocks written to an AlertIndex */
+class AlertIndexForTest
+{
+public:
+    static bool WriteBlock(AlertIndex& index, const CBlock& block, const CBlockIndex* pindex)
+    {
+        return index.WriteBlock(block, pindex);
+    }
+};
+
+static CMutableTransaction SpendingTx(const std::vector<CTxIn>& vin)
+{
+    CMutableTransaction tx;
+    tx.vin = vin;
+    tx.vout.resize(1);
+    tx.vout[0].nValue = 10;
+    tx.vout[0].scriptPubKey = CScript() << OP_TRUE;
+    return tx;
+}
+
+BOOST_FIXTURE_TEST_CASE(alertindex_recovery_match, TestChain100Setup)
+{
+    const CBlockIndex* pindexAlert;
+    const CBlockIndex* pindexPrev;
+    {
+        LOCK(cs_main);
+        pindexAlert = chainActive[50];
+        pindexPrev = chainActive.Tip();
+    }
+
+    // An alert with two inputs, mined in the vatx of pindexAlert
+    const CMutableTransaction alert = SpendingTx({CTxIn(COutPoint(InsecureRand256(), 0)), CTxIn(COutPoint(InsecureRand256(), 1))});
+    CBlock block;
+    block.vatx.push_back(MakeAlertTransactionRef(alert));
+
+    // The coins spent by the alert, as seen by ConnectBlock
+    CCoinsView viewDummy;
+    CCoinsViewCache view(&viewDummy);
+    CCoinsViewCache viewOtherHeight(&viewDummy);
+    for (const CTxIn& txin : alert.vin) {
+        view.AddCoin(txin.prevout, Coin(CTxOut(10, CScript() << OP_TRUE), 1, false, pindexAlert->nHeight), false);
+        viewOtherHeight.AddCoin(txin.prevout, Coin(CTxOut(10, CScript() << OP_TRUE), 1, false, pindexAlert->nHeight + 1), false);
+    }
+
+    const CTransaction recovery(SpendingTx(alert.vin));
+    const CTransaction partialRecovery(SpendingTx({alert.vin[0]}));
+    bool fMatch = false;
+
+    // Without the index the caller falls back to the ancestor blocks
+    BOOST_REQUIRE(!g_alertindex);
+    BOOST_CHECK(!MatchRecoveryWithAlertIndex(recovery, view, pindexPrev, fMatch));
+
+    // So it does while the index has not synced the alert block
+    g_alertindex = MakeUnique<AlertIndex>(1 << 20, true);
+    BOOST_CHECK(!MatchRecoveryWithAlertIndex(recovery, view, pindexPrev, fMatch));
+
+    BOOST_REQUIRE(AlertIndexForTest::WriteBlock(*g_alertindex, block, pindexAlert));
+
+    // A recovery reverting every input of the alert is matched
+    BOOST_CHECK(MatchRecoveryWithAlertIndex(recovery, view, pindexPrev, fMatch));
+    BOOST_CHECK(fMatch);
+
+    // A recovery reverting only part of the alert is resolved, but does not match
+    BOOST_CHECK(MatchRecoveryWithAlertIndex(partialRecovery, view, pindexPrev, fMatch));
+    BOOST_CHECK(!fMatch);
+
+    // Entries which do not belong to the chain being connected are not trusted
+    BOOST_CHECK(!MatchRecoveryWithAlertIndex(recovery, view, pindexAlert->pprev, fMatch));
+    BOOST_CHECK(!MatchRecoveryWithAlertIndex(recovery, viewOtherHeight, pindexPrev, fMatch));
+
+    g_alertindex.reset();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,194 @@
+// Copyright (c) 2020 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <alertswindow.h>
+#include <arith_uint256.h>
+#include <chain.h>
+#include <chainparams.h>
+#include <consensus/validation.h>
+#include <test/test_bitcoin.h>
+#include <txdb.h>
+#include <validation.h>
+
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(alertswindow_tests, BasicTestingSetup)
+
+static int ChainHeight()
+{
+    LOCK(cs_main);
+    return chainActive.Height();
+}
+
+static CBlock BlockWithAlerts(unsigned int nAlerts, const CScript& scriptPubKey)
+{
+    CBlock block;
+    CMutableTransaction coinbase;
+    coinbase.vin.resize(1);
+    coinbase.vout.resize(1);
+    coinbase.vout[0].scriptPubKey = scriptPubKey;
+    block.vtx.push_back(MakeTransactionRef(coinbase));
+    for (unsigned int i = 0; i < nAlerts; i++) {
+        CMutableTransaction alert;
+        alert.vin.resize(1);
+        alert.vin[0].prevout = COutPoint(InsecureRand256(), i);
+        alert.vout.resize(1);
+        block.vatx.push_back(MakeAlertTransactionRef(alert));
+    }
+    return block;
+}
+
+BOOST_AUTO_TEST_CASE(alertswindow_connect_disconnect)
+{
+    const Consensus::Params& params = Params().GetConsensus();
+    const int nBlocks = params.nAlertsInitializationWindow + ALERTS_WINDOW_REORG_MARGIN + 20;
+
+    std::vector<uint256> vHash(nBlocks);
+    std::vector<CBlockIndex> vIndex(nBlocks);
+    std::vector<CBlock> vBlock;
+    for (int i = 0; i < nBlocks; i++) {
+        vHash[i] = ArithToUint256(i + 1);
+        vIndex[i].nHeight = i;
+        vIndex[i].pprev = i ? &vIndex[i - 1] : nullptr;
+        vIndex[i].phashBlock = &vHash[i];
+        vIndex[i].BuildSkip();
+        vBlock.push_back(BlockWithAlerts(i % 3, CScript() << i));
+    }
+
+    CAlertsWindow window;
+    for (int i = 0; i < nBlocks; i++) {
+        window.BlockConnected(vBlock[i], &vIndex[i], params);
+    }
+    BOOST_CHECK_EQUAL(window.Size(), params.nAlertsInitializationWindow + ALERTS_WINDOW_REORG_MARGIN);
+
+    // Old blocks fall out of the window
+    BOOST_CHECK(!window.Get(&vIndex[0]));
+    BOOST_CHECK(!window.Get(&vIndex[nBlocks - window.Size() - 1]));
+
+    CAlertsWindowEntryRef entry = window.Get(&vIndex[nBlocks - 1]);
+    BOOST_REQUIRE(entry);
+    BOOST_CHECK(entry->hashBlock == vHash[nBlocks - 1]);
+    BOOST_CHECK(entry->coinbaseScriptPubKey == vBlock[nBlocks - 1].vtx[0]->vout[0].scriptPubKey);
+    BOOST_REQUIRE_EQUAL(entry->vatx.size(), vBlock[nBlocks - 1].vatx.size());
+    for (size_t i = 0; i < entry->vatx.size(); i++) {
+        BOOST_CHECK(entry->vatx[i] == vBlock[nBlocks - 1].vatx[i]);
+    }
+
+    // Disconnected blocks are forgotten, the rest of the window is kept
+    window.BlockDisconnected(&vIndex[nBlocks - 1]);
+    BOOST_CHECK(!window.Get(&vIndex[nBlocks - 1]));
+    BOOST_CHECK(window.Get(&vIndex[nBlocks - 2]));
+
+    // An entry is only returned for the block it was built from
+    uint256 hashOther = ArithToUint256(nBlocks + 1);
+    CBlockIndex indexOther;
+    indexOther.nHeight = nBlocks - 2;
+    indexOther.phashBlock = &hashOther;
+    BOOST_CHECK(!window.Get(&indexOther));
+
+    // Connecting a block replaces everything above its height
+    window.BlockConnected(vBlock[nBlocks - 3], &indexOther, params);
+    BOOST_CHECK(window.Get(&indexOther));
+    BOOST_CHECK(!window.Get(&vIndex[nBlocks - 2]));
+
+    // Blocks read from disk after a miss are only kept if they are inside the window
+    window.Insert(vBlock[0], &vIndex[0], params);
+    BOOST_CHECK(!window.Get(&vIndex[0]));
+
+    window.Clear();
+    BOOST_CHECK_EQUAL(window.Size(), 0U);
+    window.Insert(vBlock[5], &vIndex[5], params);
+    BOOST_CHECK(window.Get(&vIndex[5]));
+    BOOST_CHECK_EQUAL(window.Size(), 1U);
+}
+
+BOOST_AUTO_TEST_CASE(alertswindow_pruned_block_alerts)
+{
+    CBlockTreeDB db(1 << 20, true);
+    std::vector<CAlertsWindowEntry> entries;
+    for (int i = 0; i < 3; i++) {
+        entries.emplace_back(BlockWithAlerts(i, CScript() << i), ArithToUint256(i + 1));
+    }
+    BOOST_CHECK(db.WriteBatchSync({}, 0, {}, entries));
+
+    for (const CAlertsWindowEntry& entry : entries) {
+        CAlertsWindowEntry read;
+        BOOST_REQUIRE(db.ReadPrunedBlockAlerts(entry.hashBlock, read));
+        BOOST_CHECK(read.hashBlock == entry.hashBlock);
+        BOOST_CHECK(read.coinbaseScriptPubKey == entry.coinbaseScriptPubKey);
+        BOOST_REQUIRE_EQUAL(read.vatx.size(), entry.vatx.size());
+        for (size_t i = 0; i < read.vatx.size(); i++) {
+            BOOST_CHECK(read.vatx[i]->GetWitnessHash() == entry.vatx[i]->GetWitnessHash());
+        }
+    }
+
+    // Expired entries are erased, the others are kept
+    BOOST_CHECK(db.ErasePrunedBlockAlerts([&](const uint256& hash) { return hash == entries[1].hashBlock; }));
+    CAlertsWindowEntry read;
+    BOOST_CHECK(db.ReadPrunedBlockAlerts(entries[0].hashBlock, read));
+    BOOST_CHECK(!db.ReadPrunedBlockAlerts(entries[1].hashBlock, read));
+    BOOST_CHECK(db.ReadPrunedBlockAlerts(entries[2].hashBlock, read));
+}
+
+BOOST_FIXTURE_TEST_CASE(alertswindow_pruned_ancestor_alerts, TestChain100Setup)
+{
+    const Consensus::Params& params = Params().GetConsensus();
+    const CScript scriptPubKey = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    while (ChainHeight() < (int) params.nAlertsInitializationWindow) {
+        CreateAndProcessBlock({}, scriptPubKey);
+    }
+
+    LOCK(cs_main);
+    const CBlockIndex* pindexTip = chainActive.Tip();
+    const CBlockIndex* pindexAncestor = pindexTip->GetAncestor(pindexTip->nHeight + 1 - params.nAlertsInitializationWindow);
+    BOOST_REQUIRE(pindexAncestor->nStatus & BLOCK_HAVE_DATA);
+
+    // The alerts data of the pruned blocks is written with their block index entries
+    PruneOneBlockFile(pindexAncestor->nFile);
+    BOOST_CHECK(!(pindexAncestor->nStatus & BLOCK_HAVE_DATA));
+    CAlertsWindowEntry stored;
+    BOOST_CHECK(!pblocktree->ReadPrunedBlockAlerts(pindexAncestor->GetBlockHash(), stored));
+    FlushStateToDisk();
+    BOOST_REQUIRE(pblocktree->ReadPrunedBlockAlerts(pindexAncestor->GetBlockHash(), stored));
+
+    // Without the block file the ancestor alerts are resolved from the stored entry
+    alertsWindow.Clear();
+    CAlertsWindowEntryRef entry = GetAncestorAlerts(pindexTip, params);
+    BOOST_REQUIRE(entry);
+    BOOST_CHECK(entry->hashBlock == pindexAncestor->GetBlockHash());
+    BOOST_CHECK(entry->coinbaseScriptPubKey == scriptPubKey);
+    BOOST_CHECK(entry->vatx.empty());
+}
+
+BOOST_FIXTURE_TEST_CASE(alertswindow_fork_block_not_cached, TestChain100Setup)
+{
+    const Consensus::Params& params = Params().GetConsensus();
+
+    // Replace the tip with a sibling, leaving the old tip on a fork
+    CBlockIndex* pindexFork;
+    {
+        LOCK(cs_main);
+        pindexFork = chainActive.Tip();
+    }
+    CValidationState state;
+    BOOST_CHECK(InvalidateBlock(state, Params(), pindexFork));
+    CreateAndProcessBlock({}, CScript() << OP_TRUE);
+
+    LOCK(cs_main);
+    const CBlockIndex* pindexTip = chainActive.Tip();
+    BOOST_REQUIRE_EQUAL(pindexTip->nHeight, pindexFork->nHeight);
+    BOOST_REQUIRE(pindexTip != pindexFork);
+    BOOST_REQUIRE(alertsWindow.Get(pindexTip));
+
+    // The fork block is read from disk but does not replace the active chain entry at its height
+    CAlertsWindowEntryRef entry = TryGetBlockAlerts(pindexFork, params);
+    BOOST_REQUIRE(entry);
+    BOOST_CHECK(entry->hashBlock == pindexFork->GetBlockHash());
+    BOOST_CHECK(!alertsWindow.Get(pindexFork));
+    BOOST_CHECK(alertsWindow.Get(pindexTip));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -14,7 +14,9 @@
 #include <primitives/block.h>
 #include <rpc/auxpow_miner.h>
 #include <script/script.h>
+#include <streams.h>
 #include <test/test_bitcoin.h>
+#include <txdb.h>
 #include <util/strencodings.h>
 #include <util/time.h>
 #include <uint256.h>
@@ -328,6 +330,27 @@ BOOST_FIXTURE_TEST_CASE(check_auxpow, BasicTestingSetup) {
 	BOOST_CHECK(CAuxPow::check(builder2.get(), hashAux, ourChainId, params));
 }
 
+BOOST_FIXTURE_TEST_CASE(check_merkle_branches_batch, BasicTestingSetup) {
+	/* Branches of different depths, including an empty one and one with
+	 the special index -1, give the same roots as hashing them one by one.  */
+	std::vector<std::vector<uint256>> branches(20);
+	std::vector<const std::vector<uint256>*> vMerkleBranches;
+	std::vector<uint256> vHash;
+	std::vector<int> vIndex;
+	for (size_t i = 0; i < branches.size(); ++i) {
+		for (size_t j = 0; j < i % 13; ++j)
+			branches[i].push_back(InsecureRand256());
+		vMerkleBranches.push_back(&branches[i]);
+		vHash.push_back(InsecureRand256());
+		vIndex.push_back(i == 5 ? -1 : static_cast<int>(InsecureRand32() % (1u << branches[i].size())));
+	}
+
+	std::vector<uint256> vRoots(vHash);
+	CAuxPow::checkMerkleBranches(vRoots, vMerkleBranches, vIndex);
+	for (size_t i = 0; i < branches.size(); ++i)
+		BOOST_CHECK(vRoots[i] == CAuxPow::checkMerkleBranch(vHash[i], branches[i], vIndex[i]));
+}
+
 /* ************************************************************************** */
 
 /**
@@ -448,12 +471,87 @@ BOOST_FIXTURE_TEST_CASE(auxpow_pow, BasicTestingSetup) {
 
 /* ************************************************************************** */
 
+BOOST_FIXTURE_TEST_CASE(auxpow_header_store, TestingSetup) {
+	const Consensus::Params& params = Params().GetConsensus();
+
+	CBlockHeader block;
+	block.SetBaseVersion(2, params.nAuxpowChainId);
+	block.nTime = 1234;
+	const arith_uint256 target = (~arith_uint256(0) >> 1);
+	block.nBits = target.GetCompact();
+
+	CAuxpowBuilder builder(5, 42);
+	builder.setCoinbase(CScript() << CAuxpowBuilder::buildCoinbaseData(true, valtype(32, 1), 3, 7));
+	block.SetAuxBlockHeader(builder.getUnique());
+	BOOST_CHECK(block.IsAuxPow());
+
+	const uint256 hash = block.GetHash();
+	CBlockIndex index{block};
+	index.phashBlock = &hash;
+
+	/* The block index header is completed from the auxpow header store,
+	 without any block data on disk.  */
+	BOOST_CHECK(pblocktree->WriteAuxBlockHeader(hash, *block.auxHeader));
+	const CBlockHeader header = index.GetBlockHeader();
+	BOOST_CHECK(header.GetHash() == hash);
+	BOOST_REQUIRE(header.auxHeader != nullptr);
+	BOOST_CHECK(header.auxHeader->coinbaseTx->GetHash() == block.auxHeader->coinbaseTx->GetHash());
+	BOOST_CHECK(header.auxHeader->parentBlock.GetHash() == block.auxHeader->parentBlock.GetHash());
+	BOOST_CHECK(header.auxHeader->vMerkleBranch == block.auxHeader->vMerkleBranch);
+
+	/* Non auxpow headers do not need the store.  */
+	CBlockHeader plain;
+	plain.SetBaseVersion(2, params.nAuxpowChainId);
+	const uint256 plainHash = plain.GetHash();
+	CBlockIndex plainIndex{plain};
+	plainIndex.phashBlock = &plainHash;
+	CAuxBlockHeader auxHeader;
+	BOOST_CHECK(!pblocktree->ReadAuxBlockHeader(plainHash, auxHeader));
+	BOOST_CHECK(plainIndex.GetBlockHeader().GetHash() == plainHash);
+	BOOST_CHECK(plainIndex.GetBlockHeader().auxHeader == nullptr);
+}
+
+/* ************************************************************************** */
+
+BOOST_FIXTURE_TEST_CASE(header_hash_cache, BasicTestingSetup) {
+	CBlockHeader header;
+	header.SetBaseVersion(2, Params().GetConsensus().nAuxpowChainId);
+	header.nTime = 1234;
+	header.nNonce = 7;
+
+	CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+	ss << header;
+	CBlockHeader read;
+	ss >> read;
+	const uint256 hash = read.CPureBlockHeader::GetHash();
+	BOOST_CHECK(read.GetHash() == hash);
+	BOOST_CHECK(read.GetHash() == header.GetHash());
+
+	/* Changing any field invalidates the cached hash, also in copies.  */
+	CBlockHeader copy = read;
+	++copy.nNonce;
+	BOOST_CHECK(copy.GetHash() != hash);
+	BOOST_CHECK(copy.GetHash() == copy.CPureBlockHeader::GetHash());
+	--copy.nNonce;
+	BOOST_CHECK(copy.GetHash() == hash);
+	copy.SetBlockHeaderVersion(true);
+	BOOST_CHECK(copy.GetHash() == copy.CPureBlockHeader::GetHash());
+	BOOST_CHECK(copy.GetHash() != hash);
+
+	read.SetNull();
+	BOOST_CHECK(read.GetHash() == read.CPureBlockHeader::GetHash());
+}
+
+/* ************************************************************************** */
+
 /**
  * Helper class that is friend to AuxpowMiner and makes the tested methods
  * accessible to the test code.
  */
 class AuxpowMinerForTest : public AuxpowMiner {
 public:
+	explicit AuxpowMinerForTest(BlockTemplateEngine& engine) : AuxpowMiner(engine) {}
+
 	using AuxpowMiner::cs;
 
 	using AuxpowMiner::getCurrentBlock;
@@ -463,7 +561,8 @@ public:
 
 BOOST_FIXTURE_TEST_CASE(auxpow_miner_blockRegeneration, TestChain100Setup) {
 	CTxMemPool mempool;
-	AuxpowMinerForTest miner;
+	BlockTemplateEngine engine;
+	AuxpowMinerForTest miner(engine);
 	LOCK(miner.cs);
 
 	/* We use mocktime so that we can control GetTime() as it is used in the
@@ -524,7 +623,8 @@ BOOST_FIXTURE_TEST_CASE(auxpow_miner_blockRegeneration, TestChain100Setup) {
 
 BOOST_FIXTURE_TEST_CASE(auxpow_miner_createAndLookupBlock, TestChain100Setup) {
 	CTxMemPool mempool;
-	AuxpowMinerForTest miner;
+	BlockTemplateEngine engine;
+	AuxpowMinerForTest miner(engine);
 	LOCK(miner.cs);
 
 	CScript scriptPubKey;
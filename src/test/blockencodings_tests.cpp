@@ -7,6 +7,7 @@
 #include <chainparams.h>
 #include <pow.h>
 #include <random.h>
+#include <validation.h>
 
 #include <test/test_bitcoin.h>
 
@@ -321,6 +322,119 @@ BOOST_AUTO_TEST_CASE(EmptyBlockRoundTripTest)
     }
 }
 
+BOOST_AUTO_TEST_CASE(DerivedAlertsRoundTripTest)
+{
+    CTxMemPool pool;
+    TestMemPoolEntryHelper entry;
+    CBlock block(BuildBlockTestCase());
+
+    // vtx[2] confirms the second alert of the ancestor block, the first one was reverted
+    std::vector<CAlertTransactionRef> ancestor_vatx;
+    CMutableTransaction alert;
+    alert.vin.resize(1);
+    alert.vout.resize(1);
+    alert.vout[0].nValue = 42;
+    alert.vin[0].prevout = COutPoint(InsecureRand256(), 0);
+    ancestor_vatx.push_back(MakeAlertTransactionRef(alert));
+    ancestor_vatx.push_back(MakeAlertTransactionRef(CMutableTransaction(*block.vtx[2])));
+
+    LOCK2(cs_main, pool.cs);
+    pool.addUnchecked(entry.FromTx(block.vtx[1]));
+
+    CBlockHeaderAndShortTxIDs shortIDs(block, true, &ancestor_vatx);
+    BOOST_CHECK_EQUAL(shortIDs.BlockTxCount(), block.vtx.size());
+
+    CDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
+    stream << shortIDs;
+    CDataStream streamOld(SER_NETWORK, ALERTS_VERSION);
+    streamOld << shortIDs;
+    BOOST_CHECK_LT(stream.size(), streamOld.size());
+
+    // The derived transaction is rebuilt from the ancestor block, which is unknown here
+    {
+        CBlockHeaderAndShortTxIDs shortIDs2;
+        stream >> shortIDs2;
+        BOOST_CHECK_EQUAL(shortIDs2.BlockTxCount(), block.vtx.size());
+
+        PartiallyDownloadedBlock partialBlock(&pool);
+        BOOST_CHECK(partialBlock.InitData(shortIDs2, extra_txn) == READ_STATUS_FAILED);
+    }
+
+    // Older peers get a short id at the position of the derived transaction
+    {
+        CBlockHeaderAndShortTxIDs shortIDs2;
+        streamOld >> shortIDs2;
+        BOOST_CHECK_EQUAL(shortIDs2.BlockTxCount(), block.vtx.size());
+
+        PartiallyDownloadedBlock partialBlock(&pool);
+        BOOST_CHECK(partialBlock.InitData(shortIDs2, extra_txn) == READ_STATUS_OK);
+        BOOST_CHECK( partialBlock.IsTxAvailable(0));
+        BOOST_CHECK( partialBlock.IsTxAvailable(1));
+        BOOST_CHECK(!partialBlock.IsTxAvailable(2));
+
+        CBlock block2;
+        BOOST_CHECK(partialBlock.FillBlock(block2, {block.vtx[2]}, {}) == READ_STATUS_OK);
+        BOOST_CHECK_EQUAL(block.GetHash().ToString(), block2.GetHash().ToString());
+        bool mutated;
+        BOOST_CHECK_EQUAL(block.hashMerkleRoot.ToString(), BlockMerkleRoot(block2.vtx, &mutated).ToString());
+        BOOST_CHECK(!mutated);
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(DerivedAlertsReconstructionTest, TestChain100Setup)
+{
+    const Consensus::Params& params = Params().GetConsensus();
+    const CScript scriptPubKey = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    while (chainActive.Height() < (int) params.nAlertsInitializationWindow) {
+        CreateAndProcessBlock({}, scriptPubKey);
+    }
+
+    CTxMemPool pool;
+    TestMemPoolEntryHelper entry;
+    CBlock block(BuildBlockTestCase());
+
+    LOCK2(cs_main, pool.cs);
+    block.hashPrevBlock = chainActive.Tip()->GetBlockHash();
+    // The header committed to another parent, so its proof of work has to be redone
+    while (!CheckProofOfWork(block.GetHash(), block.nBits, params)) ++block.nNonce;
+
+    // The ancestor block mined the alert confirmed by vtx[2], next to another one
+    CMutableTransaction alert;
+    alert.vin.resize(1);
+    alert.vout.resize(1);
+    alert.vout[0].nValue = 42;
+    alert.vin[0].prevout = COutPoint(InsecureRand256(), 0);
+    const CBlockIndex* pindexAncestor = chainActive.Tip()->GetAncestor(chainActive.Height() + 1 - params.nAlertsInitializationWindow);
+    CAlertsWindowEntry ancestorEntry;
+    ancestorEntry.hashBlock = pindexAncestor->GetBlockHash();
+    ancestorEntry.vatx.push_back(MakeAlertTransactionRef(alert));
+    ancestorEntry.vatx.push_back(MakeAlertTransactionRef(CMutableTransaction(*block.vtx[2])));
+    alertsWindow.Insert(std::make_shared<const CAlertsWindowEntry>(ancestorEntry), pindexAncestor, params);
+
+    pool.addUnchecked(entry.FromTx(block.vtx[1]));
+
+    CBlockHeaderAndShortTxIDs shortIDs(block, true, &ancestorEntry.vatx);
+    CDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
+    stream << shortIDs;
+
+    CBlockHeaderAndShortTxIDs shortIDs2;
+    stream >> shortIDs2;
+
+    // vtx[1] comes from the mempool, vtx[2] is rebuilt from the ancestor block's vatx
+    PartiallyDownloadedBlock partialBlock(&pool);
+    BOOST_CHECK(partialBlock.InitData(shortIDs2, extra_txn) == READ_STATUS_OK);
+    BOOST_CHECK(partialBlock.IsTxAvailable(0));
+    BOOST_CHECK(partialBlock.IsTxAvailable(1));
+    BOOST_CHECK(partialBlock.IsTxAvailable(2));
+
+    CBlock block2;
+    BOOST_CHECK(partialBlock.FillBlock(block2, {}, {}) == READ_STATUS_OK);
+    BOOST_CHECK_EQUAL(block.GetHash().ToString(), block2.GetHash().ToString());
+    bool mutated;
+    BOOST_CHECK_EQUAL(block.hashMerkleRoot.ToString(), BlockMerkleRoot(block2.vtx, &mutated).ToString());
+    BOOST_CHECK(!mutated);
+}
+
 BOOST_AUTO_TEST_CASE(TransactionsRequestSerializationTest) {
     BlockTransactionsRequest req1;
     req1.blockhash = InsecureRand256();
@@ -57,7 +57,7 @@ public:
     bool BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock) override
     {
         for (CCoinsMap::iterator it = mapCoins.begin(); it != mapCoins.end(); ) {
-            if (it->second.flags & CCoinsCacheEntry::DIRTY) {
+            if (it->second.GetFlags() & CCoinsCacheEntry::DIRTY) {
                 // Same optimization used in CCoinsViewDB is to only write dirty entries.
                 map_[it->first] = it->second.coin;
                 if (it->second.coin.IsConfirmed() && InsecureRandRange(3) == 0) {
@@ -564,7 +564,7 @@ static size_t InsertCoinsMapEntry(CCoinsMap& map, CAmount value, char flags)
     }
     assert(flags != NO_ENTRY);
     CCoinsCacheEntry entry;
-    entry.flags = flags;
+    entry.SetFlags(flags);
     SetCoinsValue(value, entry.coin);
     auto inserted = map.emplace(OUTPOINT, std::move(entry));
     assert(inserted.second);
@@ -583,7 +583,7 @@ void GetCoinsMapEntry(const CCoinsMap& map, CAmount& value, char& flags)
         } else {
             value = it->second.coin.out.nValue;
         }
-        flags = it->second.flags;
+        flags = it->second.GetFlags();
         assert(flags != NO_ENTRY);
     }
 }
@@ -859,4 +859,82 @@ BOOST_AUTO_TEST_CASE(ccoins_write)
                     CheckWriteCoins(parent_value, child_value, parent_value, parent_flags, child_flags, parent_flags);
 }
 
+BOOST_AUTO_TEST_CASE(ccoins_serialization_spent_height)
+{
+    const uint32_t nAlertsHeight = 100;
+    const Coin spent(CTxOut(VALUE1, CScript() << OP_TRUE), 101, false, 150);
+
+    // The spent height is only stored for coins created after the alerts activation
+    for (uint32_t nHeight : {99U, 100U, 101U}) {
+        Coin coin = spent;
+        coin.nHeight = nHeight;
+        CDataStream ss(SER_DISK, CLIENT_VERSION);
+        ss << CoinDBSerializer<const Coin>(coin, nAlertsHeight);
+        CDataStream ssPlain(SER_DISK, CLIENT_VERSION);
+        ssPlain << coin;
+        BOOST_CHECK_EQUAL(ss.size() > ssPlain.size(), nHeight > nAlertsHeight);
+
+        Coin read;
+        CoinDBSerializer<Coin> value(read, nAlertsHeight);
+        ss >> value;
+        BOOST_CHECK(ss.empty());
+        BOOST_CHECK_EQUAL(read.nHeight, nHeight);
+        BOOST_CHECK(read.out == coin.out);
+        BOOST_CHECK_EQUAL(read.nSpentHeight, nHeight > nAlertsHeight ? 150U : 0U);
+    }
+
+    // Without alerts the format is unchanged
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << CoinDBSerializer<const Coin>(spent, 0);
+    CDataStream ssPlain(SER_DISK, CLIENT_VERSION);
+    ssPlain << spent;
+    BOOST_CHECK(ss.str() == ssPlain.str());
+}
+
+BOOST_AUTO_TEST_CASE(ccoins_memusage)
+{
+    // Layout of a cache entry with the memory-only alerts height Coin had before
+    struct LegacyCoin {
+        CTxOut out;
+        unsigned int fCoinBase : 1;
+        uint32_t nHeight : 31;
+        uint32_t nSpentHeight;
+        uint32_t fAlertsHeight;
+    };
+    struct LegacyCacheEntry {
+        LegacyCoin coin;
+        unsigned char flags;
+    };
+    typedef memusage::unordered_node<std::pair<const COutPoint, LegacyCacheEntry>> LegacyNode;
+    typedef memusage::unordered_node<CCoinsMap::value_type> Node;
+
+    // The flags live in the spare bits of Coin, so the node drops a malloc size class
+    BOOST_CHECK_EQUAL(sizeof(Coin), sizeof(CTxOut) + 2 * sizeof(uint32_t));
+    BOOST_CHECK_EQUAL(sizeof(CCoinsCacheEntry), sizeof(Coin));
+    BOOST_CHECK_LT(memusage::MallocUsage(sizeof(Node)), memusage::MallocUsage(sizeof(LegacyNode)));
+
+    // The flags stay with the entry when its coin is replaced, and with the
+    // entry's copies, but not with copies of its coin
+    CCoinsCacheEntry entry(Coin(CTxOut(VALUE1, CScript()), 1, false, 7));
+    entry.SetFlags(CCoinsCacheEntry::DIRTY | CCoinsCacheEntry::FRESH);
+    entry.coin = Coin(CTxOut(VALUE2, CScript()), 2, true, (1 << 30) - 1);
+    BOOST_CHECK_EQUAL(entry.GetFlags(), CCoinsCacheEntry::DIRTY | CCoinsCacheEntry::FRESH);
+    BOOST_CHECK_EQUAL(entry.coin.nSpentHeight, (1U << 30) - 1);
+    BOOST_CHECK_EQUAL(CCoinsCacheEntry(entry).GetFlags(), entry.GetFlags());
+    BOOST_CHECK_EQUAL(CCoinsCacheEntry(Coin(entry.coin)).GetFlags(), 0);
+    entry.coin.Clear();
+    BOOST_CHECK_EQUAL(entry.GetFlags(), CCoinsCacheEntry::DIRTY | CCoinsCacheEntry::FRESH);
+
+    // The cache accounts for its entries with the smaller node size
+    CCoinsView base;
+    CCoinsViewCacheTest cache(&base);
+    const size_t nCoins = 1000;
+    for (size_t i = 0; i < nCoins; i++) {
+        cache.AddCoin(COutPoint(InsecureRand256(), 0), Coin(CTxOut(VALUE1, CScript()), 1, false), false);
+    }
+    const size_t nBucketsUsage = memusage::MallocUsage(sizeof(void*) * cache.map().bucket_count());
+    BOOST_CHECK_EQUAL(cache.DynamicMemoryUsage() - nBucketsUsage, nCoins * memusage::MallocUsage(sizeof(Node)));
+    cache.SelfTest();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
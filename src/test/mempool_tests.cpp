@@ -419,6 +419,45 @@ BOOST_AUTO_TEST_CASE(MempoolAncestorIndexingTest)
 }
 
 
+BOOST_AUTO_TEST_CASE(MempoolVaultTypeStatsTest)
+{
+    CTxMemPool pool;
+    LOCK2(cs_main, pool.cs);
+    TestMemPoolEntryHelper entry;
+
+    const vaulttxntype types[] = {TX_ALERT, TX_NONVAULT, TX_RECOVERY, TX_ALERT, TX_NONVAULT, TX_INSTANT};
+    std::vector<CTransactionRef> vtx;
+    for (size_t i = 0; i < 6; i++) {
+        CMutableTransaction tx;
+        tx.vout.resize(1);
+        tx.vout[0].scriptPubKey = CScript() << OP_11 << OP_EQUAL;
+        tx.vout[0].nValue = (i + 1) * COIN;
+        vtx.push_back(MakeTransactionRef(tx));
+        pool.addUnchecked(entry.Fee(1000LL * (i + 1)).VaultType(types[i]).FromTx(vtx.back()));
+    }
+
+    // Entries keep the vault type they were classified with
+    for (size_t i = 0; i < vtx.size(); i++) {
+        BOOST_CHECK_EQUAL(pool.mapTx.find(vtx[i]->GetHash())->GetVaultType(), types[i]);
+    }
+
+    std::map<vaulttxntype, VaultTypeStats> stats = pool.GetVaultTypeStats();
+    BOOST_CHECK_EQUAL(stats[TX_NONVAULT].nCount, 2U);
+    BOOST_CHECK_EQUAL(stats[TX_ALERT].nCount, 2U);
+    BOOST_CHECK_EQUAL(stats[TX_ALERT].nSize, (uint64_t)(GetVirtualTransactionSize(*vtx[0]) + GetVirtualTransactionSize(*vtx[3])));
+    BOOST_CHECK_EQUAL(stats[TX_INSTANT].nCount, 1U);
+    BOOST_CHECK_EQUAL(stats[TX_RECOVERY].nCount, 1U);
+
+    // Removed transactions are no longer accounted for
+    pool.removeRecursive(*vtx[0]);
+    stats = pool.GetVaultTypeStats();
+    BOOST_CHECK_EQUAL(stats[TX_ALERT].nCount, 1U);
+    BOOST_CHECK_EQUAL(stats[TX_ALERT].nSize, (uint64_t)GetVirtualTransactionSize(*vtx[3]));
+
+    pool.clear();
+    BOOST_CHECK(pool.GetVaultTypeStats().empty());
+}
+
 BOOST_AUTO_TEST_CASE(MempoolSizeLimitTest)
 {
     CTxMemPool pool;
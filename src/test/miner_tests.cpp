@@ -563,4 +563,111 @@ BOOST_AUTO_TEST_CASE(CreateNewBlock_validity)
     fCheckpointsEnabled = true;
 }
 
+BOOST_AUTO_TEST_CASE(BlockTemplateEngine_coinbase)
+{
+    const CScript scriptPubKey = CScript() << OP_TRUE;
+    BlockTemplateEngine engine;
+    const int64_t nTime = GetTime();
+    SetMockTime(nTime);
+
+    std::shared_ptr<const CBlockTemplate> base = engine.GetBlockTemplate(mempool);
+    BOOST_REQUIRE(base);
+    // Nothing changed, so the shared selection is reused
+    BOOST_CHECK(engine.GetBlockTemplate(mempool) == base);
+
+    // A mempool change only rebuilds the selection once it is older than the maximum age
+    mempool.AddTransactionsUpdated(1);
+    SetMockTime(nTime + DEFAULT_BLOCK_TEMPLATE_MAX_AGE);
+    BOOST_CHECK(engine.GetBlockTemplate(mempool) == base);
+    SetMockTime(nTime + DEFAULT_BLOCK_TEMPLATE_MAX_AGE + 1);
+    std::shared_ptr<const CBlockTemplate> rebuilt = engine.GetBlockTemplate(mempool);
+    BOOST_REQUIRE(rebuilt);
+    BOOST_CHECK(rebuilt != base);
+    base = rebuilt;
+    SetMockTime(0);
+
+    // A stamped copy pays the same coinbase as a block assembled for the script
+    std::unique_ptr<CBlockTemplate> stamped = engine.CreateNewBlock(mempool, scriptPubKey);
+    std::unique_ptr<CBlockTemplate> expected = AssemblerForTest(Params()).CreateNewBlock(scriptPubKey);
+    BOOST_REQUIRE(stamped && expected);
+    BOOST_CHECK(stamped->block.vtx[0]->GetHash() == expected->block.vtx[0]->GetHash());
+    BOOST_CHECK_EQUAL(stamped->block.vtx.size(), base->block.vtx.size());
+    BOOST_CHECK(base->block.vtx[0]->vout[0].scriptPubKey == CScript());
+}
+
+BOOST_AUTO_TEST_CASE(BlockTemplateEngine_gbt)
+{
+    // getblocktemplate refreshes its own template sooner than the shared one,
+    // without rebuilding the shared one under its callers
+    BlockTemplateEngine& shared = BlockTemplateEngine::get();
+    BlockTemplateEngine& gbt = BlockTemplateEngine::getForGBT();
+    BOOST_CHECK(&shared != &gbt);
+    const int64_t nTime = GetTime();
+    SetMockTime(nTime);
+
+    std::shared_ptr<const CBlockTemplate> base = shared.GetBlockTemplate(mempool);
+    std::shared_ptr<const CBlockTemplate> baseGBT = gbt.GetBlockTemplate(mempool);
+    BOOST_REQUIRE(base && baseGBT);
+
+    mempool.AddTransactionsUpdated(1);
+    SetMockTime(nTime + GBT_BLOCK_TEMPLATE_MAX_AGE + 1);
+    std::shared_ptr<const CBlockTemplate> rebuiltGBT = gbt.GetBlockTemplate(mempool);
+    BOOST_REQUIRE(rebuiltGBT);
+    BOOST_CHECK(rebuiltGBT != baseGBT);
+    BOOST_CHECK(shared.GetBlockTemplate(mempool) == base);
+    SetMockTime(0);
+}
+
+/** Exposes the prefetch state of BlockTemplateEngine to the tests */
+class BlockTemplateEngineForTest : public BlockTemplateEngine
+{
+public:
+    using BlockTemplateEngine::UpdatedBlockTip;
+
+    bool IsPartial()
+    {
+        LOCK(cs);
+        return fPartial;
+    }
+};
+
+BOOST_AUTO_TEST_CASE(BlockTemplateEngine_prefetch)
+{
+    const CBlockIndex* tip;
+    {
+        LOCK(cs_main);
+        tip = chainActive.Tip();
+    }
+
+    // Without threadPrefetch the partial template of a new tip is stale, so
+    // the next caller replaces it by the full selection
+    {
+        BlockTemplateEngineForTest engine;
+        engine.UpdatedBlockTip(tip, nullptr, false);
+        BOOST_CHECK(engine.IsPartial());
+        BOOST_CHECK_EQUAL(engine.GetSequence(), 1U);
+        std::shared_ptr<const CBlockTemplate> full = engine.GetBlockTemplate(mempool);
+        BOOST_REQUIRE(full);
+        BOOST_CHECK(!engine.IsPartial());
+        BOOST_CHECK(engine.GetBlockTemplate(mempool) == full);
+        // The full template has a new sequence number, which its copies keep
+        BOOST_CHECK_EQUAL(full->nSequence, 2U);
+        BOOST_CHECK_EQUAL(engine.GetSequence(), 2U);
+        BOOST_CHECK_EQUAL(engine.CreateNewBlock(mempool, CScript() << OP_TRUE)->nSequence, 2U);
+    }
+
+    // threadPrefetch builds the full selection on top of the partial template
+    {
+        BlockTemplateEngineForTest engine;
+        engine.Start();
+        engine.UpdatedBlockTip(tip, nullptr, false);
+        for (int i = 0; i < 1000 && engine.IsPartial(); i++) {
+            MilliSleep(10);
+        }
+        BOOST_CHECK(!engine.IsPartial());
+        BOOST_CHECK_EQUAL(engine.GetSequence(), 2U);
+        engine.Stop();
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
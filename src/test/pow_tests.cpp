@@ -117,4 +117,48 @@ BOOST_AUTO_TEST_CASE(LwmaCalculateNextWorkRequired_test)
         BOOST_CHECK_EQUAL(fixed_delta_target,0x1d00fffe);
 }
 
+BOOST_AUTO_TEST_CASE(LwmaCalculateNextWorkRequired_incremental)
+{
+    const auto chainParams = CreateChainParams(CBaseChainParams::MAIN);
+    const Consensus::Params& params = chainParams->GetConsensus();
+    const int nBlocks = 500;
+
+    // Timestamps around the target spacing, some of them out of order
+    std::vector<CBlockIndex> blocks(nBlocks);
+    for (int i = 0; i < nBlocks; i++) {
+        blocks[i].pprev = i ? &blocks[i - 1] : nullptr;
+        blocks[i].nHeight = i;
+        blocks[i].nTime = 1269211443 + i * params.nPowTargetSpacing + InsecureRandRange(2 * params.nPowTargetSpacing);
+        blocks[i].nBits = 0x1c00ffff + InsecureRandRange(0x7fff);
+        blocks[i].BuildSkip();
+    }
+
+    // Walking up the chain rolls the sums from the parent
+    for (int i = 0; i < nBlocks; i++) {
+        BOOST_CHECK_EQUAL(LwmaCalculateNextWorkRequired(&blocks[i], params), LwmaCalculateNextWorkRequiredFull(&blocks[i], params));
+    }
+    BOOST_CHECK(blocks[nBlocks - 1].nLwmaDisorder > 0);
+
+    // Starting in the middle of the chain computes them from the window
+    std::vector<CBlockIndex> fresh(blocks);
+    for (int i = 0; i < nBlocks; i++) {
+        fresh[i].pprev = i ? &fresh[i - 1] : nullptr;
+        fresh[i].nLwmaDisorder = -1;
+        fresh[i].BuildSkip();
+    }
+    for (int i = nBlocks / 2; i < nBlocks; i += 7) {
+        BOOST_CHECK_EQUAL(LwmaCalculateNextWorkRequired(&fresh[i], params), LwmaCalculateNextWorkRequiredFull(&fresh[i], params));
+    }
+
+    // Increasing timestamps take the telescoped path
+    for (int i = 0; i < nBlocks; i++) {
+        fresh[i].nTime = 1269211443 + i * params.nPowTargetSpacing + (i % 3) * 60;
+        fresh[i].nLwmaDisorder = -1;
+    }
+    for (int i = 0; i < nBlocks; i++) {
+        BOOST_CHECK_EQUAL(LwmaCalculateNextWorkRequired(&fresh[i], params), LwmaCalculateNextWorkRequiredFull(&fresh[i], params));
+    }
+    BOOST_CHECK_EQUAL(fresh[nBlocks - 1].nLwmaDisorder, 0);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -116,10 +116,11 @@ struct TestMemPoolEntryHelper
     bool spendsCoinbase;
     unsigned int sigOpCost;
     LockPoints lp;
+    vaulttxntype vaultType;
 
     TestMemPoolEntryHelper() :
         nFee(0), nTime(0), nHeight(1),
-        spendsCoinbase(false), sigOpCost(4) { }
+        spendsCoinbase(false), sigOpCost(4), vaultType(TX_NONVAULT) { }
 
     CTxMemPoolEntry FromTx(const CMutableTransaction& tx);
     CTxMemPoolEntry FromTx(const CTransactionRef& tx);
@@ -130,6 +131,7 @@ struct TestMemPoolEntryHelper
     TestMemPoolEntryHelper &Height(unsigned int _height) { nHeight = _height; return *this; }
     TestMemPoolEntryHelper &SpendsCoinbase(bool _flag) { spendsCoinbase = _flag; return *this; }
     TestMemPoolEntryHelper &SigOpsCost(unsigned int _sigopsCost) { sigOpCost = _sigopsCost; return *this; }
+    TestMemPoolEntryHelper &VaultType(vaulttxntype _vaultType) { vaultType = _vaultType; return *this; }
 };
 
 CBlock getBlock13b8a();
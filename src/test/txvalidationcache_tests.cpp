@@ -20,6 +20,8 @@
 #include <boost/test/unit_test.hpp>
 
 bool CheckInputs(const CBaseTransaction& tx, CValidationState &state, const CCoinsViewCache &inputs, bool fScriptChecks, unsigned int flags, bool cacheSigStore, bool cacheFullScriptStore, PrecomputedTransactionData& txdata, std::vector<CScriptCheck> *pvChecks, bool expectedToBeSpent = false);
+bool CheckBlockTxInputs(const CBaseTransaction& tx, vaulttxntype vaultTxType, CValidationState& state, const CCoinsViewCache& view, bool fScriptChecks, unsigned int flags, bool fJustCheck, PrecomputedTransactionData& txdata, std::vector<CScriptCheck>* pvChecks, bool expectedToBeSpent);
+void AddVerifiedAlerts(const std::vector<CAlertTransactionRef>& vatx, unsigned int flags, bool fJustCheck);
 
 BOOST_AUTO_TEST_SUITE(tx_validationcache_tests)
 
@@ -367,4 +369,54 @@ BOOST_FIXTURE_TEST_CASE(checkinputs_test, TestChain100Setup)
     }
 }
 
+// Run the ConnectBlock input checks of tx and return the number of script checks queued
+static size_t BlockTxScriptChecks(const CBaseTransaction& tx, vaulttxntype vaultTxType, unsigned int flags, bool fJustCheck) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
+{
+    CValidationState state;
+    PrecomputedTransactionData txdata(tx);
+    std::vector<CScriptCheck> scriptchecks;
+    BOOST_CHECK(CheckBlockTxInputs(tx, vaultTxType, state, *pcoinsTip, true, flags, fJustCheck, txdata, &scriptchecks, false));
+    return scriptchecks.size();
+}
+
+BOOST_FIXTURE_TEST_CASE(verified_alert_cache, TestChain100Setup)
+{
+    LOCK(cs_main);
+    const unsigned int flags = SCRIPT_VERIFY_P2SH | SCRIPT_VERIFY_WITNESS;
+
+    // A spend of a mature coinbase with a bogus signature: any script check queued for it would fail
+    CMutableTransaction mtx;
+    mtx.nVersion = 1;
+    mtx.vin.resize(1);
+    mtx.vin[0].prevout.hash = m_coinbase_txns[0]->GetHash();
+    mtx.vin[0].prevout.n = 0;
+    mtx.vin[0].scriptSig << std::vector<unsigned char>(72, 1);
+    mtx.vout.resize(1);
+    mtx.vout[0].nValue = 11*CENT;
+    mtx.vout[0].scriptPubKey = CScript() << OP_TRUE;
+    const CAlertTransactionRef atx = MakeAlertTransactionRef(mtx);
+
+    // Not verified in a vatx yet: the scripts are checked
+    BOOST_CHECK_EQUAL(BlockTxScriptChecks(*atx, TX_ALERT, flags, false), 1U);
+
+    // TestBlockValidity does not remember the vatx of the block it checks
+    AddVerifiedAlerts({atx}, flags, true);
+    BOOST_CHECK_EQUAL(BlockTxScriptChecks(*atx, TX_ALERT, flags, true), 1U);
+
+    AddVerifiedAlerts({atx}, flags, false);
+
+    // Other flags and transactions which are not alerts miss the cache
+    BOOST_CHECK_EQUAL(BlockTxScriptChecks(*atx, TX_ALERT, flags | SCRIPT_VERIFY_DERSIG, true), 1U);
+    BOOST_CHECK_EQUAL(BlockTxScriptChecks(*atx, TX_ALERT, SCRIPT_VERIFY_P2SH, true), 1U);
+    BOOST_CHECK_EQUAL(BlockTxScriptChecks(*atx, TX_NONVAULT, flags, true), 1U);
+
+    // A hit skips the scripts; TestBlockValidity leaves the entry in place
+    BOOST_CHECK_EQUAL(BlockTxScriptChecks(*atx, TX_ALERT, flags, true), 0U);
+    BOOST_CHECK_EQUAL(BlockTxScriptChecks(*atx, TX_ALERT, flags, true), 0U);
+
+    // Connecting the confirming block consumes the entry
+    BOOST_CHECK_EQUAL(BlockTxScriptChecks(*atx, TX_ALERT, flags, false), 0U);
+    BOOST_CHECK_EQUAL(BlockTxScriptChecks(*atx, TX_ALERT, flags, false), 1U);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -8,9 +8,11 @@
 #include <consensus/merkle.h>
 #include <consensus/validation.h>
 #include <miner.h>
+#include <policy/ddms.h>
 #include <pow.h>
 #include <random.h>
 #include <test/test_bitcoin.h>
+#include <util/strencodings.h>
 #include <validation.h>
 #include <validationinterface.h>
 
@@ -185,4 +187,82 @@ BOOST_AUTO_TEST_CASE(processnewblock_signals_ordering)
     BOOST_CHECK_EQUAL(sub.m_expected_tip, chainActive.Tip()->GetBlockHash());
 }
 
+static std::vector<CBlockHeader> BuildHeaders(const uint256& root, size_t count)
+{
+    std::vector<CBlockHeader> headers;
+    uint256 prev_hash = root;
+    for (size_t i = 0; i < count; i++) {
+        headers.push_back(GoodBlock(prev_hash)->GetBlockHeader());
+        prev_hash = headers.back().GetHash();
+    }
+    return headers;
+}
+
+BOOST_AUTO_TEST_CASE(processnewblockheaders_first_invalid)
+{
+    const Consensus::Params& consensus = Params().GetConsensus();
+    const uint256 genesis_hash = Params().GenesisBlock().GetHash();
+
+    // Runs of headers long enough to be checked in several batches on the header check threads,
+    // one with an invalid proof of work and one with an auxpow version but no auxpow
+    std::vector<CBlockHeader> headers_pow = BuildHeaders(genesis_hash, 40);
+    while (CheckProofOfWork(headers_pow[20].GetHash(), headers_pow[20].nBits, consensus)) {
+        ++headers_pow[20].nNonce;
+    }
+    std::vector<CBlockHeader> headers_auxpow = BuildHeaders(genesis_hash, 40);
+    headers_auxpow[30].SetBlockHeaderVersion(true);
+
+    // The serial checks report the first invalid header and accept the headers before it
+    for (const auto& run : {std::make_pair(headers_pow, 20), std::make_pair(headers_auxpow, 30)}) {
+        const std::vector<CBlockHeader>& headers = run.first;
+        const int invalid = run.second;
+        CValidationState state;
+        CBlockHeader first_invalid;
+        BOOST_CHECK(!ProcessNewBlockHeaders(headers, state, Params(), nullptr, &first_invalid));
+        BOOST_CHECK_EQUAL(first_invalid.GetHash(), headers[invalid].GetHash());
+
+        LOCK(cs_main);
+        BOOST_CHECK(LookupBlockIndex(headers[invalid - 1].GetHash()) != nullptr);
+        BOOST_CHECK(LookupBlockIndex(headers[invalid].GetHash()) == nullptr);
+    }
+
+    // Known headers are skipped, the headers extending them are checked and accepted
+    std::vector<CBlockHeader> headers(headers_pow.begin(), headers_pow.begin() + 20);
+    const std::vector<CBlockHeader> extension = BuildHeaders(headers.back().GetHash(), 20);
+    headers.insert(headers.end(), extension.begin(), extension.end());
+    CValidationState state;
+    const CBlockIndex* pindex = nullptr;
+    BOOST_CHECK(ProcessNewBlockHeaders(headers, state, Params(), &pindex));
+    BOOST_REQUIRE(pindex != nullptr);
+    BOOST_CHECK_EQUAL(pindex->GetBlockHash(), headers.back().GetHash());
+}
+
+BOOST_AUTO_TEST_CASE(ddms_coinbase_output)
+{
+    const auto mainChainParams = CreateChainParams(CBaseChainParams::MAIN);
+    const Consensus::Params& mainParams = mainChainParams->GetConsensus();
+    BOOST_CHECK_EQUAL(mainParams.vDDMSAllowedKeyIDs.size(), DDMS_ALLOWED_SCRIPTS_NUMBER);
+    BOOST_CHECK(std::is_sorted(mainParams.vDDMSAllowedKeyIDs.begin(), mainParams.vDDMSAllowedKeyIDs.end()));
+
+    // Every script of the mainnet allow-list is accepted
+    for (const auto& script : ddmsAllowedScriptsRaw) {
+        BOOST_CHECK(DdmsVerifyCoinbaseOutput(CScript(script, script + DDMS_SCRIPT_LENGTH), mainParams));
+    }
+
+    // Other key hashes and other script types are not
+    const CKeyID keyID(uint160(ParseHex("0102030405060708090a0b0c0d0e0f1011121314")));
+    const CScript p2pkh = GetScriptForDestination(keyID);
+    BOOST_CHECK(!DdmsVerifyCoinbaseOutput(p2pkh, mainParams));
+    const CScript allowed(ddmsAllowedScriptsRaw[0], ddmsAllowedScriptsRaw[0] + DDMS_SCRIPT_LENGTH);
+    BOOST_CHECK(!DdmsVerifyCoinbaseOutput(CScript(allowed.begin() + 1, allowed.end()), mainParams));
+    BOOST_CHECK(!DdmsVerifyCoinbaseOutput(GetScriptForDestination(CScriptID(allowed)), mainParams));
+
+    // The list is per network
+    Consensus::Params params = Params().GetConsensus();
+    BOOST_CHECK(!DdmsVerifyCoinbaseOutput(allowed, params));
+    BOOST_CHECK(!DdmsVerifyCoinbaseOutput(p2pkh, params));
+    params.vDDMSAllowedKeyIDs.push_back(keyID);
+    BOOST_CHECK(DdmsVerifyCoinbaseOutput(p2pkh, params));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,72 @@
+// Copyright (c) 2020 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <coins.h>
+#include <key.h>
+#include <script/standard.h>
+#include <test/test_bitcoin.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(vaulttxtype_tests, BasicTestingSetup)
+
+static CMutableTransaction SpendingTx(const COutPoint& prevout, const CScript& scriptSig)
+{
+    CMutableTransaction tx;
+    tx.vin.resize(1);
+    tx.vin[0].prevout = prevout;
+    tx.vin[0].scriptSig = scriptSig;
+    tx.vout.resize(1);
+    tx.vout[0].nValue = 1;
+    return tx;
+}
+
+BOOST_AUTO_TEST_CASE(vaulttxtype_cached)
+{
+    CKey key1, key2;
+    key1.MakeNewKey(true);
+    key2.MakeNewKey(true);
+    const CScript vaultScript = GetScriptForVaultAddress({key1.GetPubKey(), key2.GetPubKey()});
+    const CScript regularScript = GetScriptForDestination(key1.GetPubKey().GetID());
+    const std::vector<unsigned char> dummySig(72, 1);
+
+    CCoinsView viewDummy;
+    CCoinsViewCache vaultView(&viewDummy);
+    CCoinsViewCache regularView(&viewDummy);
+    const COutPoint prevout(InsecureRand256(), 0);
+    vaultView.AddCoin(prevout, Coin(CTxOut(10, vaultScript), 1, false), false);
+    regularView.AddCoin(prevout, Coin(CTxOut(10, regularScript), 1, false), false);
+
+    const CTransaction alert(SpendingTx(prevout, CScript() << OP_0 << dummySig << OP_1));
+    const CTransaction recovery(SpendingTx(prevout, CScript() << OP_0 << dummySig << dummySig << OP_0));
+    const CTransaction invalid(SpendingTx(prevout, CScript() << OP_1 << dummySig << OP_1));
+
+    // The first lookup computes the type, the second one is a cache hit
+    bool fCached;
+    BOOST_CHECK_EQUAL(GetVaultTxType(alert, vaultView, &fCached), TX_ALERT);
+    BOOST_CHECK(!fCached);
+    BOOST_CHECK_EQUAL(GetVaultTxType(recovery, vaultView, &fCached), TX_RECOVERY);
+    BOOST_CHECK(!fCached);
+    BOOST_CHECK_EQUAL(GetVaultTxType(alert, vaultView, &fCached), TX_ALERT);
+    BOOST_CHECK(fCached);
+    BOOST_CHECK_EQUAL(GetVaultTxType(recovery, vaultView, &fCached), TX_RECOVERY);
+    BOOST_CHECK(fCached);
+
+    // Invalid transactions are never cached
+    for (int i = 0; i < 2; i++) {
+        BOOST_CHECK_EQUAL(GetVaultTxType(invalid, vaultView, &fCached), TX_INVALID);
+        BOOST_CHECK(!fCached);
+    }
+
+    // The same transaction spending a different output is classified again
+    BOOST_CHECK_EQUAL(GetVaultTxType(alert, regularView, &fCached), TX_NONVAULT);
+    BOOST_CHECK(!fCached);
+    BOOST_CHECK_EQUAL(GetVaultTxType(recovery, regularView, &fCached), TX_NONVAULT);
+    BOOST_CHECK(!fCached);
+    BOOST_CHECK_EQUAL(GetVaultTxType(alert, vaultView, &fCached), TX_ALERT);
+    BOOST_CHECK(fCached);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -22,6 +22,8 @@ static const char DB_COIN = 'C';
 static const char DB_COINS = 'c';
 static const char DB_BLOCK_FILES = 'f';
 static const char DB_BLOCK_INDEX = 'b';
+static const char DB_PRUNED_BLOCK_ALERTS = 'A';
+static const char DB_AUX_BLOCK_HEADER = 'a';
 
 static const char DB_BEST_BLOCK = 'B';
 static const char DB_HEAD_BLOCKS = 'H';
@@ -53,13 +55,13 @@ struct CoinEntry {
 
 }
 
-CCoinsViewDB::CCoinsViewDB(size_t nCacheSize, const CChainParams& chainparams, bool fMemory, bool fWipe) : db(GetDataDir() / "chainstate", nCacheSize, fMemory, fWipe, true), params(chainparams)
+CCoinsViewDB::CCoinsViewDB(size_t nCacheSize, const CChainParams& chainparams, bool fMemory, bool fWipe) : db(GetDataDir() / "chainstate", nCacheSize, fMemory, fWipe, true), nAlertsHeight(chainparams.GetConsensus().AlertsHeight)
 {
 }
 
 bool CCoinsViewDB::GetCoin(const COutPoint &outpoint, Coin &coin) const {
-    coin.fAlertsHeight = params.GetConsensus().AlertsHeight;
-    return db.Read(CoinEntry(&outpoint), coin);
+    CoinDBSerializer<Coin> value(coin, nAlertsHeight);
+    return db.Read(CoinEntry(&outpoint), value);
 }
 
 bool CCoinsViewDB::HaveCoin(const COutPoint &outpoint) const {
@@ -107,14 +109,12 @@ bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock) {
     batch.Write(DB_HEAD_BLOCKS, std::vector<uint256>{hashBlock, old_tip});
 
     for (CCoinsMap::iterator it = mapCoins.begin(); it != mapCoins.end();) {
-        if (it->second.flags & CCoinsCacheEntry::DIRTY) {
+        if (it->second.GetFlags() & CCoinsCacheEntry::DIRTY) {
             CoinEntry entry(&it->first);
             if (it->second.coin.IsConfirmed())
                 batch.Erase(entry);
-            else {
-                it->second.coin.fAlertsHeight = params.GetConsensus().AlertsHeight;
-                batch.Write(entry, it->second.coin);
-            }
+            else
+                batch.Write(entry, CoinDBSerializer<const Coin>(it->second.coin, nAlertsHeight));
             changed++;
         }
         count++;
@@ -173,7 +173,7 @@ bool CBlockTreeDB::ReadLastBlockFile(int &nFile) {
 
 CCoinsViewCursor *CCoinsViewDB::Cursor() const
 {
-    CCoinsViewDBCursor *i = new CCoinsViewDBCursor(const_cast<CDBWrapper&>(db).NewIterator(), GetBestBlock());
+    CCoinsViewDBCursor *i = new CCoinsViewDBCursor(const_cast<CDBWrapper&>(db).NewIterator(), GetBestBlock(), nAlertsHeight);
     /* It seems that there are no "const iterators" for LevelDB.  Since we
        only need read operations on it, use a const-cast to get around
        that restriction.  */
@@ -201,7 +201,8 @@ bool CCoinsViewDBCursor::GetKey(COutPoint &key) const
 
 bool CCoinsViewDBCursor::GetValue(Coin &coin) const
 {
-    return pcursor->GetValue(coin);
+    CoinDBSerializer<Coin> value(coin, nAlertsHeight);
+    return pcursor->GetValue(value);
 }
 
 unsigned int CCoinsViewDBCursor::GetValueSize() const
@@ -225,7 +226,7 @@ void CCoinsViewDBCursor::Next()
     }
 }
 
-bool CBlockTreeDB::WriteBatchSync(const std::vector<std::pair<int, const CBlockFileInfo*> >& fileInfo, int nLastFile, const std::vector<const CBlockIndex*>& blockinfo) {
+bool CBlockTreeDB::WriteBatchSync(const std::vector<std::pair<int, const CBlockFileInfo*> >& fileInfo, int nLastFile, const std::vector<const CBlockIndex*>& blockinfo, const std::vector<CAlertsWindowEntry>& prunedAlerts) {
     CDBBatch batch(*this);
     for (std::vector<std::pair<int, const CBlockFileInfo*> >::const_iterator it=fileInfo.begin(); it != fileInfo.end(); it++) {
         batch.Write(std::make_pair(DB_BLOCK_FILES, it->first), *it->second);
@@ -234,6 +235,9 @@ bool CBlockTreeDB::WriteBatchSync(const std::vector<std::pair<int, const CBlockF
     for (std::vector<const CBlockIndex*>::const_iterator it=blockinfo.begin(); it != blockinfo.end(); it++) {
         batch.Write(std::make_pair(DB_BLOCK_INDEX, (*it)->GetBlockHash()), CDiskBlockIndex(*it));
     }
+    for (const CAlertsWindowEntry& entry : prunedAlerts) {
+        batch.Write(std::make_pair(DB_PRUNED_BLOCK_ALERTS, entry.hashBlock), entry);
+    }
     return WriteBatch(batch, true);
 }
 
@@ -294,6 +298,34 @@ bool CBlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams,
     return true;
 }
 
+bool CBlockTreeDB::ReadPrunedBlockAlerts(const uint256& hash, CAlertsWindowEntry& entry) {
+    return Read(std::make_pair(DB_PRUNED_BLOCK_ALERTS, hash), entry);
+}
+
+bool CBlockTreeDB::ErasePrunedBlockAlerts(const std::function<bool(const uint256&)>& fExpired) {
+    std::unique_ptr<CDBIterator> pcursor(NewIterator());
+    CDBBatch batch(*this);
+
+    pcursor->Seek(std::make_pair(DB_PRUNED_BLOCK_ALERTS, uint256()));
+    while (pcursor->Valid()) {
+        std::pair<char, uint256> key;
+        if (!pcursor->GetKey(key) || key.first != DB_PRUNED_BLOCK_ALERTS)
+            break;
+        if (fExpired(key.second))
+            batch.Erase(key);
+        pcursor->Next();
+    }
+    return WriteBatch(batch);
+}
+
+bool CBlockTreeDB::WriteAuxBlockHeader(const uint256& hash, const CAuxBlockHeader& auxHeader) {
+    return Write(std::make_pair(DB_AUX_BLOCK_HEADER, hash), auxHeader);
+}
+
+bool CBlockTreeDB::ReadAuxBlockHeader(const uint256& hash, CAuxBlockHeader& auxHeader) {
+    return Read(std::make_pair(DB_AUX_BLOCK_HEADER, hash), auxHeader);
+}
+
 namespace {
 
 //! Legacy class to deserialize pre-pertxout database entries without reindex.
@@ -395,7 +427,7 @@ bool CCoinsViewDB::Upgrade() {
                     Coin newcoin(std::move(old_coins.vout[i]), old_coins.nHeight, old_coins.fCoinBase);
                     outpoint.n = i;
                     CoinEntry entry(&outpoint);
-                    batch.Write(entry, newcoin);
+                    batch.Write(entry, CoinDBSerializer<const Coin>(newcoin, nAlertsHeight));
                 }
             }
             batch.Erase(key);
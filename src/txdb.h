@@ -6,12 +6,14 @@
 #ifndef BITCOIN_TXDB_H
 #define BITCOIN_TXDB_H
 
+#include <alertswindow.h>
 #include <chainparams.h>
 #include <coins.h>
 #include <dbwrapper.h>
 #include <chain.h>
 #include <primitives/block.h>
 
+#include <functional>
 #include <map>
 #include <memory>
 #include <string>
@@ -38,6 +40,8 @@ static const int64_t nMaxBlockDBCache = 2;
 // Unlike for the UTXO database, for the txindex scenario the leveldb cache make
 // a meaningful difference: https://github.com/bitcoin/bitcoin/pull/8273#issuecomment-229601991
 static const int64_t nMaxTxIndexCache = 1024;
+//! Max memory allocated to alert index DB specific cache data (MiB)
+static const int64_t nMaxAlertIndexCache = 64;
 //! Max memory allocated to coin DB specific cache (MiB)
 static const int64_t nMaxCoinsDBCache = 8;
 
@@ -46,7 +50,8 @@ class CCoinsViewDB final : public CCoinsView
 {
 protected:
     CDBWrapper db;
-    const CChainParams& params;
+    //! Alerts activation height of the chain, coins created after it store their spent height
+    const uint32_t nAlertsHeight;
 
 public:
     explicit CCoinsViewDB(size_t nCacheSize, const CChainParams& chainparams, bool fMemory = false, bool fWipe = false);
@@ -77,9 +82,10 @@ public:
     void Next() override;
 
 private:
-    CCoinsViewDBCursor(CDBIterator* pcursorIn, const uint256 &hashBlockIn):
-        CCoinsViewCursor(hashBlockIn), pcursor(pcursorIn) {}
+    CCoinsViewDBCursor(CDBIterator* pcursorIn, const uint256 &hashBlockIn, uint32_t nAlertsHeightIn):
+        CCoinsViewCursor(hashBlockIn), pcursor(pcursorIn), nAlertsHeight(nAlertsHeightIn) {}
     std::unique_ptr<CDBIterator> pcursor;
+    const uint32_t nAlertsHeight;
     std::pair<char, COutPoint> keyTmp;
 
     friend class CCoinsViewDB;
@@ -91,7 +97,7 @@ class CBlockTreeDB : public CDBWrapper
 public:
     explicit CBlockTreeDB(size_t nCacheSize, bool fMemory = false, bool fWipe = false);
 
-    bool WriteBatchSync(const std::vector<std::pair<int, const CBlockFileInfo*> >& fileInfo, int nLastFile, const std::vector<const CBlockIndex*>& blockinfo);
+    bool WriteBatchSync(const std::vector<std::pair<int, const CBlockFileInfo*> >& fileInfo, int nLastFile, const std::vector<const CBlockIndex*>& blockinfo, const std::vector<CAlertsWindowEntry>& prunedAlerts = {});
     bool ReadBlockFileInfo(int nFile, CBlockFileInfo &info);
     bool ReadLastBlockFile(int &nFile);
     bool WriteReindexing(bool fReindexing);
@@ -99,6 +105,13 @@ public:
     bool WriteFlag(const std::string &name, bool fValue);
     bool ReadFlag(const std::string &name, bool &fValue);
     bool LoadBlockIndexGuts(const Consensus::Params& consensusParams, std::function<CBlockIndex*(const uint256&)> insertBlockIndex);
+    /** Alerts data of pruned blocks, kept as long as their alerts can be confirmed or recovered.
+     *  Written by WriteBatchSync together with the index entries of the pruned blocks. */
+    bool ReadPrunedBlockAlerts(const uint256& hash, CAlertsWindowEntry& entry);
+    bool ErasePrunedBlockAlerts(const std::function<bool(const uint256&)>& fExpired);
+    /** Auxpow of merge-mined block headers, so that serving headers never reads blocks. */
+    bool WriteAuxBlockHeader(const uint256& hash, const CAuxBlockHeader& auxHeader);
+    bool ReadAuxBlockHeader(const uint256& hash, CAuxBlockHeader& auxHeader);
 };
 
 #endif // BITCOIN_TXDB_H
@@ -19,6 +19,7 @@
 #include <indirectmap.h>
 #include <policy/feerate.h>
 #include <primitives/transaction.h>
+#include <script/standard.h>
 #include <sync.h>
 #include <random.h>
 
@@ -74,6 +75,7 @@ private:
     const unsigned int entryHeight; //!< Chain height when entering the mempool
     const bool spendsCoinbase;      //!< keep track of transactions that spend a coinbase
     const int64_t sigOpCost;        //!< Total sigop cost
+    const vaulttxntype vaultType;   //!< Vault type, classified once when entering the mempool
     int64_t feeDelta;          //!< Used for determining the priority of the transaction for mining in a block
     LockPoints lockPoints;     //!< Track the height and time at which tx was final
 
@@ -94,7 +96,8 @@ public:
     CTxMemPoolEntry(const CTransactionRef& _tx, const CAmount& _nFee,
                     int64_t _nTime, unsigned int _entryHeight,
                     bool spendsCoinbase,
-                    int64_t nSigOpsCost, LockPoints lp);
+                    int64_t nSigOpsCost, LockPoints lp,
+                    vaulttxntype vaultType = TX_NONVAULT);
 
     const CTransaction& GetTx() const { return *this->tx; }
     CTransactionRef GetSharedTx() const { return this->tx; }
@@ -104,6 +107,7 @@ public:
     int64_t GetTime() const { return nTime; }
     unsigned int GetHeight() const { return entryHeight; }
     int64_t GetSigOpCost() const { return sigOpCost; }
+    vaulttxntype GetVaultType() const { return vaultType; }
     int64_t GetModifiedFee() const { return nFee + feeDelta; }
     size_t DynamicMemoryUsage() const { return nUsageSize; }
     const LockPoints& GetLockPoints() const { return lockPoints; }
@@ -340,6 +344,13 @@ struct TxMempoolInfo
     int64_t nFeeDelta;
 };
 
+/** Number and total virtual size of the mempool transactions of a single vault type. */
+struct VaultTypeStats
+{
+    uint64_t nCount = 0;
+    uint64_t nSize = 0;
+};
+
 /** Reason why a transaction was removed from the mempool,
  * this is passed to the notification signal.
  */
@@ -448,6 +459,7 @@ private:
 
     uint64_t totalTxSize;      //!< sum of all mempool tx's virtual sizes. Differs from serialized tx size since witness data is discounted. Defined in BIP 141.
     uint64_t cachedInnerUsage; //!< sum of dynamic memory usage of all the map elements (NOT the maps themselves)
+    std::map<vaulttxntype, VaultTypeStats> mapVaultTypeStats; //!< number and virtual size of the mempool tx's per vault type
 
     mutable int64_t lastRollingFeeUpdate;
     mutable bool blockSinceLastRollingFeeBump;
@@ -685,6 +697,13 @@ public:
         return totalTxSize;
     }
 
+    /** Number and total virtual size of the transactions of each vault type. Types without transactions may be missing. */
+    std::map<vaulttxntype, VaultTypeStats> GetVaultTypeStats() const
+    {
+        LOCK(cs);
+        return mapVaultTypeStats;
+    }
+
     bool exists(const uint256& hash) const
     {
         LOCK(cs);
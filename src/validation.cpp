@@ -17,6 +17,7 @@
 #include <consensus/validation.h>
 #include <cuckoocache.h>
 #include <hash.h>
+#include <index/alertindex.h>
 #include <index/txindex.h>
 #include <policy/ddms.h>
 #include <policy/fees.h>
@@ -167,7 +168,7 @@ public:
      * If a block header hasn't already been seen, call CheckBlockHeader on it, ensure
      * that it doesn't descend from an invalid block, and then add it to mapBlockIndex.
      */
-    bool AcceptBlockHeader(const CBlockHeader& block, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+    bool AcceptBlockHeader(const CBlockHeader& block, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex, bool fCheckPOW = true) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
     bool AcceptBlock(const std::shared_ptr<const CBlock>& pblock, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex, bool fRequested, const CDiskBlockPos* dbp, bool* fNewBlock, bool fCheckVaultTxType = true) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
     // Block (dis)connection on a given view:
@@ -238,6 +239,8 @@ std::atomic_bool fImporting(false);
 std::atomic_bool fReindex(false);
 bool fHavePruned = false;
 bool fPruneMode = false;
+bool fDedupAlerts = DEFAULT_DEDUP_ALERTS;
+std::atomic_bool fHaveAlertRefs(false);
 bool fIsBareMultisigStd = DEFAULT_PERMIT_BAREMULTISIG;
 bool fRequireStandard = true;
 bool fCheckBlockIndex = false;
@@ -285,6 +288,9 @@ namespace {
 
     /** Dirty block file entries. */
     std::set<int> setDirtyFileInfo;
+
+    /** Alerts data of pruned blocks, written together with their dirty block index entries. */
+    std::vector<CAlertsWindowEntry> vDirtyPrunedAlerts;
 } // anon namespace
 
 CBlockIndex* FindForkInGlobalIndex(const CChain& chain, const CBlockLocator& locator)
@@ -727,7 +733,7 @@ static bool AcceptToMemoryPoolWorker(const CChainParams& chainparams, CTxMemPool
         }
 
         CTxMemPoolEntry entry(ptx, nFees, nAcceptTime, chainActive.Height(),
-                              fSpendsCoinbase, nSigOpsCost, lp);
+                              fSpendsCoinbase, nSigOpsCost, lp, vaultTxType);
         unsigned int nSize = entry.GetTxSize();
 
         // Check that the transaction doesn't have an excessive number of
@@ -1053,6 +1059,14 @@ bool GetTransaction(const uint256& hash, CBaseTransactionRef& txOut, const Conse
 
 vaulttxnstatus GetTransactionStatus(const uint256& hash, const Consensus::Params& consensusParams, vaulttxntype txType, const CBlockIndex* const block_index){
 
+    // The status of alerts mined in a block is kept up to date by the txindex
+    CAlertStatus alertStatus;
+    if (txType == TX_ALERT && g_txindex && g_txindex->FindAlertStatus(hash, alertStatus)) {
+        if (!block_index || block_index->GetBlockHash() == alertStatus.hashBlock || block_index->GetBlockHash() == alertStatus.hashStatusBlock) {
+            return alertStatus.status;
+        }
+    }
+
     CBaseTransactionRef txOut;
     vaulttxnstatus txStatus = TX_UNKNOWN;
     {
@@ -1114,15 +1128,16 @@ vaulttxnstatus GetTransactionStatus(const uint256& hash, const Consensus::Params
 // CBlock and CBlockIndex
 //
 
-bool CheckProofOfWork(const CBlockHeader& block, const Consensus::Params& params) {
-	 if (block.IsAuxPow() && block.GetBaseVersion() == VERSIONBITS_LAST_OLD_BLOCK_VERSION
+bool CheckProofOfWork(const CBlockHeader& block, const Consensus::Params& params, bool fCheckAuxPow) {
+	 const bool fAuxPow = block.IsAuxPow();
+	 if (fAuxPow && block.GetBaseVersion() == VERSIONBITS_LAST_OLD_BLOCK_VERSION
 	 && params.fStrictChainId && block.GetChainId() != params.nAuxpowChainId)
 		 return error("%s: block does not have our chain ID (got %d, expected %d, full nVersion %d)",
 				 	  __func__, block.GetChainId(), params.nAuxpowChainId, block.nVersion);
 
 	 /* If there is no auxpow, just check the block hash. */
 	 if (!block.auxHeader) {
-		 if (block.IsAuxPow())
+		 if (fAuxPow)
 			 return error("%s : no auxpow on block with auxpow version", __func__);
 
 		 if (!CheckProofOfWork(block.GetHash(), block.nBits, params))
@@ -1132,18 +1147,134 @@ bool CheckProofOfWork(const CBlockHeader& block, const Consensus::Params& params
 	 }
 
 	 /* We have auxpow. Check it. */
-	 if (!block.IsAuxPow())
+	 if (!fAuxPow)
 		 return error("%s : auxpow on block with non-auxpow version", __func__);
 
 	 if (!CheckProofOfWork(block.auxHeader->getParentBlockHash(), block.nBits, params))
 		 return error("%s : AUX proof of work failed", __func__);
-	 if (!CAuxPow::check(*block.auxHeader, block.GetHash(), block.GetChainId(), params))
+	 if (fCheckAuxPow && !CAuxPow::check(*block.auxHeader, block.GetHash(), block.GetChainId(), params))
 		 return error("%s : AUX POW is not valid", __func__);
 
 	 return true;
 }
 
-static bool WriteBlockToDisk(const CBlock& block, CDiskBlockPos& pos, const CMessageHeader::MessageStartChars& messageStart)
+/**
+ * Set in the size field of a blk*.dat record whose confirmed alerts are not
+ * stored in vtx but as CDiskAlertRefs following the block. Block sizes never
+ * come close to this bit, so older versions skip such records on reindex
+ * instead of misreading them.
+ */
+static const unsigned int BLOCK_ALERT_REFS_FLAG = 0x80000000;
+
+/** Confirmed alert of a block stored as a reference to the vatx of the block which mined it. */
+struct CDiskAlertRef
+{
+    //! Position of the confirmed alert in vtx
+    uint32_t nTxIndex;
+    //! Position of the block which mined the alert
+    CDiskBlockPos ancestorPos;
+    //! Position of the alert in the vatx of that block
+    uint32_t nAlertIndex;
+
+    CDiskAlertRef() : nTxIndex(0), nAlertIndex(0) {}
+    CDiskAlertRef(uint32_t nTxIndexIn, const CDiskBlockPos& ancestorPosIn, uint32_t nAlertIndexIn) :
+        nTxIndex(nTxIndexIn), ancestorPos(ancestorPosIn), nAlertIndex(nAlertIndexIn) {}
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(VARINT(nTxIndex));
+        READWRITE(ancestorPos);
+        READWRITE(VARINT(nAlertIndex));
+    }
+};
+
+/**
+ * Find the confirmed alerts of a block which can be stored as references to the
+ * ancestor block's vatx. Returns the block without them, or block itself if
+ * there are none.
+ */
+static CBlock GetDiskAlertRefs(const CBlock& block, const CBlockIndex* pindexPrev, const Consensus::Params& params, std::vector<CDiskAlertRef>& vAlertRefs) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
+{
+    vAlertRefs.clear();
+    if (!fDedupAlerts || !pindexPrev || !AreAlertsEnabled(pindexPrev->nHeight + 1, params.AlertsHeight))
+        return block;
+
+    CAlertsWindowEntryRef ancestorAlerts = TryGetAncestorAlerts(pindexPrev, params);
+    if (!ancestorAlerts || ancestorAlerts->vatx.empty())
+        return block;
+    const CBlockIndex* pindexAncestor = pindexPrev->GetAncestor(pindexPrev->nHeight + 1 - params.nAlertsInitializationWindow);
+    const CDiskBlockPos ancestorPos = pindexAncestor->GetBlockPos();
+
+    std::map<uint256, uint32_t> mapAlertIndex;
+    for (size_t i = 0; i < ancestorAlerts->vatx.size(); i++)
+        mapAlertIndex.emplace(ancestorAlerts->vatx[i]->GetWitnessHash(), i);
+
+    CBlock storedBlock(block.GetBlockHeader());
+    storedBlock.vatx = block.vatx;
+    storedBlock.fAlertsSerialization = block.fAlertsSerialization;
+    for (size_t i = 0; i < block.vtx.size(); i++) {
+        auto it = i > 0 ? mapAlertIndex.find(block.vtx[i]->GetWitnessHash()) : mapAlertIndex.end();
+        if (it != mapAlertIndex.end())
+            vAlertRefs.emplace_back(i, ancestorPos, it->second);
+        else
+            storedBlock.vtx.push_back(block.vtx[i]);
+    }
+    return vAlertRefs.empty() ? block : storedBlock;
+}
+
+/** Put back the confirmed alerts of a block read from a record with BLOCK_ALERT_REFS_FLAG. */
+static bool ExpandDiskAlertRefs(CBlock& block, const std::vector<CDiskAlertRef>& vAlertRefs)
+{
+    CDiskBlockPos ancestorPos;
+    CBlock ancestor;
+    for (const CDiskAlertRef& ref : vAlertRefs) {
+        if (ancestor.IsNull() || ref.ancestorPos != ancestorPos) {
+            // Only vatx of the ancestor is used, so its own references are not expanded
+            ancestorPos = ref.ancestorPos;
+            ancestor.SetNull();
+            ancestor.fAlertsSerialization = true;
+            CAutoFile filein(OpenBlockFile(ancestorPos, true), SER_DISK, CLIENT_VERSION);
+            if (filein.IsNull())
+                return error("%s: OpenBlockFile failed for %s", __func__, ancestorPos.ToString());
+            try {
+                filein >> ancestor;
+            } catch (const std::exception& e) {
+                return error("%s: Deserialize or I/O error - %s at %s", __func__, e.what(), ancestorPos.ToString());
+            }
+        }
+        if (ref.nAlertIndex >= ancestor.vatx.size() || ref.nTxIndex > block.vtx.size())
+            return error("%s: invalid alert reference to %s", __func__, ancestorPos.ToString());
+        block.vtx.insert(block.vtx.begin() + ref.nTxIndex, MakeTransactionRef(CTransaction(CMutableTransaction(*ancestor.vatx[ref.nAlertIndex]))));
+    }
+    return true;
+}
+
+/**
+ * Like ExpandDiskAlertRefs, for blocks read from an external file (-loadblock). The positions in
+ * the references are those of the node which wrote the file, so the alerts are taken from the
+ * ancestor block in our block index instead, which precedes the block in the file.
+ */
+static bool ExpandDiskAlertRefsFromIndex(CBlock& block, const std::vector<CDiskAlertRef>& vAlertRefs, const Consensus::Params& params)
+{
+    LOCK(cs_main);
+    const CBlockIndex* pindexPrev = LookupBlockIndex(block.hashPrevBlock);
+    if (!pindexPrev)
+        return error("%s: previous block %s not known", __func__, block.hashPrevBlock.ToString());
+    CAlertsWindowEntryRef ancestorAlerts = TryGetAncestorAlerts(pindexPrev, params);
+    if (!ancestorAlerts)
+        return error("%s: alerts of the ancestor of block %s not available", __func__, block.GetHash().ToString());
+
+    for (const CDiskAlertRef& ref : vAlertRefs) {
+        if (ref.nAlertIndex >= ancestorAlerts->vatx.size() || ref.nTxIndex > block.vtx.size())
+            return error("%s: invalid alert reference in block %s", __func__, block.GetHash().ToString());
+        block.vtx.insert(block.vtx.begin() + ref.nTxIndex, MakeTransactionRef(CTransaction(CMutableTransaction(*ancestorAlerts->vatx[ref.nAlertIndex]))));
+    }
+    return true;
+}
+
+static bool WriteBlockToDisk(const CBlock& block, CDiskBlockPos& pos, const CMessageHeader::MessageStartChars& messageStart, const std::vector<CDiskAlertRef>& vAlertRefs)
 {
     // Open history file to append
     CAutoFile fileout(OpenBlockFile(pos), SER_DISK, CLIENT_VERSION);
@@ -1152,6 +1283,8 @@ static bool WriteBlockToDisk(const CBlock& block, CDiskBlockPos& pos, const CMes
 
     // Write index header
     unsigned int nSize = GetSerializeSize(block, fileout.GetVersion());
+    if (!vAlertRefs.empty())
+        nSize = (nSize + GetSerializeSize(vAlertRefs, fileout.GetVersion())) | BLOCK_ALERT_REFS_FLAG;
     fileout << messageStart << nSize;
 
     // Write block
@@ -1160,23 +1293,66 @@ static bool WriteBlockToDisk(const CBlock& block, CDiskBlockPos& pos, const CMes
         return error("WriteBlockToDisk: ftell failed");
     pos.nPos = (unsigned int)fileOutPos;
     fileout << block;
+    if (!vAlertRefs.empty())
+        fileout << vAlertRefs;
 
     return true;
 }
 
+/** Persist that block files hold alert references before the first one is stored */
+static void SetHaveAlertRefs()
+{
+    if (!fHaveAlertRefs) {
+        pblocktree->WriteFlag("alertrefsblockfiles", true);
+        fHaveAlertRefs = true;
+    }
+}
+
+bool ReadBlockAlertRefsFlag(const CDiskBlockPos& pos, bool& fAlertRefs)
+{
+    CDiskBlockPos hpos = pos;
+    hpos.nPos -= 8; // Seek back 8 bytes for meta header
+    CAutoFile filein(OpenBlockFile(hpos, true), SER_DISK, CLIENT_VERSION);
+    if (filein.IsNull())
+        return error("%s: OpenBlockFile failed for %s", __func__, pos.ToString());
+
+    try {
+        CMessageHeader::MessageStartChars blk_start;
+        unsigned int blk_size;
+        filein >> blk_start >> blk_size;
+        fAlertRefs = blk_size & BLOCK_ALERT_REFS_FLAG;
+    } catch (const std::exception& e) {
+        return error("%s: Read from block file failed: %s for %s", __func__, e.what(), pos.ToString());
+    }
+    return true;
+}
+
 bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, const Consensus::Params& consensusParams, const bool fAlertsSerialization)
 {
     block.SetNull();
     block.fAlertsSerialization = fAlertsSerialization;
 
-    // Open history file to read
-    CAutoFile filein(OpenBlockFile(pos, true), SER_DISK, CLIENT_VERSION);
+    // Open history file to read, starting at the index header
+    CDiskBlockPos hpos = pos;
+    hpos.nPos -= 8;
+    CAutoFile filein(OpenBlockFile(hpos, true), SER_DISK, CLIENT_VERSION);
     if (filein.IsNull())
         return error("ReadBlockFromDisk: OpenBlockFile failed for %s", pos.ToString());
 
     // Read block
     try {
+        CMessageHeader::MessageStartChars blk_start;
+        unsigned int blk_size;
+        filein >> blk_start >> blk_size;
+
         filein >> block;
+
+        if (blk_size & BLOCK_ALERT_REFS_FLAG) {
+            std::vector<CDiskAlertRef> vAlertRefs;
+            filein >> vAlertRefs;
+            if (!ExpandDiskAlertRefs(block, vAlertRefs))
+                return error("ReadBlockFromDisk: Failed to expand alert references at %s", pos.ToString());
+        }
     }
     catch (const std::exception& e) {
         return error("%s: Deserialize or I/O error - %s at %s", __func__, e.what(), pos.ToString());
@@ -1231,6 +1407,16 @@ bool ReadRawBlockFromDisk(std::vector<uint8_t>& block, const CDiskBlockPos& pos,
                     HexStr(message_start, message_start + CMessageHeader::MESSAGE_START_SIZE));
         }
 
+        if (blk_size & BLOCK_ALERT_REFS_FLAG) {
+            // Callers expect the canonical serialization, so expand the alert references
+            CBlock expanded;
+            if (!ReadBlockFromDisk(expanded, pos, Params().GetConsensus(), true))
+                return false;
+            block.clear();
+            CVectorWriter(SER_DISK, CLIENT_VERSION, block, 0) << expanded;
+            return true;
+        }
+
         if (blk_size > MAX_SIZE) {
             return error("%s: Block data is larger than maximum deserialization size for %s: %s versus %s", __func__, pos.ToString(),
                     blk_size, MAX_SIZE);
@@ -1493,6 +1679,17 @@ int GetSpendHeight(const CCoinsViewCache& inputs)
 static CuckooCache::cache<uint256, SignatureCacheHasher> scriptExecutionCache;
 static uint256 scriptExecutionCacheNonce(GetRandHash());
 
+/**
+ * Alerts are script checked when they are mined into a block's vatx and
+ * again when they are confirmed in vtx nAlertsInitializationWindow blocks
+ * later. Script validity only depends on the wtxid (which commits to the
+ * spent outputs) and the script flags, so alerts verified on the active
+ * chain are remembered here, separately from scriptExecutionCache whose
+ * entries are evicted by mempool traffic long before the window passes.
+ */
+static CuckooCache::cache<uint256, SignatureCacheHasher> verifiedAlertCache;
+static uint256 verifiedAlertCacheNonce(GetRandHash());
+
 void InitScriptExecutionCache() {
     // nMaxCacheSize is unsigned. If -maxsigcachesize is set to zero,
     // setup_bytes creates the minimum possible cache (2 elements).
@@ -1500,6 +1697,45 @@ void InitScriptExecutionCache() {
     size_t nElems = scriptExecutionCache.setup_bytes(nMaxCacheSize);
     LogPrintf("Using %zu MiB out of %zu/2 requested for script execution cache, able to store %zu elements\n",
             (nElems*sizeof(uint256)) >>20, (nMaxCacheSize*2)>>20, nElems);
+
+    nElems = verifiedAlertCache.setup_bytes(VERIFIED_ALERT_CACHE_SIZE << 20);
+    LogPrintf("Using %zu MiB for verified alert cache, able to store %zu elements\n",
+            (nElems*sizeof(uint256)) >>20, nElems);
+}
+
+static uint256 GetVerifiedAlertCacheKey(const CBaseTransaction& tx, unsigned int flags)
+{
+    uint256 hashCacheEntry;
+    CSHA256().Write(verifiedAlertCacheNonce.begin(), 55 - sizeof(flags) - 32).Write(tx.GetWitnessHash().begin(), 32).Write((unsigned char*)&flags, sizeof(flags)).Finalize(hashCacheEntry.begin());
+    return hashCacheEntry;
+}
+
+/**
+ * Input checks of a block transaction in ConnectBlock. A confirmed alert was
+ * already script checked with the same flags when it was mined into vatx, so
+ * its scripts are skipped on a hit in verifiedAlertCache; its membership in the
+ * ancestor block's vatx is checked by the caller. The entry is consumed unless
+ * fJustCheck is set, as the alert is confirmed only once on a chain.
+ */
+bool CheckBlockTxInputs(const CBaseTransaction& tx, vaulttxntype vaultTxType, CValidationState& state, const CCoinsViewCache& view, bool fScriptChecks, unsigned int flags, bool fJustCheck, PrecomputedTransactionData& txdata, std::vector<CScriptCheck>* pvChecks, bool expectedToBeSpent) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
+{
+    if (fScriptChecks && vaultTxType == TX_ALERT) {
+        if (verifiedAlertCache.contains(GetVerifiedAlertCacheKey(tx, flags), !fJustCheck)) {
+            fScriptChecks = false;
+        }
+    }
+
+    bool fCacheResults = fJustCheck; /* Don't cache results if we're actually connecting blocks (still consult the cache, though) */
+    return CheckInputs(tx, state, view, fScriptChecks, flags, fCacheResults, fCacheResults, txdata, pvChecks, expectedToBeSpent);
+}
+
+/** Remember the alerts of a connected block's vatx, whose scripts passed with flags */
+void AddVerifiedAlerts(const std::vector<CAlertTransactionRef>& vatx, unsigned int flags, bool fJustCheck) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
+{
+    if (fJustCheck) return;
+    for (const CAlertTransactionRef& atx : vatx) {
+        verifiedAlertCache.insert(GetVerifiedAlertCacheKey(*atx, flags));
+    }
 }
 
 /**
@@ -1902,6 +2138,47 @@ void ThreadScriptCheck() {
     scriptcheckqueue.Thread();
 }
 
+/** Context-free proof of work check of a run of headers, see ProcessNewBlockHeaders.
+ *  The auxpow merkle branches of the run are hashed together with CAuxPow::checkBatch. */
+class CHeaderCheck
+{
+private:
+    std::vector<const CBlockHeader*> vHeaders;
+    const Consensus::Params* pparams;
+
+public:
+    CHeaderCheck() : pparams(nullptr) {}
+    CHeaderCheck(std::vector<const CBlockHeader*> vHeadersIn, const Consensus::Params& params) : vHeaders(std::move(vHeadersIn)), pparams(&params) {}
+
+    bool operator()()
+    {
+        std::vector<const CBlockHeader*> vAuxHeaders;
+        for (const CBlockHeader* pheader : vHeaders) {
+            if (!CheckProofOfWork(*pheader, *pparams, false))
+                return false;
+            if (pheader->auxHeader)
+                vAuxHeaders.push_back(pheader);
+        }
+        return CAuxPow::checkBatch(vAuxHeaders, *pparams);
+    }
+
+    void swap(CHeaderCheck& check)
+    {
+        vHeaders.swap(check.vHeaders);
+        std::swap(pparams, check.pparams);
+    }
+};
+
+/** Number of headers checked together by one CHeaderCheck */
+static const size_t HEADER_CHECK_BATCH_SIZE = 16;
+
+static CCheckQueue<CHeaderCheck> headercheckqueue(128);
+
+void ThreadHeaderCheck() {
+    RenameThread("bitcoin-headerch");
+    headercheckqueue.Thread();
+}
+
 VersionBitsCache versionbitscache GUARDED_BY(cs_main);
 
 int32_t ComputeBlockVersion(const CBlockIndex* pindexPrev, const Consensus::Params& params)
@@ -2005,6 +2282,39 @@ unsigned int GetBlockScriptFlags(const CBlockIndex* pindex, const Consensus::Par
 
 
 
+bool MatchRecoveryWithAlertIndex(const CTransaction& tx, const CCoinsViewCache& inputs, const CBlockIndex* pindexPrev, bool& fMatch)
+{
+    if (!g_alertindex)
+        return false;
+
+    // alert txid -> (inputs of the alert, inputs reverted by tx)
+    std::map<uint256, std::pair<uint32_t, uint32_t>> mapAlertInputs;
+    for (const CTxIn& txin : tx.vin) {
+        CAlertSpend spend;
+        if (!g_alertindex->FindAlertSpend(txin.prevout, spend))
+            return false;
+
+        const CBlockIndex* pindexAlert = pindexPrev->GetAncestor(spend.nHeight);
+        if (!pindexAlert || pindexAlert->GetBlockHash() != spend.hashBlock)
+            return false;
+        if (inputs.AccessCoin(txin.prevout).nSpentHeight != (uint32_t) spend.nHeight)
+            return false;
+
+        auto& alertInputs = mapAlertInputs[spend.alertTxid];
+        alertInputs.first = spend.nInputs;
+        alertInputs.second++;
+    }
+
+    fMatch = true;
+    for (const auto& alertInputs : mapAlertInputs) {
+        if (alertInputs.second.first != alertInputs.second.second) {
+            fMatch = false;
+            break;
+        }
+    }
+    return true;
+}
+
 static int64_t nTimeCheck = 0;
 static int64_t nTimeForks = 0;
 static int64_t nTimeVerify = 0;
@@ -2290,8 +2600,7 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
         if (!isCoinBase)
         {
             std::vector<CScriptCheck> vChecks;
-            bool fCacheResults = fJustCheck; /* Don't cache results if we're actually connecting blocks (still consult the cache, though) */
-            if (!CheckInputs(tx, state, view, fScriptChecks, flags, fCacheResults, fCacheResults, txdata.back(), nScriptCheckThreads ? &vChecks : nullptr, expectedToBeSpent))
+            if (!CheckBlockTxInputs(tx, vaultTxType, state, view, fScriptChecks, flags, fJustCheck, txdata.back(), nScriptCheckThreads ? &vChecks : nullptr, expectedToBeSpent))
                 return error("ConnectBlock(): CheckInputs on %s failed with %s",
                              tx.GetHash().ToString(), FormatStateMessage(state));
             control.Add(vChecks);
@@ -2315,8 +2624,8 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
 
     if (fAlertsEnabled) {
         if (confirmedAlerts.size() > 0) {
-            CBlock ancestorBlock;
-            if (!GetAncestorBlock(pindex->pprev, chainparams.GetConsensus(), ancestorBlock)) {
+            CAlertsWindowEntryRef ancestorAlerts = GetAncestorAlerts(pindex->pprev, chainparams.GetConsensus());
+            if (!ancestorAlerts) {
                 assert(!"ConnectBlock(): cannot get ancestor block");
             }
 
@@ -2324,8 +2633,8 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
                 auto compareHashes = [&](const CAlertTransactionRef &atx) -> bool {
                     return atx->GetHash() == tx->GetHash();
                 };
-                if (std::find_if(ancestorBlock.vatx.begin(), ancestorBlock.vatx.end(), compareHashes) ==
-                    ancestorBlock.vatx.end())
+                if (std::find_if(ancestorAlerts->vatx.begin(), ancestorAlerts->vatx.end(), compareHashes) ==
+                    ancestorAlerts->vatx.end())
                     return state.DoS(10, false, REJECT_INVALID, "bad-txn-alert-absence", false,
                                      "confirmed alert is absent in ancestor block");
             }
@@ -2339,6 +2648,14 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
             extendedView.SetBackend(viewMempool);
 
             for (const auto &tx : recoveryTxs) {
+                bool fRecoveryMatch = false;
+                if (MatchRecoveryWithAlertIndex(*tx, extendedView, pindex->pprev, fRecoveryMatch)) {
+                    if (!fRecoveryMatch)
+                        return state.DoS(10, false, REJECT_INVALID, "bad-txn-recovery", false,
+                                         "recovery inputs mismatch with recovered alerts");
+                    continue;
+                }
+
                 // find unique spent heights of recovered inputs
                 std::unordered_set<uint32_t> uniqueSpentHeights;
                 for (const CTxIn &txIn : tx->vin) {
@@ -2350,11 +2667,8 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
                 for (auto spentHeightIt = uniqueSpentHeights.begin();
                      spentHeightIt != uniqueSpentHeights.end(); spentHeightIt++) {
                     // find related atxs and check if revert tx has all inputs
-                    CBlock ancestorBlock;
                     const CBlockIndex *ancestorIndex = pindex->pprev->GetAncestor(*spentHeightIt);
-                    if (!ReadBlockFromDisk(ancestorBlock, ancestorIndex, chainparams.GetConsensus())) {
-                        assert(!"CheckBlock(): cannot load block from disk");
-                    }
+                    CAlertsWindowEntryRef ancestorAlerts = GetBlockAlerts(ancestorIndex, chainparams.GetConsensus());
                     auto hasAllAlertInputs = [&](const CAlertTransactionRef &atx) -> bool {
                         for (size_t i = 0; i < atx->vin.size(); i++) {
                             auto compareInputs = [&](const CTxIn &vin) -> bool {
@@ -2367,10 +2681,10 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
                         return true;
                     };
 
-                    for (auto it = std::find_if(ancestorBlock.vatx.begin(), ancestorBlock.vatx.end(),
+                    for (auto it = std::find_if(ancestorAlerts->vatx.begin(), ancestorAlerts->vatx.end(),
                                                 hasAllAlertInputs);
-                         it != ancestorBlock.vatx.end();
-                         it = std::find_if(++it, ancestorBlock.vatx.end(), hasAllAlertInputs)) {
+                         it != ancestorAlerts->vatx.end();
+                         it = std::find_if(++it, ancestorAlerts->vatx.end(), hasAllAlertInputs)) {
                         alertsInputsCount += (*it)->vin.size();
                     }
                 }
@@ -2457,15 +2771,15 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
                                REJECT_INVALID, "bad-cb-amount");
 
     if (fAlertsEnabled && nAncestorAlertsFees > 0) {
-        CBlock ancestorBlock;
-        if(!GetAncestorBlock(pindex->pprev, chainparams.GetConsensus(), ancestorBlock)) {
+        CAlertsWindowEntryRef ancestorAlerts = GetAncestorAlerts(pindex->pprev, chainparams.GetConsensus());
+        if (!ancestorAlerts) {
             assert(!"ConnectBlock(): cannot get ancestor block");
         }
         // Validate if coinbase pays a fee to the original miner
         // Skip this check if the original miner is same as the current one
-        if (block.vtx[0]->vout[0].scriptPubKey != ancestorBlock.vtx[0]->vout[0].scriptPubKey) {
+        if (block.vtx[0]->vout[0].scriptPubKey != ancestorAlerts->coinbaseScriptPubKey) {
             auto isCoinbaseFeeVout = [&] (const CTxOut& vout) -> bool {
-                return vout.nValue == nAncestorAlertsFees && vout.scriptPubKey == ancestorBlock.vtx[0]->vout[0].scriptPubKey;
+                return vout.nValue == nAncestorAlertsFees && vout.scriptPubKey == ancestorAlerts->coinbaseScriptPubKey;
             };
 
             auto vout_it = std::find_if(block.vtx[0]->vout.begin(), block.vtx[0]->vout.end(), isCoinbaseFeeVout);
@@ -2478,6 +2792,11 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
 
     if (!control.Wait())
         return state.DoS(100, error("%s: CheckQueue failed", __func__), REJECT_INVALID, "block-validation-failed");
+
+    if (fAlertsEnabled && fScriptChecks) {
+        // All scripts of vatx passed, remember them for the block which confirms the alerts
+        AddVerifiedAlerts(block.vatx, flags, fJustCheck);
+    }
     int64_t nTime4 = GetTimeMicros(); nTimeVerify += nTime4 - nTime2;
     LogPrint(BCLog::BENCH, "    - Verify %u txins: %.2fms (%.3fms/txin) [%.2fs (%.2fms/blk)]\n", nTxInputs - 1, MILLI * (nTime4 - nTime2), nTxInputs <= 1 ? 0 : MILLI * (nTime4 - nTime2) / (nTxInputs - 1), nTimeVerify * MICRO, nTimeVerify * MILLI / nBlocksTotal);
 
@@ -2583,9 +2902,10 @@ bool static FlushStateToDisk(const CChainParams& chainparams, CValidationState &
                     vBlocks.push_back(*it);
                     setDirtyBlockIndex.erase(it++);
                 }
-                if (!pblocktree->WriteBatchSync(vFiles, nLastBlockFile, vBlocks)) {
+                if (!pblocktree->WriteBatchSync(vFiles, nLastBlockFile, vBlocks, vDirtyPrunedAlerts)) {
                     return AbortNode(state, "Failed to write to block index database");
                 }
+                vDirtyPrunedAlerts.clear();
             }
             // Finally remove any pruned files
             if (fFlushForPrune)
@@ -2753,6 +3073,7 @@ bool CChainState::DisconnectTip(CValidationState& state, const CChainParams& cha
     }
 
     chainActive.SetTip(pindexDelete->pprev);
+    alertsWindow.BlockDisconnected(pindexDelete);
 
     UpdateTip(pindexDelete->pprev, chainparams);
     // Let wallets know transactions went from 1-confirmed to
@@ -2887,6 +3208,7 @@ bool CChainState::ConnectTip(CValidationState& state, const CChainParams& chainp
     }
     // Update chainActive & related variables.
     chainActive.SetTip(pindexNew);
+    alertsWindow.BlockConnected(blockConnecting, pindexNew, chainparams.GetConsensus());
     UpdateTip(pindexNew, chainparams);
 
     int64_t nTime6 = GetTimeMicros(); nTimePostConnect += nTime6 - nTime5; nTimeTotal += nTime6 - nTime1;
@@ -3643,18 +3965,71 @@ bool AreAlertsEnabled(const int nHeight, int nAlertsHeight)
     return nAlertsHeight && nHeight >= nAlertsHeight;
 }
 
-bool GetAncestorBlock(CBlockIndex* pindexPrev, const Consensus::Params& params, CBlock& ancestorBlock) {
+CAlertsWindow alertsWindow;
+
+/**
+ * Load alerts data of a block from disk, or from the block tree DB if the block has been pruned.
+ * Only blocks of the active chain are added to alertsWindow, so that blocks on forks (e.g. compact
+ * blocks relayed by peers) neither replace active chain entries nor churn the window.
+ */
+static CAlertsWindowEntryRef ReadBlockAlerts(const CBlockIndex* pindex, const Consensus::Params& params) EXCLUSIVE_LOCKS_REQUIRED(cs_main) {
+    AssertLockHeld(cs_main);
+    CAlertsWindowEntryRef entry;
+    if (!(pindex->nStatus & BLOCK_HAVE_DATA)) {
+        CAlertsWindowEntry prunedEntry;
+        if (!pblocktree->ReadPrunedBlockAlerts(pindex->GetBlockHash(), prunedEntry))
+            return nullptr;
+        entry = std::make_shared<const CAlertsWindowEntry>(std::move(prunedEntry));
+    } else {
+        CBlock block;
+        if (!ReadBlockFromDisk(block, pindex, params))
+            return nullptr;
+        entry = std::make_shared<const CAlertsWindowEntry>(block, pindex->GetBlockHash());
+    }
+
+    if (!chainActive.Contains(pindex))
+        return entry;
+    return alertsWindow.Insert(entry, pindex, params);
+}
+
+CAlertsWindowEntryRef GetBlockAlerts(const CBlockIndex* pindex, const Consensus::Params& params) {
+    CAlertsWindowEntryRef entry = alertsWindow.Get(pindex);
+    if (entry)
+        return entry;
+
+    entry = ReadBlockAlerts(pindex, params);
+    if (!entry) {
+        assert(!"GetBlockAlerts(): cannot load block from disk");
+    }
+    return entry;
+}
+
+CAlertsWindowEntryRef GetAncestorAlerts(const CBlockIndex* pindexPrev, const Consensus::Params& params) {
     int nHeight = pindexPrev->nHeight + 1;
     if (nHeight <= (int) params.nAlertsInitializationWindow) {
-        return false;
+        return nullptr;
     }
 
-    CBlockIndex* ancestorIndex = pindexPrev->GetAncestor(nHeight - params.nAlertsInitializationWindow);
-    if (!ReadBlockFromDisk(ancestorBlock, ancestorIndex, params)) {
-        assert(!"GetAncestorBlock(): cannot load block from disk");
+    return GetBlockAlerts(pindexPrev->GetAncestor(nHeight - params.nAlertsInitializationWindow), params);
+}
+
+CAlertsWindowEntryRef TryGetBlockAlerts(const CBlockIndex* pindex, const Consensus::Params& params) {
+    AssertLockHeld(cs_main);
+    CAlertsWindowEntryRef entry = alertsWindow.Get(pindex);
+    if (entry)
+        return entry;
+
+    return ReadBlockAlerts(pindex, params);
+}
+
+CAlertsWindowEntryRef TryGetAncestorAlerts(const CBlockIndex* pindexPrev, const Consensus::Params& params) {
+    AssertLockHeld(cs_main);
+    int nHeight = pindexPrev->nHeight + 1;
+    if (nHeight <= (int) params.nAlertsInitializationWindow) {
+        return nullptr;
     }
 
-    return true;
+    return TryGetBlockAlerts(pindexPrev->GetAncestor(nHeight - params.nAlertsInitializationWindow), params);
 }
 
 CAmount GetTxFee(const CBaseTransaction &tx, const CCoinsViewCache &inputs)
@@ -3754,22 +4129,54 @@ vaulttxntype GetVaultTxType(const CMutableTransaction& mtx) {
     return GetVaultTxType(btx);
 }
 
-vaulttxntype GetVaultTxType(const CBaseTransaction& tx, const CCoinsViewCache& view)
+/**
+ * Vault transaction types are needed several times on the way of a transaction
+ * to a block (mempool acceptance, mempool checks, block assembly, ConnectBlock,
+ * DisconnectBlock), each time parsing the scripts of all its inputs. The type
+ * only depends on the transaction and the scripts of the outputs it spends, so
+ * it is cached under a salted hash of the wtxid and the spent scriptPubKeys. As
+ * with the script execution cache the value is part of the key: a lookup tests
+ * every valid type.
+ *
+ * The key costs one SHA256 compression per 64 bytes of wtxid and spent scripts,
+ * about one per input for vault outputs. Computing the type evaluates each
+ * scriptSig into a stack, runs the solver over the scriptPubKey and the
+ * witness script and copies the stack elements, all of it allocating.
+ */
+static CCriticalSection cs_vaultTxTypeCache;
+static CuckooCache::cache<uint256, SignatureCacheHasher> vaultTxTypeCache GUARDED_BY(cs_vaultTxTypeCache);
+static uint256 vaultTxTypeCacheNonce(GetRandHash());
+static bool fVaultTxTypeCacheEnabled GUARDED_BY(cs_vaultTxTypeCache) = false;
+
+static const vaulttxntype CACHED_VAULT_TX_TYPES[] = {TX_NONVAULT, TX_ALERT, TX_INSTANT, TX_RECOVERY};
+
+void InitVaultTxTypeCache() {
+    LOCK(cs_vaultTxTypeCache);
+    size_t nElems = vaultTxTypeCache.setup_bytes(VAULT_TX_TYPE_CACHE_SIZE << 20);
+    fVaultTxTypeCacheEnabled = true;
+    LogPrintf("Using %zu MiB for vault transaction type cache, able to store %zu elements\n",
+            (nElems*sizeof(uint256)) >>20, nElems);
+}
+
+static uint256 GetVaultTxTypeCacheKey(const CSHA256& hasher, vaulttxntype txType)
 {
-    CMutableTransaction mutableTx = CMutableTransaction(tx);
-    if (tx.IsCoinBase() || mutableTx.vin.empty()) {
-        return TX_NONVAULT;
-    }
+    uint256 key;
+    const unsigned char type = txType;
+    CSHA256(hasher).Write(&type, 1).Finalize(key.begin());
+    return key;
+}
 
+static vaulttxntype ComputeVaultTxType(const CBaseTransaction& tx, const CCoinsViewCache& view)
+{
     bool hasAlertTxCoin = false;
     bool hasInstantTxCoin = false;
     bool hasRecoveryTxCoin = false;
     bool allAlertTxCoin = true;
-    for (unsigned int i = 0; i < mutableTx.vin.size(); i++) {
-        const Coin &coin = view.AccessCoin(mutableTx.vin[i].prevout);
+    for (const CTxIn& txin : tx.vin) {
+        const Coin &coin = view.AccessCoin(txin.prevout);
         SignatureData incompleteData;
-        incompleteData.scriptSig = mutableTx.vin[i].scriptSig;
-        incompleteData.scriptWitness = mutableTx.vin[i].scriptWitness;
+        incompleteData.scriptSig = txin.scriptSig;
+        incompleteData.scriptWitness = txin.scriptWitness;
         Stacks stack(incompleteData);
         txnouttype scriptType = ExtractDataFromIncompleteScript(incompleteData, stack, BaseSignatureChecker(), coin.out);
         if (scriptType == TX_VAULT_ALERTADDRESS || scriptType == TX_VAULT_INSTANTADDRESS) {
@@ -3803,9 +4210,46 @@ vaulttxntype GetVaultTxType(const CBaseTransaction& tx, const CCoinsViewCache& v
     return TX_NONVAULT;
 }
 
+vaulttxntype GetVaultTxType(const CBaseTransaction& tx, const CCoinsViewCache& view, bool* pfCached)
+{
+    if (pfCached) *pfCached = false;
+    if (tx.IsCoinBase() || tx.vin.empty()) {
+        return TX_NONVAULT;
+    }
+
+    CSHA256 hasher;
+    hasher.Write(vaultTxTypeCacheNonce.begin(), 32).Write(tx.GetWitnessHash().begin(), 32);
+    for (const CTxIn& txin : tx.vin) {
+        const CScript& scriptPubKey = view.AccessCoin(txin.prevout).out.scriptPubKey;
+        unsigned char buf[4];
+        WriteLE32(buf, scriptPubKey.size());
+        hasher.Write(buf, sizeof(buf)).Write(scriptPubKey.data(), scriptPubKey.size());
+    }
+
+    {
+        LOCK(cs_vaultTxTypeCache);
+        if (fVaultTxTypeCacheEnabled) {
+            for (const vaulttxntype txType : CACHED_VAULT_TX_TYPES) {
+                if (vaultTxTypeCache.contains(GetVaultTxTypeCacheKey(hasher, txType), false)) {
+                    if (pfCached) *pfCached = true;
+                    return txType;
+                }
+            }
+        }
+    }
+
+    const vaulttxntype txType = ComputeVaultTxType(tx, view);
+    if (txType != TX_INVALID) {
+        LOCK(cs_vaultTxTypeCache);
+        if (fVaultTxTypeCacheEnabled) {
+            vaultTxTypeCache.insert(GetVaultTxTypeCacheKey(hasher, txType));
+        }
+    }
+    return txType;
+}
+
 vaulttxntype GetVaultTxTypeNonContextual(const CBaseTransaction& tx) {
-    CMutableTransaction mutableTx = CMutableTransaction(tx);
-    if (tx.IsCoinBase() || mutableTx.vin.empty()) {
+    if (tx.IsCoinBase() || tx.vin.empty()) {
         return TX_NONVAULT;
     }
 
@@ -3813,8 +4257,7 @@ vaulttxntype GetVaultTxTypeNonContextual(const CBaseTransaction& tx) {
     bool hasInstantTxCoin = false;
     bool hasRecoveryTxCoin = false;
     bool allAlertTxCoin = true;
-    for (unsigned int i = 0; i < mutableTx.vin.size(); i++) {
-        const CTxIn &txin = mutableTx.vin[i];
+    for (const CTxIn& txin : tx.vin) {
         CScript script;
         std::vector<std::vector<unsigned char>> scriptSig;
         if (!txin.scriptWitness.IsNull()) {
@@ -3868,14 +4311,14 @@ vaulttxntype GetVaultTxTypeNonContextual(const CBaseTransaction& tx) {
     return TX_NONVAULT;
 }
 
-bool DdmsVerifyCoinbaseOutput(const CTransactionRef& cb, const unsigned int n) {
-       for (size_t k = 0; k < DDMS_ALLOWED_SCRIPTS_NUMBER; ++k) {
-		   const CScript& s = ddmsAllowedScripts[k] ;
-		   if ((cb->vout[n].scriptPubKey == s)) {
-			   return true;
-		   }
-       }
-	   return false;
+bool DdmsVerifyCoinbaseOutput(const CScript& scriptPubKey, const Consensus::Params& params) {
+	/* All allowed outputs are P2PKH, so only their key hash is looked up.  */
+	if (scriptPubKey.size() != DDMS_SCRIPT_LENGTH || scriptPubKey[0] != OP_DUP || scriptPubKey[1] != OP_HASH160
+	|| scriptPubKey[2] != 20 || scriptPubKey[23] != OP_EQUALVERIFY || scriptPubKey[24] != OP_CHECKSIG)
+		return false;
+
+	const uint160 keyID(std::vector<unsigned char>(scriptPubKey.begin() + DDMS_KEYID_OFFSET, scriptPubKey.begin() + DDMS_KEYID_OFFSET + 20));
+	return std::binary_search(params.vDDMSAllowedKeyIDs.begin(), params.vDDMSAllowedKeyIDs.end(), keyID);
 }
 
 // Compute at which vout of the block's coinbase transaction the witness
@@ -4097,8 +4540,9 @@ static bool ContextualCheckBlock(const CBlock& block, CValidationState& state, c
     // Check if the coinbase goes to the licensed addresses.
 	if (fCheckDdms && nHeight >= consensusParams.DDMSHeight) {
 	   CTransactionRef cb = block.vtx[0];
-	   for (int i = 0; i < cb->vout.size(); ++i) {
-			   if (i != GetWitnessCommitmentIndex(block) && !DdmsVerifyCoinbaseOutput(cb, i)) {
+	   const int commitpos = GetWitnessCommitmentIndex(block);
+	   for (int i = 0; i < (int)cb->vout.size(); ++i) {
+			   if (i != commitpos && !DdmsVerifyCoinbaseOutput(cb->vout[i].scriptPubKey, consensusParams)) {
 					   return state.DoS(100, false, REJECT_INVALID, "ddms-output-not-allowed", false, "");
 			   }
 	   }
@@ -4159,7 +4603,7 @@ static bool ContextualCheckBlock(const CBlock& block, CValidationState& state, c
     return true;
 }
 
-bool CChainState::AcceptBlockHeader(const CBlockHeader& block, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex)
+bool CChainState::AcceptBlockHeader(const CBlockHeader& block, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex, bool fCheckPOW)
 {
     AssertLockHeld(cs_main);
     // Check for duplicate
@@ -4177,7 +4621,7 @@ bool CChainState::AcceptBlockHeader(const CBlockHeader& block, CValidationState&
             return true;
         }
 
-        if (!CheckBlockHeader(block, state, chainparams.GetConsensus()))
+        if (!CheckBlockHeader(block, state, chainparams.GetConsensus(), fCheckPOW))
             return error("%s: Consensus::CheckBlockHeader: %s, %s", __func__, hash.ToString(), FormatStateMessage(state));
 
         // Get prev block index
@@ -4229,9 +4673,15 @@ bool CChainState::AcceptBlockHeader(const CBlockHeader& block, CValidationState&
             }
         }
     }
-    if (pindex == nullptr)
+    if (pindex == nullptr) {
         pindex = AddToBlockIndex(block);
 
+        // The block index does not hold the auxpow, store it separately for GetBlockHeader
+        if (block.IsAuxPow() && block.auxHeader && !pblocktree->WriteAuxBlockHeader(hash, *block.auxHeader)) {
+            LogPrintf("%s: failed to write auxpow header of %s\n", __func__, hash.ToString());
+        }
+    }
+
     if (ppindex)
         *ppindex = pindex;
 
@@ -4244,11 +4694,38 @@ bool CChainState::AcceptBlockHeader(const CBlockHeader& block, CValidationState&
 bool ProcessNewBlockHeaders(const std::vector<CBlockHeader>& headers, CValidationState& state, const CChainParams& chainparams, const CBlockIndex** ppindex, CBlockHeader *first_invalid)
 {
     if (first_invalid != nullptr) first_invalid->SetNull();
+
+    // Check the proof of work of the headers, including their auxpow, on the
+    // header check threads before taking cs_main. If any of them fails, the
+    // serial checks below find and report the first invalid header.
+    bool fPowChecked = false;
+    if (nScriptCheckThreads && headers.size() > 1) {
+        // Headers already in mapBlockIndex are not checked again by AcceptBlockHeader
+        std::vector<const CBlockHeader*> vUnknown;
+        {
+            LOCK(cs_main);
+            for (const CBlockHeader& header : headers) {
+                if (!LookupBlockIndex(header.GetHash())) {
+                    vUnknown.push_back(&header);
+                }
+            }
+        }
+
+        CCheckQueueControl<CHeaderCheck> control(&headercheckqueue);
+        std::vector<CHeaderCheck> vChecks;
+        for (size_t i = 0; i < vUnknown.size(); i += HEADER_CHECK_BATCH_SIZE) {
+            std::vector<const CBlockHeader*> vBatch(vUnknown.begin() + i, vUnknown.begin() + std::min(vUnknown.size(), i + HEADER_CHECK_BATCH_SIZE));
+            vChecks.emplace_back(std::move(vBatch), chainparams.GetConsensus());
+        }
+        control.Add(vChecks);
+        fPowChecked = control.Wait();
+    }
+
     {
         LOCK(cs_main);
         for (const CBlockHeader& header : headers) {
             CBlockIndex *pindex = nullptr; // Use a temp pindex instead of ppindex to avoid a const_cast
-            if (!g_chainstate.AcceptBlockHeader(header, state, chainparams, &pindex)) {
+            if (!g_chainstate.AcceptBlockHeader(header, state, chainparams, &pindex, !fPowChecked)) {
                 if (first_invalid) *first_invalid = header;
                 return false;
             }
@@ -4262,10 +4739,14 @@ bool ProcessNewBlockHeaders(const std::vector<CBlockHeader>& headers, CValidatio
 }
 
 /** Store block on disk. If dbp is non-nullptr, the file is known to already reside on disk */
-static CDiskBlockPos SaveBlockToDisk(const CBlock& block, int nHeight, const CChainParams& chainparams, const CDiskBlockPos* dbp) {
+static CDiskBlockPos SaveBlockToDisk(const CBlock& block, int nHeight, const CChainParams& chainparams, const CDiskBlockPos* dbp, const CBlockIndex* pindexPrev = nullptr) EXCLUSIVE_LOCKS_REQUIRED(cs_main) {
     block.fAlertsSerialization = AreAlertsEnabled(nHeight, chainparams.GetConsensus().AlertsHeight);
 
-    unsigned int nBlockSize = ::GetSerializeSize(block, CLIENT_VERSION);
+    // Blocks already on disk are kept in the format they were written in
+    std::vector<CDiskAlertRef> vAlertRefs;
+    const CBlock storedBlock = dbp == nullptr ? GetDiskAlertRefs(block, pindexPrev, chainparams.GetConsensus(), vAlertRefs) : block;
+
+    unsigned int nBlockSize = ::GetSerializeSize(storedBlock, CLIENT_VERSION) + (vAlertRefs.empty() ? 0 : ::GetSerializeSize(vAlertRefs, CLIENT_VERSION));
     CDiskBlockPos blockPos;
     if (dbp != nullptr)
         blockPos = *dbp;
@@ -4274,7 +4755,9 @@ static CDiskBlockPos SaveBlockToDisk(const CBlock& block, int nHeight, const CCh
         return CDiskBlockPos();
     }
     if (dbp == nullptr) {
-        if (!WriteBlockToDisk(block, blockPos, chainparams.MessageStartDisk())) {
+        if (!vAlertRefs.empty())
+            SetHaveAlertRefs();
+        if (!WriteBlockToDisk(storedBlock, blockPos, chainparams.MessageStartDisk(), vAlertRefs)) {
             AbortNode("Failed to write block");
             return CDiskBlockPos();
         }
@@ -4345,7 +4828,7 @@ bool CChainState::AcceptBlock(const std::shared_ptr<const CBlock>& pblock, CVali
     // Write block to history file
     if (fNewBlock) *fNewBlock = true;
     try {
-        CDiskBlockPos blockPos = SaveBlockToDisk(block, pindex->nHeight, chainparams, dbp);
+        CDiskBlockPos blockPos = SaveBlockToDisk(block, pindex->nHeight, chainparams, dbp, pindex->pprev);
         if (blockPos.IsNull()) {
             state.Error(strprintf("%s: Failed to find position to write new block to disk", __func__));
             return false;
@@ -4443,9 +4926,24 @@ void PruneOneBlockFile(const int fileNumber)
 {
     LOCK(cs_LastBlockFile);
 
+    // Reorgs of up to MIN_BLOCKS_TO_KEEP blocks reconnect blocks which confirm the alerts
+    // of, or recover alerts from, blocks up to nAlertsInitializationWindow further back.
+    // Keep the alerts data of those blocks when their files are deleted.
+    const Consensus::Params& consensusParams = Params().GetConsensus();
+    const int nMinAlertsHeight = chainActive.Height() - (int) (MIN_BLOCKS_TO_KEEP + consensusParams.nAlertsInitializationWindow + ALERTS_WINDOW_REORG_MARGIN);
+
     for (const auto& entry : mapBlockIndex) {
         CBlockIndex* pindex = entry.second;
         if (pindex->nFile == fileNumber) {
+            if ((pindex->nStatus & BLOCK_HAVE_DATA) && pindex->nHeight > nMinAlertsHeight && AreAlertsEnabled(pindex->nHeight, consensusParams.AlertsHeight)) {
+                CBlock block;
+                if (ReadBlockFromDisk(block, pindex, consensusParams)) {
+                    vDirtyPrunedAlerts.emplace_back(block, pindex->GetBlockHash());
+                } else {
+                    LogPrintf("%s: failed to read block %s, its alerts data is not kept\n", __func__, pindex->GetBlockHash().ToString());
+                }
+            }
+
             pindex->nStatus &= ~BLOCK_HAVE_DATA;
             pindex->nStatus &= ~BLOCK_HAVE_UNDO;
             pindex->nFile = 0;
@@ -4470,6 +4968,12 @@ void PruneOneBlockFile(const int fileNumber)
 
     vinfoBlockFile[fileNumber].SetNull();
     setDirtyFileInfo.insert(fileNumber);
+
+    pblocktree->ErasePrunedBlockAlerts([nMinAlertsHeight](const uint256& hash) {
+        AssertLockHeld(cs_main);
+        const CBlockIndex* pindex = LookupBlockIndex(hash);
+        return !pindex || pindex->nHeight <= nMinAlertsHeight;
+    });
 }
 
 
@@ -4749,6 +5253,11 @@ bool static LoadBlockIndexDB(const CChainParams& chainparams) EXCLUSIVE_LOCKS_RE
     if (fHavePruned)
         LogPrintf("LoadBlockIndexDB(): Block files have previously been pruned\n");
 
+    // Check whether block files hold alert references (-dedupalerts)
+    bool fAlertRefsBlockFiles = false;
+    pblocktree->ReadFlag("alertrefsblockfiles", fAlertRefsBlockFiles);
+    fHaveAlertRefs = fAlertRefsBlockFiles;
+
     // Check whether we need to continue reindexing
     bool fReindexing = false;
     pblocktree->ReadReindexing(fReindexing);
@@ -5165,7 +5674,9 @@ void UnloadBlockIndex()
     nLastBlockFile = 0;
     setDirtyBlockIndex.clear();
     setDirtyFileInfo.clear();
+    vDirtyPrunedAlerts.clear();
     versionbitscache.Clear();
+    alertsWindow.Clear();
     for (int b = 0; b < VERSIONBITS_NUM_BITS; b++) {
         warningcache[b].clear();
     }
@@ -5175,6 +5686,7 @@ void UnloadBlockIndex()
     }
     mapBlockIndex.clear();
     fHavePruned = false;
+    fHaveAlertRefs = false;
 
     g_chainstate.UnloadBlockIndex();
 }
@@ -5249,6 +5761,7 @@ bool LoadExternalBlockFile(const CChainParams& chainparams, FILE* fileIn, CDiskB
             nRewind++; // start one byte further next time, in case of failure
             blkdat.SetLimit(); // remove former limit
             unsigned int nSize = 0;
+            bool fAlertRefs = false;
             try {
                 // locate a header
                 unsigned char buf[CMessageHeader::MESSAGE_START_SIZE];
@@ -5259,6 +5772,8 @@ bool LoadExternalBlockFile(const CChainParams& chainparams, FILE* fileIn, CDiskB
                     continue;
                 // read size
                 blkdat >> nSize;
+                fAlertRefs = nSize & BLOCK_ALERT_REFS_FLAG;
+                nSize &= ~BLOCK_ALERT_REFS_FLAG;
                 if (nSize < 80 || nSize > MAX_BLOCK_SERIALIZED_SIZE)
                     continue;
             } catch (const std::exception&) {
@@ -5273,11 +5788,16 @@ bool LoadExternalBlockFile(const CChainParams& chainparams, FILE* fileIn, CDiskB
                 blkdat.SetLimit(nBlockPos + nSize);
                 std::shared_ptr<CBlock> pblock = std::make_shared<CBlock>();
                 CBlock& block = *pblock;
+                std::vector<CDiskAlertRef> vAlertRefs;
                 try {
                     blkdat.SetPos(nBlockPos);
                     block.fAlertsSerialization = true;
                     blkdat >> block;
+                    if (fAlertRefs)
+                        blkdat >> vAlertRefs;
                 } catch (const std::exception& e) {
+                    if (fAlertRefs)
+                        throw;
                     LogPrintf("%s: Deserializing without Alerts because of: %s\n", __func__, e.what());
                     blkdat.SetPos(nBlockPos);
                     block.fAlertsSerialization = false;
@@ -5285,6 +5805,15 @@ bool LoadExternalBlockFile(const CChainParams& chainparams, FILE* fileIn, CDiskB
                 }
                 nRewind = blkdat.GetPos();
 
+                // Positions in the references are only meaningful in our own block files (-reindex)
+                if (fAlertRefs && !(dbp ? ExpandDiskAlertRefs(block, vAlertRefs) : ExpandDiskAlertRefsFromIndex(block, vAlertRefs, chainparams.GetConsensus()))) {
+                    LogPrintf("%s: Failed to expand alert references of block at %s\n", __func__, dbp ? dbp->ToString() : "");
+                    continue;
+                }
+                // Reindexed blocks stay where they are, with their references
+                if (fAlertRefs && dbp)
+                    SetHaveAlertRefs();
+
                 uint256 hash = block.GetHash();
                 {
                     LOCK(cs_main);
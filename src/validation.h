@@ -10,6 +10,7 @@
 #include <config/bitcoin-config.h>
 #endif
 
+#include <alertswindow.h>
 #include <amount.h>
 #include <coins.h>
 #include <crypto/common.h> // for ReadLE64
@@ -125,6 +126,8 @@ static const int64_t MAX_FEE_ESTIMATION_TIP_AGE = 3 * 60 * 60;
 static const bool DEFAULT_PERMIT_BAREMULTISIG = true;
 static const bool DEFAULT_CHECKPOINTS_ENABLED = true;
 static const bool DEFAULT_TXINDEX = false;
+static const bool DEFAULT_ALERTINDEX = false;
+static const bool DEFAULT_DEDUP_ALERTS = false;
 static const unsigned int DEFAULT_BANSCORE_THRESHOLD = 100;
 /** Default for -persistmempool */
 static const bool DEFAULT_PERSIST_MEMPOOL = true;
@@ -196,6 +199,10 @@ static const uint64_t nMinDiskSpace = 52428800;
 extern bool fHavePruned;
 /** True if we're running in -prune mode. */
 extern bool fPruneMode;
+/** True if confirmed alerts of new blocks are stored as references to the ancestor block's vatx (-dedupalerts). */
+extern bool fDedupAlerts;
+/** True if any block file has ever held confirmed alerts stored as references (-dedupalerts). */
+extern std::atomic_bool fHaveAlertRefs;
 /** Number of MiB of block files that we're trying to stay below. */
 extern uint64_t nPruneTarget;
 /** Block files containing a block-height within MIN_BLOCKS_TO_KEEP of chainActive.Tip() will not be pruned. */
@@ -271,12 +278,26 @@ bool LoadChainTip(const CChainParams& chainparams) EXCLUSIVE_LOCKS_REQUIRED(cs_m
 void UnloadBlockIndex();
 /** Run an instance of the script checking thread */
 void ThreadScriptCheck();
+/** Run an instance of the header proof of work checking thread */
+void ThreadHeaderCheck();
+/** Check whether a coinbase output pays to one of the outputs allowed once DDMS is active */
+bool DdmsVerifyCoinbaseOutput(const CScript& scriptPubKey, const Consensus::Params& params);
 /** Check whether we are doing an initial block download (synchronizing from disk or network) */
 bool IsInitialBlockDownload();
 /** Retrieve a transaction (from memory pool, or from disk, if possible) */
 bool GetTransaction(const uint256& hash, CBaseTransactionRef& tx, const Consensus::Params& params, uint256& hashBlock, const CBlockIndex* const blockIndex = nullptr, vaulttxnstatus* txStatus = nullptr);
 /** Retrieve a transaction status (by scanning memory pool, or from disk, if possible) */
 vaulttxnstatus GetTransactionStatus(const uint256& hash, const Consensus::Params& params, vaulttxntype txType = TX_NONVAULT, const CBlockIndex* const blockIndex = nullptr);
+/**
+ * Match the inputs of a recovery with the alerts they revert using g_alertindex.
+ *
+ * Returns false if the index is disabled or cannot resolve every input to an
+ * alert mined on the chain ending at pindexPrev, in which case the caller has
+ * to match the inputs against the ancestor blocks. fMatch is only set if true
+ * is returned: it tells whether the recovery reverts all inputs of every alert
+ * it touches.
+ */
+bool MatchRecoveryWithAlertIndex(const CTransaction& tx, const CCoinsViewCache& inputs, const CBlockIndex* pindexPrev, bool& fMatch);
 /**
  * Find the best known block, and make it the tip of the block chain
  *
@@ -406,15 +427,26 @@ public:
     ScriptError GetScriptError() const { return error; }
 };
 
-/** Initializes the script-execution cache */
+/** Initializes the script-execution and verified alert caches */
 void InitScriptExecutionCache();
 
+/** Size of the cache of alerts whose scripts were verified when mined in a block's vatx (MiB) */
+static const unsigned int VERIFIED_ALERT_CACHE_SIZE = 2;
+
+/** Size of the vault transaction type cache (MiB) */
+static const unsigned int VAULT_TX_TYPE_CACHE_SIZE = 4;
+
+/** Initializes the vault transaction type cache used by GetVaultTxType */
+void InitVaultTxTypeCache();
+
 
 /** Functions for disk access for blocks */
 bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, const Consensus::Params& consensusParams, bool fAlertsSerialization = false);
 bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus::Params& consensusParams);
 bool ReadRawBlockFromDisk(std::vector<uint8_t>& block, const CDiskBlockPos& pos, const CMessageHeader::MessageStartChars& message_start);
 bool ReadRawBlockFromDisk(std::vector<uint8_t>& block, const CBlockIndex* pindex, const CMessageHeader::MessageStartChars& message_start);
+/** Check whether the block at pos was stored with its confirmed alerts as references (-dedupalerts) */
+bool ReadBlockAlertRefsFlag(const CDiskBlockPos& pos, bool& fAlertRefs);
 
 /** Functions for validating blocks and updating the block tree */
 
@@ -433,15 +465,28 @@ bool IsNullDummyEnabled(const CBlockIndex* pindexPrev, const Consensus::Params&
 /** Check whether Alerts has activated. */
 bool AreAlertsEnabled(int nHeight, int nAlertsHeight);
 
-/** Get ancestor block. */
-bool GetAncestorBlock(CBlockIndex* pindexPrev, const Consensus::Params& params, CBlock& ancestorBlock);
+/** Get alerts data of an active chain block, from alertsWindow if possible. */
+CAlertsWindowEntryRef GetBlockAlerts(const CBlockIndex* pindex, const Consensus::Params& params) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
+/** Get alerts data of the block whose alerts are confirmed in the block following pindexPrev.
+ *  Returns nullptr if the chain is not longer than nAlertsInitializationWindow. */
+CAlertsWindowEntryRef GetAncestorAlerts(const CBlockIndex* pindexPrev, const Consensus::Params& params) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
+/** Like GetBlockAlerts, but returns nullptr instead of failing if the block is not available on disk.
+ *  Alerts of blocks outside the active chain are returned without being cached. */
+CAlertsWindowEntryRef TryGetBlockAlerts(const CBlockIndex* pindex, const Consensus::Params& params) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
+/** Like GetAncestorAlerts, but returns nullptr instead of failing if the ancestor block is not available on disk.
+ *  Used for blocks which are not (yet) validated, e.g. when relaying compact blocks. */
+CAlertsWindowEntryRef TryGetAncestorAlerts(const CBlockIndex* pindexPrev, const Consensus::Params& params) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
 /** Calculate tx fee. */
 CAmount GetTxFee(const CBaseTransaction& tx, const CCoinsViewCache& inputs);
 
 /** Check what VaultTxType tx has based on Coins scripts **/
 vaulttxntype GetVaultTxTypeFromStackScript(const std::vector<valtype>& script, txnouttype scriptType = TX_VAULT_ALERTADDRESS);
-vaulttxntype GetVaultTxType(const CBaseTransaction& tx, const CCoinsViewCache& view);
+/** Check what VaultTxType tx has based on the coins it spends; pfCached reports whether the type came from the cache */
+vaulttxntype GetVaultTxType(const CBaseTransaction& tx, const CCoinsViewCache& view, bool* pfCached = nullptr);
 vaulttxntype GetVaultTxType(const CBaseTransaction& btx);
 vaulttxntype GetVaultTxType(const CMutableTransaction& mtx);
 /** Check what VaultTxType tx has based on vin scripts
@@ -471,7 +516,7 @@ std::vector<unsigned char> GenerateCoinbaseCommitment(CBlock& block, const CBloc
  * @param params Consensus parameters.
  * @return True if the PoW is correct.
  */
-bool CheckProofOfWork(const CBlockHeader& block, const Consensus::Params& params);
+bool CheckProofOfWork(const CBlockHeader& block, const Consensus::Params& params, bool fCheckAuxPow = true);
 
 /** RAII wrapper for VerifyDB: Verify consistency of the block and coin databases */
 class CVerifyDB {
@@ -528,6 +573,9 @@ int GetSpendHeight(const CCoinsViewCache& inputs);
 
 extern VersionBitsCache versionbitscache;
 
+/** Alerts of the last nAlertsInitializationWindow blocks of the active chain */
+extern CAlertsWindow alertsWindow;
+
 /**
  * Determine what nVersion a new block should use.
  */
@@ -9,7 +9,7 @@
  * network protocol versioning
  */
 
-static const int PROTOCOL_VERSION = 70016;
+static const int PROTOCOL_VERSION = 70017;
 
 //! initial proto version, to be increased after version/verack negotiation
 static const int INIT_PROTO_VERSION = 209;
@@ -44,4 +44,7 @@ static const int INVALID_CB_NO_BAN_VERSION = 70015;
 
 static const int ALERTS_VERSION = 70016;
 
+//! cmpctblock encoding confirmed alerts as a bitmap over the ancestor block's vatx starts with this version
+static const int DERIVED_ALERTS_VERSION = 70017;
+
 #endif // BITCOIN_VERSION_H
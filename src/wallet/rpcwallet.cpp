@@ -13,6 +13,7 @@
 #include <validation.h>
 #include <key_io.h>
 #include <net.h>
+#include <net_processing.h>
 #include <node/transaction.h>
 #include <outputtype.h>
 #include <policy/feerate.h>
@@ -42,7 +43,10 @@
 
 #include <univalue.h>
 
+#include <atomic>
 #include <functional>
+#include <system_error>
+#include <thread>
 
 static const std::string WALLET_ENDPOINT_BASE = "/wallet/";
 
@@ -4813,6 +4817,58 @@ UniValue walletcreatefundedpsbt(const JSONRPCRequest& request)
     return result;
 }
 
+/** Construct a transaction spending all inputs of the wallet alert atxid to the given outputs. */
+static CMutableTransaction ConstructRecoveryTransaction(CWallet* const pwallet, const UniValue& atxid, const UniValue& outputs, const UniValue& locktime, const UniValue& replaceable) EXCLUSIVE_LOCKS_REQUIRED(pwallet->cs_wallet)
+{
+    uint256 hash(ParseHashV(atxid, "atxid"));
+    auto it = pwallet->mapWallet.find(hash);
+    if (it == pwallet->mapWallet.end()) {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid or non-wallet transaction id");
+    }
+    const CWalletTx& wtx = it->second;
+
+    UniValue inputsToRecover(UniValue::VARR);
+    for (const CTxIn& txin : wtx.tx->vin) {
+        UniValue in(UniValue::VOBJ);
+        in.pushKV("txid", txin.prevout.hash.GetHex());
+        in.pushKV("vout", (int64_t)txin.prevout.n);
+        inputsToRecover.push_back(in);
+    }
+
+    return ConstructTransaction(inputsToRecover, outputs, locktime, replaceable);
+}
+
+/** Build the prevtxs argument of SignTransaction for the wallet vault outputs spent by a recovery. */
+static UniValue RecoveryPrevTxs(CWallet* const pwallet, const CMutableTransaction& mtx, const UniValue& redeemScript, const UniValue& witnessScript) EXCLUSIVE_LOCKS_REQUIRED(pwallet->cs_wallet)
+{
+    UniValue recovery_data(UniValue::VARR);
+    for (const CTxIn& vin : mtx.vin) {
+        UniValue prevTx(UniValue::VOBJ);
+
+        // get scriptPubKey
+        auto it = pwallet->mapWallet.find(vin.prevout.hash);
+        if (it == pwallet->mapWallet.end()) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid or non-wallet transaction id");
+        }
+        const CWalletTx& wtx = it->second;
+        if (vin.prevout.n >= wtx.tx->vout.size()) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "vout must be less than the number of outputs");
+        }
+        const CScript& scriptPubKey = wtx.tx->vout[vin.prevout.n].scriptPubKey;
+        const CAmount amount = wtx.tx->GetValueOut();
+
+        prevTx.pushKV("txid", vin.prevout.hash.GetHex());
+        prevTx.pushKV("vout", uint64_t(vin.prevout.n));
+        prevTx.pushKV("scriptPubKey", HexStr(scriptPubKey.begin(), scriptPubKey.end()));
+        prevTx.pushKV("redeemScript", redeemScript);
+        prevTx.pushKV("witnessScript", witnessScript);
+        prevTx.pushKV("amount", ValueFromAmount(amount).getValStr());
+
+        recovery_data.push_back(prevTx);
+    }
+    return recovery_data;
+}
+
 static UniValue createrecoverytransaction(const JSONRPCRequest& request)
 {
     std::shared_ptr<CWallet> const wallet = GetWalletForJSONRPCRequest(request);
@@ -4880,31 +4936,7 @@ static UniValue createrecoverytransaction(const JSONRPCRequest& request)
     auto locked_chain = pwallet->chain().lock();
     LOCK(pwallet->cs_wallet);
 
-    uint256 hash(ParseHashV(request.params[0], "atxid"));
-    auto it = pwallet->mapWallet.find(hash);
-    if (it == pwallet->mapWallet.end()) {
-        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid or non-wallet transaction id");
-    }
-    const CWalletTx& wtx = it->second;
-    std::string wtxHex = EncodeHexTx(*wtx.tx, RPCSerializationFlags());
-
-    CMutableTransaction mtx;
-    bool try_witness = true;
-    bool try_no_witness = true;
-    if (!DecodeHexTx(mtx, wtxHex, try_no_witness, try_witness)) {
-        throw JSONRPCError(RPC_DESERIALIZATION_ERROR, "TX decode failed");
-    }
-
-    UniValue inputsToRecover(UniValue::VARR);
-    for (unsigned int i = 0; i < mtx.vin.size(); i++) {
-        const CTxIn &txin = mtx.vin[i];
-        UniValue in(UniValue::VOBJ);
-        in.pushKV("txid", txin.prevout.hash.GetHex());
-        in.pushKV("vout", (int64_t)txin.prevout.n);
-        inputsToRecover.push_back(in);
-    }
-
-    CMutableTransaction recoveryTx = ConstructTransaction(inputsToRecover, request.params[1], request.params[2], request.params[3]);
+    CMutableTransaction recoveryTx = ConstructRecoveryTransaction(pwallet, request.params[0], request.params[1], request.params[2], request.params[3]);
     return EncodeHexTx(CTransaction(recoveryTx));
 }
 
@@ -4974,36 +5006,244 @@ static UniValue signrecoverytransaction(const JSONRPCRequest& request)
     CBasicKeyStore keystore;
     CreateTempKeystoreFrom(pwallet, request.params[1], keystore);
 
-    UniValue recovery_data(UniValue::VARR);
-    for (unsigned int i = 0; i < mtx.vin.size(); ++i) {
-        const CTxIn& vin = mtx.vin[i];
-        UniValue prevTx(UniValue::VOBJ);
+    UniValue recovery_data;
+    {
+        auto locked_chain = pwallet->chain().lock();
+        LOCK(pwallet->cs_wallet);
+        recovery_data = RecoveryPrevTxs(pwallet, mtx, request.params[2], request.params[3]);
+    }
 
-        // get scriptPubKey
-        auto it = pwallet->mapWallet.find(vin.prevout.hash);
-        if (it == pwallet->mapWallet.end()) {
-            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid or non-wallet transaction id");
+    return SignTransaction(pwallet->chain(), mtx, recovery_data, &keystore, true, request.params[4], /*expectSpent = */true, TX_RECOVERY);
+}
+
+static UniValue createrecoverytransactions(const JSONRPCRequest& request)
+{
+    std::shared_ptr<CWallet> const wallet = GetWalletForJSONRPCRequest(request);
+    CWallet* const pwallet = wallet.get();
+
+    if (!EnsureWalletIsAvailable(pwallet, request.fHelp)) {
+        return NullUniValue;
+    }
+
+    if (request.fHelp || request.params.size() < 1 || request.params.size() > 3) {
+        throw std::runtime_error(
+                RPCHelpMan{"createrecoverytransactions",
+                           "\nCreate a recovery transaction for each of the given alert ids, like createrecoverytransaction.\n"
+                           "Returns an array of hex-encoded raw transactions, in the order of the alerts.\n"
+                           "Note that the transactions' inputs are not signed, and\n"
+                           "they are not stored in the wallet or transmitted to the network.\n",
+                           {
+                                   {"alerts", RPCArg::Type::ARR, RPCArg::Optional::NO, "A json array of alerts to recover",
+                                    {
+                                            {"", RPCArg::Type::OBJ, RPCArg::Optional::OMITTED, "",
+                                             {
+                                                     {"atxid", RPCArg::Type::STR_HEX, RPCArg::Optional::NO, "The transaction id"},
+                                                     {"outputs", RPCArg::Type::ARR, RPCArg::Optional::NO, "The outputs of the recovery, as in createrecoverytransaction"},
+                                             },
+                                            },
+                                    },
+                                   },
+                                   {"locktime", RPCArg::Type::NUM, /* default */ "0", "Raw locktime. Non-0 value also locktime-activates inputs"},
+                                   {"replaceable", RPCArg::Type::BOOL, /* default */ "false", "Marks these transactions as BIP125-replaceable."},
+                           },
+                           RPCResult{
+                                   "[\n"
+                                   "  \"transaction\"            (string) hex string of the transaction\n"
+                                   "  ,...\n"
+                                   "]\n"
+                           },
+                           RPCExamples{
+                                   HelpExampleCli("createrecoverytransactions", "\"[{\\\"atxid\\\":\\\"myid\\\",\\\"outputs\\\":[{\\\"address\\\":0.01}]}]\"")
+                                   + HelpExampleRpc("createrecoverytransactions", "\"[{\\\"atxid\\\":\\\"myid\\\",\\\"outputs\\\":[{\\\"address\\\":0.01}]}]\"")
+                           },
+                }.ToString());
+    }
+
+    RPCTypeCheck(request.params, {UniValue::VARR, UniValue::VNUM, UniValue::VBOOL}, true);
+
+    // Make sure the results are valid at least up to the most recent block
+    // the user could have gotten from another RPC command prior to now
+    pwallet->BlockUntilSyncedToCurrentChain();
+
+    auto locked_chain = pwallet->chain().lock();
+    LOCK(pwallet->cs_wallet);
+
+    const UniValue& alerts = request.params[0].get_array();
+    UniValue result(UniValue::VARR);
+    for (unsigned int idx = 0; idx < alerts.size(); ++idx) {
+        const UniValue& alert = alerts[idx];
+        if (!alert.isObject()) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid parameter, expected object with {\"atxid\",\"outputs\"}");
         }
-        const CWalletTx& wtx = it->second;
-        std::string strHex = EncodeHexTx(*wtx.tx, RPCSerializationFlags());
-        CMutableTransaction ptx;
-        if (!DecodeHexTx(ptx, strHex, true)) {
-            throw JSONRPCError(RPC_DESERIALIZATION_ERROR, "TX decode failed");
+        RPCTypeCheckObj(alert,
+            {
+                {"atxid", UniValueType(UniValue::VSTR)},
+                {"outputs", UniValueType()}, // ARR or OBJ, checked later
+            });
+        CMutableTransaction recoveryTx = ConstructRecoveryTransaction(pwallet, find_value(alert, "atxid"), find_value(alert, "outputs"), request.params[1], request.params[2]);
+        result.push_back(EncodeHexTx(CTransaction(recoveryTx)));
+    }
+    return result;
+}
+
+/**
+ * Sign the recovery transactions with SignTransaction on as many threads as
+ * -par allows for script verification. SignTransaction only holds cs_main and
+ * mempool.cs while it looks up the spent coins, so producing and verifying the
+ * signatures runs concurrently. Errors are reported per transaction, so one
+ * bad entry does not stop the batch.
+ */
+static std::vector<UniValue> SignRecoveryTransactions(interfaces::Chain& chain, std::vector<CMutableTransaction>& vmtx, const std::vector<UniValue>& vPrevTxs, CBasicKeyStore& keystore, const UniValue& hashType)
+{
+    std::vector<UniValue> results(vmtx.size());
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        for (size_t i = next++; i < vmtx.size(); i = next++) {
+            try {
+                results[i] = SignTransaction(chain, vmtx[i], vPrevTxs[i], &keystore, true, hashType, /*expectSpent = */true, TX_RECOVERY);
+                continue;
+            } catch (const UniValue& objError) {
+                results[i] = UniValue(UniValue::VOBJ);
+                results[i].pushKV("error", find_value(objError, "message"));
+            } catch (const std::exception& e) {
+                results[i] = UniValue(UniValue::VOBJ);
+                results[i].pushKV("error", e.what());
+            } catch (...) {
+                results[i] = UniValue(UniValue::VOBJ);
+                results[i].pushKV("error", "unknown error");
+            }
+            results[i].pushKV("hex", EncodeHexTx(CTransaction(vmtx[i])));
+            results[i].pushKV("complete", false);
         }
-        const CScript& scriptPubKey = ptx.vout[vin.prevout.n].scriptPubKey;
-        const CAmount amount = wtx.tx->GetValueOut();
+    };
 
-        prevTx.pushKV("txid", vin.prevout.hash.GetHex());
-        prevTx.pushKV("vout", uint64_t(vin.prevout.n));
-        prevTx.pushKV("scriptPubKey", HexStr(scriptPubKey.begin(), scriptPubKey.end()));
-        prevTx.pushKV("redeemScript", request.params[2]);
-        prevTx.pushKV("witnessScript", request.params[3]);
-        prevTx.pushKV("amount", ValueFromAmount(amount).getValStr());
+    // The calling thread is one of the workers, like the master of a CCheckQueue
+    const size_t nThreads = std::min<size_t>(std::max(nScriptCheckThreads, 1), vmtx.size());
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < nThreads; ++i) {
+        try {
+            threads.emplace_back(worker);
+        } catch (const std::system_error& e) {
+            LogPrintf("%s: signing with %u threads: %s\n", __func__, threads.size() + 1, e.what());
+            break;
+        }
+    }
+    worker();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    return results;
+}
 
-        recovery_data.push_back(prevTx);
+static UniValue signrecoverytransactions(const JSONRPCRequest& request)
+{
+    std::shared_ptr<CWallet> const wallet = GetWalletForJSONRPCRequest(request);
+    CWallet* const pwallet = wallet.get();
+
+    if (!EnsureWalletIsAvailable(pwallet, request.fHelp)) {
+        return NullUniValue;
     }
 
-    return SignTransaction(pwallet->chain(), mtx, recovery_data, &keystore, true, request.params[4], /*expectSpent = */true, TX_RECOVERY);
+    if (request.fHelp || request.params.size() < 3 || request.params.size() > 6)
+        throw std::runtime_error(
+                RPCHelpMan{"signrecoverytransactions",
+                           "\nSign inputs for many raw recovery transactions (serialized, hex-encoded) at once, like signrecoverytransaction.\n"
+                           "The transactions are signed on up to -par threads and, if broadcast is set, the complete ones\n"
+                           "are submitted to the mempool together and relayed.\n",
+                           {
+                                   {"hexstrings", RPCArg::Type::ARR, RPCArg::Optional::NO, "A json array of recovery transaction hex strings",
+                                    {
+                                            {"hexstring", RPCArg::Type::STR_HEX, RPCArg::Optional::OMITTED, "The recovery transaction hex string"},
+                                    },
+                                   },
+                                   {"privkeys", RPCArg::Type::ARR, RPCArg::Optional::NO, "A json array of base58-encoded private keys for signing",
+                                    {
+                                            {"privatekey", RPCArg::Type::STR_HEX, RPCArg::Optional::OMITTED, "private key in base58-encoding"},
+                                    },
+                                   },
+                                   {"redeemScript", RPCArg::Type::STR_HEX, RPCArg::Optional::NO, "(required for P2SH) redeem script"},
+                                   {"witnessScript", RPCArg::Type::STR_HEX, RPCArg::Optional::OMITTED_NAMED_ARG, "(required for P2WSH or P2SH-P2WSH) witness script"},
+                                   {"sighashtype", RPCArg::Type::STR, /* default */ "ALL", "The signature hash type, as in signrecoverytransaction"},
+                                   {"broadcast", RPCArg::Type::BOOL, /* default */ "false", "Submit the complete transactions to the mempool and relay them"},
+                           },
+                           RPCResult{
+                                   "[\n"
+                                   "  {\n"
+                                   "    \"hex\" : \"value\",                (string) The hex-encoded raw transaction with signature(s)\n"
+                                   "    \"complete\" : true|false,        (boolean) If the transaction has a complete set of signatures\n"
+                                   "    \"errors\" : [ ... ],             (json array of objects) Script verification errors, as in signrecoverytransaction\n"
+                                   "    \"error\" : \"text\",               (string) Set if the transaction could not be signed\n"
+                                   "    \"txid\" : \"hash\",                (string) The transaction id, if broadcast and accepted to the mempool\n"
+                                   "    \"reject-reason\" : \"text\"        (string) The mempool rejection reason, if broadcast and rejected\n"
+                                   "  }\n"
+                                   "  ,...\n"
+                                   "]\n"
+                           },
+                           RPCExamples{
+                                   HelpExampleCli("signrecoverytransactions", "\"[\\\"myhex\\\"]\" \"[\\\"key\\\"]\" \"myredeemscript\"")
+                                   + HelpExampleRpc("signrecoverytransactions", "[\"myhex\"], [\"key\"], \"myredeemscript\"")
+                           },
+                }.ToString());
+
+    RPCTypeCheck(request.params, {UniValue::VARR, UniValue::VARR, UniValue::VSTR, UniValue::VSTR, UniValue::VSTR, UniValue::VBOOL}, true);
+
+    const UniValue& hexstrings = request.params[0].get_array();
+    std::vector<CMutableTransaction> vmtx(hexstrings.size());
+    for (unsigned int idx = 0; idx < hexstrings.size(); ++idx) {
+        if (!DecodeHexTx(vmtx[idx], hexstrings[idx].get_str(), true)) {
+            throw JSONRPCError(RPC_DESERIALIZATION_ERROR, strprintf("TX decode failed for transaction %d", idx));
+        }
+    }
+    const bool fBroadcast = !request.params[5].isNull() && request.params[5].get_bool();
+
+    CBasicKeyStore keystore;
+    CreateTempKeystoreFrom(pwallet, request.params[1], keystore);
+
+    std::vector<UniValue> vPrevTxs;
+    vPrevTxs.reserve(vmtx.size());
+    {
+        auto locked_chain = pwallet->chain().lock();
+        LOCK(pwallet->cs_wallet);
+        for (const CMutableTransaction& mtx : vmtx) {
+            vPrevTxs.push_back(RecoveryPrevTxs(pwallet, mtx, request.params[2], request.params[3]));
+        }
+    }
+
+    std::vector<UniValue> results = SignRecoveryTransactions(pwallet->chain(), vmtx, vPrevTxs, keystore, request.params[4]);
+
+    if (fBroadcast) {
+        std::vector<CTransactionRef> vAccepted;
+        {
+            auto locked_chain = pwallet->chain().lock();
+            LockAnnotation lock(::cs_main);
+            for (size_t i = 0; i < vmtx.size(); ++i) {
+                if (!find_value(results[i], "complete").isTrue()) {
+                    continue;
+                }
+                CTransactionRef tx = MakeTransactionRef(std::move(vmtx[i]));
+                CValidationState state;
+                if (!AcceptToMemoryPool(mempool, state, tx, nullptr /* pfMissingInputs */,
+                                        nullptr /* plTxnReplaced */, false /* bypass_limits */, maxTxFee)) {
+                    results[i].pushKV("reject-reason", FormatStateMessage(state));
+                    continue;
+                }
+                results[i].pushKV("txid", tx->GetHash().GetHex());
+                vAccepted.push_back(tx);
+            }
+        }
+
+        if (g_connman) {
+            for (const CTransactionRef& tx : vAccepted) {
+                RelayTransaction(*tx, g_connman.get());
+            }
+        }
+    }
+
+    UniValue result(UniValue::VARR);
+    for (UniValue& res : results) {
+        result.push_back(std::move(res));
+    }
+    return result;
 }
 
 static UniValue signinstanttransaction(const JSONRPCRequest& request)
@@ -5204,6 +5444,8 @@ static const CRPCCommand commands[] =
     { "wallet",             "gettransaction",                   &gettransaction,                {"txid","include_watchonly"} },
     { "wallet",             "createrecoverytransaction",        &createrecoverytransaction,     {"atxid","outputs","locktime","replaceable"} },
     { "wallet",             "signrecoverytransaction",          &signrecoverytransaction,       {"hexstring","privkeys","redeemScript","witnessScript","sighashtype"} },
+    { "wallet",             "createrecoverytransactions",       &createrecoverytransactions,    {"alerts","locktime","replaceable"} },
+    { "wallet",             "signrecoverytransactions",         &signrecoverytransactions,      {"hexstrings","privkeys","redeemScript","witnessScript","sighashtype","broadcast"} },
     { "wallet",             "signinstanttransaction",           &signinstanttransaction,        {"hexstring","privkeys","prevtxs","sighashtype"} },
     { "wallet",             "signalerttransaction",             &signalerttransaction,          {"hexstring","prevtxs","sighashtype"} },
     { "wallet",             "getunconfirmedbalance",            &getunconfirmedbalance,         {} },
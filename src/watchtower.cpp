@@ -0,0 +1,299 @@
+// Copyright (c) 2020 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <watchtower.h>
+
+#include <chainparams.h>
+#include <clientversion.h>
+#include <consensus/validation.h>
+#include <fs.h>
+#include <net.h>
+#include <net_processing.h>
+#include <streams.h>
+#include <txmempool.h>
+#include <util/system.h>
+#include <validation.h>
+
+#include <algorithm>
+#include <set>
+
+static const uint64_t WATCHTOWER_DUMP_VERSION = 1;
+
+std::unique_ptr<CWatchtower> g_watchtower;
+
+void CWatchtower::AddUnchecked(const CTransactionRef& tx)
+{
+    if (!mapRecoveries.emplace(tx->GetHash(), tx).second) {
+        return;
+    }
+    for (const CTxIn& txin : tx->vin) {
+        mapOutpoints[txin.prevout].push_back(tx->GetHash());
+    }
+}
+
+void CWatchtower::RemoveUnchecked(const uint256& txid)
+{
+    auto it = mapRecoveries.find(txid);
+    if (it == mapRecoveries.end()) {
+        return;
+    }
+    for (const CTxIn& txin : it->second->vin) {
+        auto itOutpoint = mapOutpoints.find(txin.prevout);
+        if (itOutpoint == mapOutpoints.end()) {
+            continue;
+        }
+        std::vector<uint256>& txids = itOutpoint->second;
+        txids.erase(std::remove(txids.begin(), txids.end(), txid), txids.end());
+        if (txids.empty()) {
+            mapOutpoints.erase(itOutpoint);
+        }
+    }
+    mapSpentHeight.erase(txid);
+    mapRecoveries.erase(it);
+}
+
+std::vector<CTransactionRef> CWatchtower::FindRecoveries(const CBaseTransaction& alert) const
+{
+    std::vector<CTransactionRef> vRecoveries;
+    LOCK(cs);
+    if (mapOutpoints.empty()) {
+        return vRecoveries;
+    }
+
+    std::set<uint256> setTxids;
+    for (const CTxIn& txin : alert.vin) {
+        auto it = mapOutpoints.find(txin.prevout);
+        if (it == mapOutpoints.end()) {
+            continue;
+        }
+        for (const uint256& txid : it->second) {
+            if (setTxids.insert(txid).second) {
+                vRecoveries.push_back(mapRecoveries.at(txid));
+            }
+        }
+    }
+    return vRecoveries;
+}
+
+void CWatchtower::SubmitRecoveries(const CBaseTransaction& alert)
+{
+    for (const CTransactionRef& tx : FindRecoveries(alert)) {
+        const uint256& hash = tx->GetHash();
+        CValidationState state;
+        {
+            LOCK(cs_main);
+            if (mempool.exists(hash)) {
+                continue;
+            }
+            if (!AcceptToMemoryPool(mempool, state, tx, nullptr /* pfMissingInputs */,
+                                    nullptr /* plTxnReplaced */, false /* bypass_limits */, 0 /* nAbsurdFee */)) {
+                LogPrintf("Watchtower: recovery %s of alert %s not accepted: %s\n",
+                          hash.ToString(), alert.GetHash().ToString(), FormatStateMessage(state));
+                continue;
+            }
+        }
+        LogPrintf("Watchtower: submitted recovery %s of alert %s\n", hash.ToString(), alert.GetHash().ToString());
+
+        if (g_connman) {
+            RelayTransaction(*tx, g_connman.get());
+        }
+    }
+}
+
+void CWatchtower::TransactionAddedToMempool(const CTransactionRef& ptx)
+{
+    if (GetVaultTxTypeNonContextual(*ptx) == TX_ALERT) {
+        SubmitRecoveries(*ptx);
+    }
+}
+
+void CWatchtower::BlockConnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex, const std::vector<CTransactionRef>& txnConflicted)
+{
+    // Alerts are usually seen in the mempool first, where the recovery may be
+    // rejected as a conflict. Once the alert is mined the recovery is valid.
+    for (const CAlertTransactionRef& atx : block->vatx) {
+        SubmitRecoveries(*atx);
+    }
+
+    // Regular transactions spend vault outpoints for good once their block is buried. Until
+    // then a reorg may bring the alert back, so the recoveries are kept.
+    const int nForgetHeight = pindex->nHeight - Params().GetConsensus().nAlertsInitializationWindow;
+    bool fChanged = false;
+    {
+        LOCK(cs);
+        if (mapRecoveries.empty()) {
+            return;
+        }
+        for (const CTransactionRef& tx : block->vtx) {
+            for (const CTxIn& txin : tx->vin) {
+                auto it = mapOutpoints.find(txin.prevout);
+                if (it == mapOutpoints.end()) {
+                    continue;
+                }
+                for (const uint256& txid : it->second) {
+                    if (mapSpentHeight.emplace(txid, pindex->nHeight).second) {
+                        LogPrintf("Watchtower: input %s of recovery %s spent by %s\n",
+                                  txin.prevout.ToString(), txid.ToString(), tx->GetHash().ToString());
+                        fChanged = true;
+                    }
+                }
+            }
+        }
+
+        for (auto it = mapSpentHeight.begin(); it != mapSpentHeight.end();) {
+            const uint256 txid = it->first;
+            const int nSpentHeight = it->second;
+            ++it;
+            if (nSpentHeight <= nForgetHeight) {
+                LogPrintf("Watchtower: forgetting recovery %s, input spent at height %d\n", txid.ToString(), nSpentHeight);
+                RemoveUnchecked(txid);
+                fChanged = true;
+            }
+        }
+    }
+    if (fChanged) {
+        Dump();
+    }
+}
+
+void CWatchtower::BlockDisconnected(const std::shared_ptr<const CBlock>& block)
+{
+    int nHeight;
+    {
+        LOCK(cs_main);
+        const CBlockIndex* pindex = LookupBlockIndex(block->GetHash());
+        if (!pindex) {
+            return;
+        }
+        nHeight = pindex->nHeight;
+    }
+
+    // Inputs spent by the block are unspent again, unless an earlier block spent another input
+    bool fChanged = false;
+    {
+        LOCK(cs);
+        for (auto it = mapSpentHeight.begin(); it != mapSpentHeight.end();) {
+            if (it->second >= nHeight) {
+                it = mapSpentHeight.erase(it);
+                fChanged = true;
+            } else {
+                ++it;
+            }
+        }
+    }
+    if (fChanged) {
+        Dump();
+    }
+}
+
+bool CWatchtower::Add(const CTransactionRef& tx, std::string& error)
+{
+    if (GetVaultTxTypeNonContextual(*tx) != TX_RECOVERY) {
+        error = "Transaction is not a signed recovery";
+        return false;
+    }
+    {
+        LOCK(cs);
+        AddUnchecked(tx);
+    }
+    if (!Dump()) {
+        error = "Failed to write watchtower file";
+        return false;
+    }
+    return true;
+}
+
+bool CWatchtower::Remove(const uint256& txid)
+{
+    {
+        LOCK(cs);
+        if (!mapRecoveries.count(txid)) {
+            return false;
+        }
+        RemoveUnchecked(txid);
+    }
+    Dump();
+    return true;
+}
+
+std::vector<CTransactionRef> CWatchtower::GetRecoveries() const
+{
+    std::vector<CTransactionRef> vtx;
+    LOCK(cs);
+    for (const auto& item : mapRecoveries) {
+        vtx.push_back(item.second);
+    }
+    return vtx;
+}
+
+bool CWatchtower::Load()
+{
+    FILE* filestr = fsbridge::fopen(GetDataDir() / "watchtower.dat", "rb");
+    CAutoFile file(filestr, SER_DISK, CLIENT_VERSION);
+    if (file.IsNull()) {
+        return false;
+    }
+
+    std::vector<CTransactionRef> vtx;
+    std::map<uint256, int> mapSpent;
+    try {
+        uint64_t version;
+        file >> version;
+        if (version != WATCHTOWER_DUMP_VERSION) {
+            return false;
+        }
+        file >> vtx;
+        file >> mapSpent;
+    } catch (const std::exception& e) {
+        LogPrintf("Failed to deserialize watchtower data on disk: %s. Continuing anyway.\n", e.what());
+        return false;
+    }
+
+    LOCK(cs);
+    for (const CTransactionRef& tx : vtx) {
+        AddUnchecked(tx);
+    }
+    for (const auto& item : mapSpent) {
+        if (mapRecoveries.count(item.first)) {
+            mapSpentHeight.insert(item);
+        }
+    }
+    LogPrintf("Loaded %u recoveries into the watchtower\n", vtx.size());
+    return true;
+}
+
+bool CWatchtower::Dump() const
+{
+    static Mutex dump_mutex;
+    LOCK(dump_mutex);
+
+    std::vector<CTransactionRef> vtx;
+    std::map<uint256, int> mapSpent;
+    {
+        LOCK(cs);
+        for (const auto& item : mapRecoveries) {
+            vtx.push_back(item.second);
+        }
+        mapSpent = mapSpentHeight;
+    }
+    try {
+        FILE* filestr = fsbridge::fopen(GetDataDir() / "watchtower.dat.new", "wb");
+        if (!filestr) {
+            return false;
+        }
+
+        CAutoFile file(filestr, SER_DISK, CLIENT_VERSION);
+        file << WATCHTOWER_DUMP_VERSION;
+        file << vtx;
+        file << mapSpent;
+        if (!FileCommit(file.Get()))
+            throw std::runtime_error("FileCommit failed");
+        file.fclose();
+        RenameOver(GetDataDir() / "watchtower.dat.new", GetDataDir() / "watchtower.dat");
+    } catch (const std::exception& e) {
+        LogPrintf("Failed to dump watchtower: %s. Continuing anyway.\n", e.what());
+        return false;
+    }
+    return true;
+}
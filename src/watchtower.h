@@ -0,0 +1,79 @@
+// Copyright (c) 2020 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_WATCHTOWER_H
+#define BITCOIN_WATCHTOWER_H
+
+#include <coins.h>
+#include <primitives/transaction.h>
+#include <sync.h>
+#include <uint256.h>
+#include <validationinterface.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/** Default for -watchtower */
+static const bool DEFAULT_WATCHTOWER = false;
+
+/**
+ * In-node watchtower for vaults.
+ *
+ * Holds pre-signed recovery transactions and submits the matching recovery to
+ * the mempool as soon as an alert spending one of its inputs enters the
+ * mempool or is mined in a block's vatx, instead of relying on an external
+ * process polling the node.
+ *
+ * Recoveries are indexed by the vault outpoints they spend, so every input of
+ * an alert is matched with a single hash table lookup. Recoveries are
+ * forgotten once a block spending one of their inputs without being reverted,
+ * i.e. containing the recovery itself, an instant transaction or the confirmed
+ * alert, is buried nAlertsInitializationWindow blocks deep. Until then a reorg
+ * may bring the alert back. The registered recoveries are persisted in
+ * watchtower.dat.
+ */
+class CWatchtower final : public CValidationInterface
+{
+private:
+    mutable CCriticalSection cs;
+    //! Registered recoveries by txid
+    std::map<uint256, CTransactionRef> mapRecoveries GUARDED_BY(cs);
+    //! Txids of the registered recoveries spending each vault outpoint
+    std::unordered_map<COutPoint, std::vector<uint256>, SaltedOutpointHasher> mapOutpoints GUARDED_BY(cs);
+    //! Height of the first block of the active chain spending an input of a registered recovery, by recovery txid
+    std::map<uint256, int> mapSpentHeight GUARDED_BY(cs);
+
+    void AddUnchecked(const CTransactionRef& tx) EXCLUSIVE_LOCKS_REQUIRED(cs);
+    void RemoveUnchecked(const uint256& txid) EXCLUSIVE_LOCKS_REQUIRED(cs);
+
+    /** Return the registered recoveries spending any input of the alert. */
+    std::vector<CTransactionRef> FindRecoveries(const CBaseTransaction& alert) const;
+    /** Submit the registered recoveries of the alert to the mempool and relay them. */
+    void SubmitRecoveries(const CBaseTransaction& alert);
+
+protected:
+    void TransactionAddedToMempool(const CTransactionRef& ptx) override;
+    void BlockConnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex, const std::vector<CTransactionRef>& txnConflicted) override;
+    void BlockDisconnected(const std::shared_ptr<const CBlock>& block) override;
+
+public:
+    /** Register a signed recovery transaction. Returns false and sets error if it is not a recovery. */
+    bool Add(const CTransactionRef& tx, std::string& error);
+    /** Forget a registered recovery. Returns false if it is not registered. */
+    bool Remove(const uint256& txid);
+    std::vector<CTransactionRef> GetRecoveries() const;
+
+    /** Load the registered recoveries from watchtower.dat. */
+    bool Load();
+    /** Write the registered recoveries to watchtower.dat. */
+    bool Dump() const;
+};
+
+/** The global watchtower, null unless enabled with -watchtower. */
+extern std::unique_ptr<CWatchtower> g_watchtower;
+
+#endif // BITCOIN_WATCHTOWER_H
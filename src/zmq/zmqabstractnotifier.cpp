@@ -21,3 +21,18 @@ bool CZMQAbstractNotifier::NotifyTransaction(const CTransaction &/*transaction*/
 {
     return true;
 }
+
+bool CZMQAbstractNotifier::NotifyAlert(const CBaseTransaction &/*alert*/, int /*nHeight*/, int /*nConfirmHeight*/)
+{
+    return true;
+}
+
+bool CZMQAbstractNotifier::NotifyAlertConfirmed(const CBaseTransaction &/*alert*/, int /*nHeight*/, int /*nConfirmHeight*/)
+{
+    return true;
+}
+
+bool CZMQAbstractNotifier::NotifyAlertRecovered(const uint256 &/*alertHash*/, const CTransaction &/*recovery*/, int /*nHeight*/, int /*nRecoveryHeight*/)
+{
+    return true;
+}
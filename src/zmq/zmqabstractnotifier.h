@@ -7,8 +7,11 @@
 
 #include <zmq/zmqconfig.h>
 
+class CBaseTransaction;
 class CBlockIndex;
+class CTransaction;
 class CZMQAbstractNotifier;
+class uint256;
 
 typedef CZMQAbstractNotifier* (*CZMQNotifierFactory)();
 
@@ -42,6 +45,12 @@ public:
 
     virtual bool NotifyBlock(const CBlockIndex *pindex);
     virtual bool NotifyTransaction(const CTransaction &transaction);
+    // Alert mined in the vatx of the block at nHeight, confirmed at nConfirmHeight unless recovered
+    virtual bool NotifyAlert(const CBaseTransaction &alert, int nHeight, int nConfirmHeight);
+    // Alert mined at nHeight, confirmed in the block at nConfirmHeight
+    virtual bool NotifyAlertConfirmed(const CBaseTransaction &alert, int nHeight, int nConfirmHeight);
+    // Alert mined at nHeight, recovered by a transaction of the block at nRecoveryHeight
+    virtual bool NotifyAlertRecovered(const uint256 &alertHash, const CTransaction &recovery, int nHeight, int nRecoveryHeight);
 
 protected:
     void *psocket;
@@ -5,11 +5,16 @@
 #include <zmq/zmqnotificationinterface.h>
 #include <zmq/zmqpublishnotifier.h>
 
+#include <chain.h>
+#include <chainparams.h>
+#include <index/alertindex.h>
 #include <version.h>
 #include <validation.h>
 #include <streams.h>
 #include <util/system.h>
 
+#include <set>
+
 void zmqError(const char *str)
 {
     LogPrint(BCLog::ZMQ, "zmq: Error: %s, errno=%s\n", str, zmq_strerror(errno));
@@ -48,6 +53,10 @@ CZMQNotificationInterface* CZMQNotificationInterface::Create()
     factories["pubhashtx"] = CZMQAbstractNotifier::Create<CZMQPublishHashTransactionNotifier>;
     factories["pubrawblock"] = CZMQAbstractNotifier::Create<CZMQPublishRawBlockNotifier>;
     factories["pubrawtx"] = CZMQAbstractNotifier::Create<CZMQPublishRawTransactionNotifier>;
+    factories["pubhashalert"] = CZMQAbstractNotifier::Create<CZMQPublishHashAlertNotifier>;
+    factories["pubrawalert"] = CZMQAbstractNotifier::Create<CZMQPublishRawAlertNotifier>;
+    factories["pubalertconfirmed"] = CZMQAbstractNotifier::Create<CZMQPublishAlertConfirmedNotifier>;
+    factories["pubalertrecovered"] = CZMQAbstractNotifier::Create<CZMQPublishAlertRecoveredNotifier>;
 
     for (const auto& entry : factories)
     {
@@ -138,6 +147,24 @@ void CZMQNotificationInterface::Shutdown()
     }
 }
 
+template <typename Function>
+void CZMQNotificationInterface::TryForEachAndRemoveFailed(const Function& func)
+{
+    for (std::list<CZMQAbstractNotifier*>::iterator i = notifiers.begin(); i!=notifiers.end(); )
+    {
+        CZMQAbstractNotifier *notifier = *i;
+        if (func(notifier))
+        {
+            i++;
+        }
+        else
+        {
+            notifier->Shutdown();
+            i = notifiers.erase(i);
+        }
+    }
+}
+
 void CZMQNotificationInterface::UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload)
 {
     if (fInitialDownload || pindexNew == pindexFork) // In IBD or blocks were disconnected without any new ones
@@ -185,6 +212,62 @@ void CZMQNotificationInterface::BlockConnected(const std::shared_ptr<const CBloc
         // Do a normal notify for each transaction added in the block
         TransactionAddedToMempool(ptx);
     }
+
+    const Consensus::Params& params = Params().GetConsensus();
+    const int nWindow = params.nAlertsInitializationWindow;
+    const int nHeight = pindexConnected->nHeight;
+    if (!AreAlertsEnabled(nHeight, params.AlertsHeight)) {
+        return;
+    }
+
+    for (const CAlertTransactionRef& patx : pblock->vatx) {
+        TryForEachAndRemoveFailed([&](CZMQAbstractNotifier* notifier) {
+            return notifier->NotifyAlert(*patx, nHeight, nHeight + nWindow);
+        });
+    }
+
+    // Alerts are confirmed as regular transactions of the block at the end of the window.
+    // Recoveries spend the inputs of alerts mined earlier in the window.
+    std::vector<CTransactionRef> vRecoveries;
+    for (const CTransactionRef& ptx : pblock->vtx) {
+        if (ptx->IsCoinBase()) continue;
+        vaulttxntype txType = GetVaultTxTypeNonContextual(*ptx);
+        if (txType == TX_ALERT && nHeight > nWindow) {
+            TryForEachAndRemoveFailed([&](CZMQAbstractNotifier* notifier) {
+                return notifier->NotifyAlertConfirmed(*ptx, nHeight - nWindow, nHeight);
+            });
+        } else if (txType == TX_RECOVERY) {
+            vRecoveries.push_back(ptx);
+        }
+    }
+
+    // Inputs of the recoveries are matched with the alerts they revert using the alert index
+    if (vRecoveries.empty() || !g_alertindex) {
+        return;
+    }
+    for (const CTransactionRef& ptx : vRecoveries) {
+        std::set<uint256> setAlerts;
+        for (const CTxIn& txin : ptx->vin) {
+            CAlertSpend spend;
+            if (!g_alertindex->FindAlertSpend(txin.prevout, spend)) {
+                continue;
+            }
+            // Entries of blocks which have been reorganized out are not erased
+            if (spend.nHeight >= nHeight || spend.nHeight < nHeight - nWindow) {
+                continue;
+            }
+            const CBlockIndex* pindexAlert = pindexConnected->GetAncestor(spend.nHeight);
+            if (!pindexAlert || pindexAlert->GetBlockHash() != spend.hashBlock) {
+                continue;
+            }
+            if (!setAlerts.insert(spend.alertTxid).second) {
+                continue;
+            }
+            TryForEachAndRemoveFailed([&](CZMQAbstractNotifier* notifier) {
+                return notifier->NotifyAlertRecovered(spend.alertTxid, *ptx, spend.nHeight, nHeight);
+            });
+        }
+    }
 }
 
 void CZMQNotificationInterface::BlockDisconnected(const std::shared_ptr<const CBlock>& pblock)
@@ -35,6 +35,10 @@ protected:
 private:
     CZMQNotificationInterface();
 
+    // Call func on every notifier, shutting down and removing the notifiers for which it fails
+    template <typename Function>
+    void TryForEachAndRemoveFailed(const Function& func);
+
     void *pcontext;
     std::list<CZMQAbstractNotifier*> notifiers;
 };
@@ -16,6 +16,10 @@ static const char *MSG_HASHBLOCK = "hashblock";
 static const char *MSG_HASHTX    = "hashtx";
 static const char *MSG_RAWBLOCK  = "rawblock";
 static const char *MSG_RAWTX     = "rawtx";
+static const char *MSG_HASHALERT = "hashalert";
+static const char *MSG_RAWALERT  = "rawalert";
+static const char *MSG_ALERTCONFIRMED = "alertconfirmed";
+static const char *MSG_ALERTRECOVERED = "alertrecovered";
 
 // Internal function to send multipart message
 static int zmq_send_multipart(void *sock, const void* data, size_t size, ...)
@@ -206,3 +210,63 @@ bool CZMQPublishRawTransactionNotifier::NotifyTransaction(const CTransaction &tr
     ss << transaction;
     return SendMessage(MSG_RAWTX, &(*ss.begin()), ss.size());
 }
+
+// Append a hash in the byte order used by the hash notifications
+static void AppendHash(std::vector<unsigned char>& data, const uint256& hash)
+{
+    for (unsigned int i = 0; i < 32; i++)
+        data.push_back(hash.begin()[31 - i]);
+}
+
+// Append a LE 4byte height
+static void AppendHeight(std::vector<unsigned char>& data, int nHeight)
+{
+    unsigned char buf[sizeof(uint32_t)];
+    WriteLE32(buf, nHeight);
+    data.insert(data.end(), buf, buf + sizeof(buf));
+}
+
+bool CZMQPublishHashAlertNotifier::NotifyAlert(const CBaseTransaction &alert, int nHeight, int nConfirmHeight)
+{
+    uint256 hash = alert.GetHash();
+    LogPrint(BCLog::ZMQ, "zmq: Publish hashalert %s\n", hash.GetHex());
+    std::vector<unsigned char> data;
+    AppendHash(data, hash);
+    AppendHeight(data, nHeight);
+    AppendHeight(data, nConfirmHeight);
+    return SendMessage(MSG_HASHALERT, data.data(), data.size());
+}
+
+bool CZMQPublishRawAlertNotifier::NotifyAlert(const CBaseTransaction &alert, int nHeight, int nConfirmHeight)
+{
+    uint256 hash = alert.GetHash();
+    LogPrint(BCLog::ZMQ, "zmq: Publish rawalert %s\n", hash.GetHex());
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags());
+    ss << alert;
+    std::vector<unsigned char> data(ss.begin(), ss.end());
+    AppendHeight(data, nHeight);
+    AppendHeight(data, nConfirmHeight);
+    return SendMessage(MSG_RAWALERT, data.data(), data.size());
+}
+
+bool CZMQPublishAlertConfirmedNotifier::NotifyAlertConfirmed(const CBaseTransaction &alert, int nHeight, int nConfirmHeight)
+{
+    uint256 hash = alert.GetHash();
+    LogPrint(BCLog::ZMQ, "zmq: Publish alertconfirmed %s\n", hash.GetHex());
+    std::vector<unsigned char> data;
+    AppendHash(data, hash);
+    AppendHeight(data, nHeight);
+    AppendHeight(data, nConfirmHeight);
+    return SendMessage(MSG_ALERTCONFIRMED, data.data(), data.size());
+}
+
+bool CZMQPublishAlertRecoveredNotifier::NotifyAlertRecovered(const uint256 &alertHash, const CTransaction &recovery, int nHeight, int nRecoveryHeight)
+{
+    LogPrint(BCLog::ZMQ, "zmq: Publish alertrecovered %s\n", alertHash.GetHex());
+    std::vector<unsigned char> data;
+    AppendHash(data, alertHash);
+    AppendHash(data, recovery.GetHash());
+    AppendHeight(data, nHeight);
+    AppendHeight(data, nRecoveryHeight);
+    return SendMessage(MSG_ALERTRECOVERED, data.data(), data.size());
+}
@@ -52,4 +52,28 @@ public:
     bool NotifyTransaction(const CTransaction &transaction) override;
 };
 
+class CZMQPublishHashAlertNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    bool NotifyAlert(const CBaseTransaction &alert, int nHeight, int nConfirmHeight) override;
+};
+
+class CZMQPublishRawAlertNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    bool NotifyAlert(const CBaseTransaction &alert, int nHeight, int nConfirmHeight) override;
+};
+
+class CZMQPublishAlertConfirmedNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    bool NotifyAlertConfirmed(const CBaseTransaction &alert, int nHeight, int nConfirmHeight) override;
+};
+
+class CZMQPublishAlertRecoveredNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    bool NotifyAlertRecovered(const uint256 &alertHash, const CTransaction &recovery, int nHeight, int nRecoveryHeight) override;
+};
+
 #endif // BITCOIN_ZMQ_ZMQPUBLISHNOTIFIER_H
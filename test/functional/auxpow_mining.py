@@ -163,6 +163,14 @@ class AuxpowMiningTest (BitcoinTestFramework):
     assert_equal (addr1, coinbaseAddr)
     assert_equal (addr2, coinbaseAddr)
 
+    # A long-poll on a stale tip returns the work for the new tip right away
+    auxblock = create ()
+    self.nodes[0].generate (1)
+    newblock = self.nodes[0].createauxblock (coinbaseAddr, auxblock['longpollid'])
+    assert_equal (newblock['previousblockhash'], self.nodes[0].getbestblockhash ())
+    assert newblock['longpollid'] != auxblock['longpollid']
+    self.sync_all ()
+
     # Ensure that different payout addresses will generate different auxblocks
     auxblock1 = self.nodes[0].createauxblock(self.nodes[0].getnewaddress ())
     auxblock2 = self.nodes[0].createauxblock(self.nodes[0].getnewaddress ())
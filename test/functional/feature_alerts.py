@@ -8,7 +8,7 @@ import shutil
 
 from decimal import Decimal
 from test_framework.test_framework import BitcoinTestFramework
-from test_framework.util import get_datadir_path, hex_str_to_bytes
+from test_framework.util import assert_equal, get_datadir_path, hex_str_to_bytes
 from test_framework.address import key_to_p2pkh
 
 
@@ -215,6 +215,10 @@ class AlertsTest(BitcoinTestFramework):
         self.log.info("Test recovery transaction flow for two alerts")
         self.test_recovery_tx_flow_for_two_alerts()
 
+        self.reset_blockchain()
+        self.log.info("Test batch recovery transaction flow")
+        self.test_batch_recovery_tx_flow()
+
         self.reset_blockchain()
         self.log.info("Test recovery tx is rejected when alert inputs are missing")
         self.test_recovery_tx_is_rejected_when_alert_inputs_are_missing()
@@ -1128,6 +1132,40 @@ class AlertsTest(BitcoinTestFramework):
         assert self.find_address(self.nodes[0].listreceivedbyaddress(), other_addr0)['amount'] == self.COINBASE_AMOUNT - atx_fee
         assert self.find_address(self.nodes[0].listreceivedbyaddress(), other_addr0)['txids'] == [recovery_txid]
 
+    def test_batch_recovery_tx_flow(self):
+        alert_addr0 = self.nodes[0].getnewvaultalertaddress(self.alert_recovery_pubkey)
+        other_addr0 = self.nodes[0].getnewaddress()
+        attacker_addr1 = self.nodes[1].getnewaddress()
+
+        # mine some coins to node0
+        self.nodes[0].generatetoaddress(200, alert_addr0['address'])  # 200
+
+        # send two atxs to node1 and mine them
+        atxids = [self.nodes[0].sendalerttoaddress(attacker_addr1, 10) for _ in range(2)]
+        self.nodes[0].generatetoaddress(1, alert_addr0['address'])  # 201
+        self.sync_all()
+        assert all(atxid in self.nodes[0].getbestblock()['atx'] for atxid in atxids)
+
+        # recover both atxs in one go
+        alerts = []
+        for atxid in atxids:
+            atx = self.nodes[0].decoderawtransaction(self.nodes[0].gettransaction(atxid)['hex'])
+            amount_to_recover = sum([vout['value'] for vout in atx['vout']])
+            alerts.append({'atxid': atxid, 'outputs': [{other_addr0: amount_to_recover}]})
+        recovery_txs = self.nodes[0].createrecoverytransactions(alerts)
+        assert_equal(len(recovery_txs), 2)
+        results = self.nodes[0].signrecoverytransactions(recovery_txs, [self.alert_recovery_privkey], alert_addr0['redeemScript'], None, None, True)
+
+        # assert
+        assert_equal(len(results), 2)
+        assert all(result['complete'] for result in results)
+        recovery_txids = [result['txid'] for result in results]
+        assert all(txid in self.nodes[0].getrawmempool() for txid in recovery_txids)
+
+        self.nodes[0].generatetoaddress(1, alert_addr0['address'])  # 202
+        self.sync_all()
+        assert all(txid in self.nodes[0].getbestblock()['tx'] for txid in recovery_txids)
+
     def test_recovery_tx_flow_for_two_alerts(self):
         addr0 = self.nodes[0].getnewaddress()
 
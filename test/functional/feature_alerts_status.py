@@ -0,0 +1,105 @@
+#!/usr/bin/env python3
+# Copyright (c) 2020 The Bitcoin Core developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test the alert status recorded by the txindex.
+
+- Connect: an alert is pending once mined and confirmed by the block at
+  h + nAlertsInitializationWindow.
+- Disconnect: invalidating the confirming block makes the alert pending
+  again, reconsidering it confirms the alert again.
+- Reorg: an alert recovered on a shorter branch is confirmed once the node
+  reorganizes to a longer chain confirming it.
+"""
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import (
+    assert_equal,
+    connect_nodes,
+    disconnect_nodes,
+    sync_blocks,
+    wait_until,
+)
+
+ALERT_RECOVERY_PUBKEY = "02ecec100acb89f3049285ae01e7f03fb469e6b54d44b0f3c8240b1958e893cb8c"
+ALERT_RECOVERY_PRIVKEY = "cRfYLWua6WcpGbxuv5rJgA2eDESWxqgzmQjKQuqDFMfgbnEpqhrP"
+ALERTS_INITIALIZATION_WINDOW = 144
+
+
+class AlertsStatusTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.setup_clean_chain = True
+        self.num_nodes = 2
+        self.extra_args = [
+            ["-txindex"],
+            ["-txindex"],
+        ]
+
+    def skip_test_if_missing_module(self):
+        self.skip_if_no_wallet()
+
+    def setup_network(self):
+        self.setup_nodes()
+        connect_nodes(self.nodes[0], 1)
+
+    def alert_status(self, node, atxid, alert_hash):
+        return node.getrawtransaction(atxid, True, alert_hash)['status']
+
+    def wait_for_alert_status(self, node, atxid, alert_hash, status):
+        wait_until(lambda: self.alert_status(node, atxid, alert_hash) == status, timeout=30)
+
+    def send_alert(self, node, alert_addr, addr):
+        atxid = node.sendalerttoaddress(addr, 10)
+        alert_hash = node.generatetoaddress(1, alert_addr['address'])[0]
+        assert atxid in node.getblock(alert_hash)['atx']
+        return atxid, alert_hash
+
+    def run_test(self):
+        node0, node1 = self.nodes
+        alert_addr = node0.getnewvaultalertaddress(ALERT_RECOVERY_PUBKEY)
+        addr0 = node0.getnewaddress()
+        addr1 = node1.getnewaddress()
+        node0.generatetoaddress(200, alert_addr['address'])
+
+        self.log.info("Alerts are pending when mined and confirmed by the block closing the window")
+        atxid, alert_hash = self.send_alert(node0, alert_addr, addr1)
+        sync_blocks(self.nodes)
+        for node in self.nodes:
+            self.wait_for_alert_status(node, atxid, alert_hash, 'PENDING')
+
+        node0.generatetoaddress(ALERTS_INITIALIZATION_WINDOW - 1, addr0)
+        confirm_hash = node0.generatetoaddress(1, addr0)[0]
+        assert atxid in node0.getblock(confirm_hash)['tx']
+        sync_blocks(self.nodes)
+        for node in self.nodes:
+            self.wait_for_alert_status(node, atxid, alert_hash, 'CONFIRMED')
+
+        self.log.info("Disconnecting the confirming block makes the alert pending again")
+        node0.invalidateblock(confirm_hash)
+        self.wait_for_alert_status(node0, atxid, alert_hash, 'PENDING')
+        node0.reconsiderblock(confirm_hash)
+        assert_equal(node0.getbestblockhash(), node1.getbestblockhash())
+        self.wait_for_alert_status(node0, atxid, alert_hash, 'CONFIRMED')
+
+        self.log.info("A reorg to a chain confirming a recovered alert confirms it")
+        atxid, alert_hash = self.send_alert(node0, alert_addr, addr1)
+        sync_blocks(self.nodes)
+        disconnect_nodes(node0, 1)
+
+        atx = node0.getrawtransaction(atxid, True, alert_hash)
+        amount_to_recover = sum([vout['value'] for vout in atx['vout']])
+        recovery_tx = node0.createrecoverytransaction(atxid, {addr0: amount_to_recover})
+        recovery_tx = node0.signrecoverytransaction(recovery_tx, [ALERT_RECOVERY_PRIVKEY], alert_addr['redeemScript'])
+        recovery_txid = node0.sendrawtransaction(recovery_tx['hex'])
+        recovery_hash = node0.generatetoaddress(1, addr0)[0]
+        assert recovery_txid in node0.getblock(recovery_hash)['tx']
+        self.wait_for_alert_status(node0, atxid, alert_hash, 'RECOVERED')
+
+        node1.generatetoaddress(ALERTS_INITIALIZATION_WINDOW + 5, addr1)
+        self.wait_for_alert_status(node1, atxid, alert_hash, 'CONFIRMED')
+        connect_nodes(node0, 1)
+        sync_blocks(self.nodes)
+        self.wait_for_alert_status(node0, atxid, alert_hash, 'CONFIRMED')
+
+
+if __name__ == '__main__':
+    AlertsStatusTest().main()
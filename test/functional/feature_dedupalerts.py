@@ -0,0 +1,119 @@
+#!/usr/bin/env python3
+# Copyright (c) 2020 The Bitcoin Core developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test storing confirmed alerts in block files as references with -dedupalerts.
+
+- node0 stores its blocks with -dedupalerts, node1 and node2 store them in the
+  canonical format and keep a -txindex.
+- Check that -dedupalerts and -txindex cannot be combined.
+- Mine an alert and the block confirming it on node0, read the block back from
+  node0's disk and relay it to node1.
+- Reindex node0 from its own block files and import them on node2 with -loadblock.
+- Check that the txindex refuses block files written with -dedupalerts.
+"""
+import os
+import shutil
+
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import (
+    assert_equal,
+    connect_nodes,
+    sync_blocks,
+    wait_until,
+)
+
+ALERT_RECOVERY_PUBKEY = "02ecec100acb89f3049285ae01e7f03fb469e6b54d44b0f3c8240b1958e893cb8c"
+ALERTS_INITIALIZATION_WINDOW = 144
+
+
+class DedupAlertsTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.setup_clean_chain = True
+        self.num_nodes = 3
+        self.extra_args = [
+            ["-dedupalerts"],
+            ["-txindex"],
+            ["-txindex"],
+        ]
+
+    def skip_test_if_missing_module(self):
+        self.skip_if_no_wallet()
+
+    def setup_network(self):
+        self.setup_nodes()
+
+    def check_confirming_block(self, node, raw_block, txids):
+        assert_equal(node.getblock(self.confirm_hash, 0), raw_block)
+        block = node.getblock(self.confirm_hash)
+        for txid in txids:
+            assert txid in block['tx']
+            assert_equal(node.getrawtransaction(txid, True, self.confirm_hash)['txid'], txid)
+
+    def check_txindex(self, node, txids):
+        for txid in txids:
+            tx = node.getrawtransaction(txid, True)
+            assert_equal(tx['txid'], txid)
+            assert_equal(tx['blockhash'], self.confirm_hash)
+
+    def run_test(self):
+        node0, node1, node2 = self.nodes
+
+        self.log.info("Refuse -dedupalerts together with -txindex")
+        self.stop_node(0)
+        node0.assert_start_raises_init_error(["-dedupalerts", "-txindex"], "Error: -txindex is incompatible with -dedupalerts.")
+        self.start_node(0, self.extra_args[0])
+
+        self.log.info("Mine an alert and the block confirming it with -dedupalerts")
+        alert_addr = node0.getnewvaultalertaddress(ALERT_RECOVERY_PUBKEY)
+        addr = node0.getnewaddress()
+        node0.generatetoaddress(1, alert_addr['address'])
+        node0.generatetoaddress(110, addr)
+        atxid = node0.sendalerttoaddress(addr, 10)
+        alert_hash = node0.generatetoaddress(1, addr)[0]
+        assert atxid in node0.getblock(alert_hash)['atx']
+
+        # The confirming block also contains a regular transaction, stored after the reference
+        node0.generatetoaddress(ALERTS_INITIALIZATION_WINDOW - 1, addr)
+        txid = node0.sendtoaddress(node0.getnewaddress(), 1)
+        self.confirm_hash = node0.generatetoaddress(1, addr)[0]
+        node0.generatetoaddress(10, addr)
+        coinbase_txid = node0.getblock(self.confirm_hash)['tx'][0]
+        txids = [coinbase_txid, atxid, txid]
+
+        self.log.info("Read the confirming block back from disk")
+        self.restart_node(0, self.extra_args[0])
+        raw_block = node0.getblock(self.confirm_hash, 0)
+        self.check_confirming_block(node0, raw_block, txids)
+
+        self.log.info("Relay the blocks in the canonical encoding")
+        connect_nodes(node1, 0)
+        sync_blocks([node0, node1])
+        self.check_confirming_block(node1, raw_block, txids)
+        self.check_txindex(node1, txids)
+
+        self.log.info("Reindex block files with alert references")
+        blockcount = node0.getblockcount()
+        self.restart_node(0, self.extra_args[0] + ["-reindex"])
+        wait_until(lambda: node0.getblockcount() == blockcount)
+        assert_equal(node0.getbestblockhash(), node1.getbestblockhash())
+        self.check_confirming_block(node0, raw_block, txids)
+
+        self.log.info("Import block files with alert references with -loadblock")
+        self.stop_node(0)
+        bootstrap_file = os.path.join(self.options.tmpdir, "bootstrap.dat")
+        shutil.copyfile(os.path.join(node0.datadir, "regtest", "blocks", "blk00000.dat"), bootstrap_file)
+        self.restart_node(2, self.extra_args[2] + ["-loadblock=" + bootstrap_file])
+        wait_until(lambda: node2.getblockcount() == blockcount)
+        assert_equal(node2.getbestblockhash(), node1.getbestblockhash())
+        self.check_confirming_block(node2, raw_block, txids)
+        self.check_txindex(node2, txids)
+
+        self.log.info("Refuse to build a txindex over block files with alert references")
+        with node0.assert_debug_log(["was stored with -dedupalerts, which is incompatible with -txindex"]):
+            node0.start(["-txindex"])
+            node0.wait_until_stopped()
+
+
+if __name__ == '__main__':
+    DedupAlertsTest().main()
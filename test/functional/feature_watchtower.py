@@ -0,0 +1,118 @@
+#!/usr/bin/env python3
+# Copyright (c) 2020 The Bitcoin Core developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test the in-node watchtower.
+
+- The watchtower is disabled by default.
+- Register and unregister recoveries, and check that they are kept across
+  restarts.
+- Mine an alert and check that the registered recovery is submitted to the
+  mempool and relayed.
+- Check that the recovery is forgotten once its block is buried
+  nAlertsInitializationWindow blocks deep.
+"""
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import (
+    assert_equal,
+    assert_raises_rpc_error,
+    connect_nodes,
+    sync_blocks,
+    wait_until,
+)
+
+ALERT_RECOVERY_PUBKEY = "02ecec100acb89f3049285ae01e7f03fb469e6b54d44b0f3c8240b1958e893cb8c"
+ALERT_RECOVERY_PRIVKEY = "cRfYLWua6WcpGbxuv5rJgA2eDESWxqgzmQjKQuqDFMfgbnEpqhrP"
+ALERTS_INITIALIZATION_WINDOW = 144
+
+
+class WatchtowerTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.setup_clean_chain = True
+        self.num_nodes = 2
+        self.extra_args = [
+            ["-watchtower"],
+            [],
+        ]
+
+    def skip_test_if_missing_module(self):
+        self.skip_if_no_wallet()
+
+    def create_alert_and_recovery(self, node, alert_addr, height, addr):
+        blockhash = node.getblockhash(height)
+        txid = node.getblock(blockhash)['tx'][0]
+        tx = node.getrawtransaction(txid, True, blockhash)
+        vout = tx['vout'][0]
+        inputs = [{'txid': txid, 'vout': vout['n']}]
+        amount = vout['value'] - 1
+
+        alert = node.createrawtransaction(inputs, {addr: amount})
+        alert = node.signalerttransaction(alert, [{'txid': txid, 'vout': vout['n'], 'scriptPubKey': vout['scriptPubKey']['hex'],
+                                                   'redeemScript': alert_addr['redeemScript'], 'amount': vout['value']}])
+        recovery = node.createrawtransaction(inputs, {node.getnewaddress(): amount})
+        recovery = node.signrecoverytransaction(recovery, [ALERT_RECOVERY_PRIVKEY], alert_addr['redeemScript'])
+        assert recovery['complete']
+        return alert['hex'], recovery['hex']
+
+    def recoveries(self, node):
+        return sorted(entry['txid'] for entry in node.listrecoveries())
+
+    def restart_watchtower(self):
+        self.restart_node(0, self.extra_args[0])
+        connect_nodes(self.nodes[0], 1)
+
+    def run_test(self):
+        node0, node1 = self.nodes
+
+        self.log.info("The watchtower is disabled by default")
+        assert_raises_rpc_error(-1, "Watchtower is disabled", node1.listrecoveries)
+
+        alert_addr = node0.getnewvaultalertaddress(ALERT_RECOVERY_PUBKEY)
+        attacker_addr = node1.getnewaddress()
+        node0.generatetoaddress(200, alert_addr['address'])
+        alert1, recovery1 = self.create_alert_and_recovery(node0, alert_addr, 10, attacker_addr)
+        alert2, recovery2 = self.create_alert_and_recovery(node0, alert_addr, 20, attacker_addr)
+
+        self.log.info("Register recoveries")
+        assert_raises_rpc_error(-8, "Transaction is not a signed recovery", node0.registerrecovery, alert1)
+        recovery1_txid = node0.registerrecovery(recovery1)
+        recovery2_txid = node0.registerrecovery(recovery2)
+        assert_equal(self.recoveries(node0), sorted([recovery1_txid, recovery2_txid]))
+
+        self.log.info("Unregister a recovery")
+        assert node0.unregisterrecovery(recovery2_txid)
+        assert not node0.unregisterrecovery(recovery2_txid)
+        assert_equal(self.recoveries(node0), [recovery1_txid])
+
+        self.log.info("Registered recoveries are kept across restarts")
+        self.restart_watchtower()
+        assert_equal(node0.listrecoveries(), [{'txid': recovery1_txid, 'hex': recovery1}])
+
+        self.log.info("The recovery is submitted and relayed once the alert is mined")
+        alert1_txid = node0.sendrawtransaction(alert1)
+        alert_hash = node0.generatetoaddress(1, alert_addr['address'])[0]
+        assert alert1_txid in node0.getblock(alert_hash)['atx']
+        sync_blocks(self.nodes)
+        wait_until(lambda: recovery1_txid in node0.getrawmempool(), timeout=30)
+        wait_until(lambda: recovery1_txid in node1.getrawmempool(), timeout=30)
+
+        self.log.info("Unregistered recoveries are not submitted")
+        alert2_txid = node0.sendrawtransaction(alert2)
+        alert_hash = node0.generatetoaddress(1, alert_addr['address'])[0]
+        assert alert2_txid in node0.getblock(alert_hash)['atx']
+        assert recovery1_txid in node0.getblock(alert_hash)['tx']
+        recovery_height = node0.getblockcount()
+        assert recovery2_txid not in node0.getrawmempool()
+
+        self.log.info("The recovery is kept until its block is buried, also across restarts")
+        node0.generatetoaddress(ALERTS_INITIALIZATION_WINDOW - 1, alert_addr['address'])
+        assert_equal(self.recoveries(node0), [recovery1_txid])
+        self.restart_watchtower()
+        assert_equal(self.recoveries(node0), [recovery1_txid])
+        node0.generatetoaddress(1, alert_addr['address'])
+        assert_equal(node0.getblockcount(), recovery_height + ALERTS_INITIALIZATION_WINDOW)
+        wait_until(lambda: self.recoveries(node0) == [], timeout=30)
+
+
+if __name__ == '__main__':
+    WatchtowerTest().main()
@@ -16,6 +16,9 @@ from test_framework.util import (
 from io import BytesIO
 
 ADDRESS = "tcp://127.0.0.1:28332"
+ALERT_RECOVERY_PUBKEY = "02ecec100acb89f3049285ae01e7f03fb469e6b54d44b0f3c8240b1958e893cb8c"
+ALERT_RECOVERY_PRIVKEY = "cRfYLWua6WcpGbxuv5rJgA2eDESWxqgzmQjKQuqDFMfgbnEpqhrP"
+ALERTS_INITIALIZATION_WINDOW = 144
 
 class ZMQSubscriber:
     def __init__(self, socket, topic):
@@ -63,8 +66,20 @@ class ZMQTest (BitcoinTestFramework):
         self.rawblock = ZMQSubscriber(socket, b"rawblock")
         self.rawtx = ZMQSubscriber(socket, b"rawtx")
 
+        # Alert topics are received in a separate socket, so that the
+        # order of the block and transaction notifications is unaffected.
+        alert_socket = self.zmq_context.socket(zmq.SUB)
+        alert_socket.set(zmq.RCVTIMEO, 60000)
+        alert_socket.connect(ADDRESS)
+        self.hashalert = ZMQSubscriber(alert_socket, b"hashalert")
+        self.rawalert = ZMQSubscriber(alert_socket, b"rawalert")
+        self.alertconfirmed = ZMQSubscriber(alert_socket, b"alertconfirmed")
+        self.alertrecovered = ZMQSubscriber(alert_socket, b"alertrecovered")
+
+        subscribers = [self.hashblock, self.hashtx, self.rawblock, self.rawtx,
+                       self.hashalert, self.rawalert, self.alertconfirmed, self.alertrecovered]
         self.extra_args = [
-            ["-zmqpub%s=%s" % (sub.topic.decode(), ADDRESS) for sub in [self.hashblock, self.hashtx, self.rawblock, self.rawtx]],
+            ["-zmqpub%s=%s" % (sub.topic.decode(), ADDRESS) for sub in subscribers] + ["-alertindex"],
             [],
         ]
         self.add_nodes(self.num_nodes, self.extra_args)
@@ -122,13 +137,86 @@ class ZMQTest (BitcoinTestFramework):
 
         self.log.info("Test the getzmqnotifications RPC")
         assert_equal(self.nodes[0].getzmqnotifications(), [
+            {"type": "pubalertconfirmed", "address": ADDRESS, "hwm": 1000},
+            {"type": "pubalertrecovered", "address": ADDRESS, "hwm": 1000},
+            {"type": "pubhashalert", "address": ADDRESS, "hwm": 1000},
             {"type": "pubhashblock", "address": ADDRESS, "hwm": 1000},
             {"type": "pubhashtx", "address": ADDRESS, "hwm": 1000},
+            {"type": "pubrawalert", "address": ADDRESS, "hwm": 1000},
             {"type": "pubrawblock", "address": ADDRESS, "hwm": 1000},
             {"type": "pubrawtx", "address": ADDRESS, "hwm": 1000},
         ])
 
         assert_equal(self.nodes[1].getzmqnotifications(), [])
 
+        if self.is_wallet_compiled():
+            self._zmq_alerts_test()
+
+    def _zmq_alerts_test(self):
+        node = self.nodes[0]
+        alert_addr = node.getnewvaultalertaddress(ALERT_RECOVERY_PUBKEY)
+        addr = node.getnewaddress()
+
+        self.log.info("Mine two alerts")
+        inputs = []
+        for _ in range(2):
+            txid = node.sendtoaddress(alert_addr['address'], 10)
+            tx = node.decoderawtransaction(node.gettransaction(txid)['hex'])
+            vout = next(out for out in tx['vout'] if out['value'] == 10)
+            inputs.append({'txid': txid, 'vout': vout['n'], 'scriptPubKey': vout['scriptPubKey']['hex'],
+                           'redeemScript': alert_addr['redeemScript'], 'amount': 10})
+        node.generatetoaddress(1, ADDRESS_BCRT1_UNSPENDABLE)
+
+        atxids = []
+        for prevtx in inputs:
+            atx = node.createrawtransaction([{'txid': prevtx['txid'], 'vout': prevtx['vout']}], {addr: 9.99})
+            atx = node.signalerttransaction(atx, [prevtx])
+            atxids.append(node.sendrawtransaction(atx['hex']))
+        alert_height = node.getblockcount() + 1
+        alert_hash = node.generatetoaddress(1, ADDRESS_BCRT1_UNSPENDABLE)[0]
+        assert_equal(sorted(node.getblock(alert_hash)['atx']), sorted(atxids))
+        heights = (alert_height, alert_height + ALERTS_INITIALIZATION_WINDOW)
+
+        # Should receive the hash and the raw alert with the mined and confirming heights
+        hashes = []
+        for _ in atxids:
+            body = self.hashalert.receive()
+            hashes.append(bytes_to_hex_str(body[:32]))
+            assert_equal(struct.unpack('<II', body[32:]), heights)
+        assert_equal(sorted(hashes), sorted(atxids))
+
+        hashes = []
+        for _ in atxids:
+            body = self.rawalert.receive()
+            atx = CTransaction()
+            atx.deserialize(BytesIO(body[:-8]))
+            atx.calc_sha256()
+            hashes.append(atx.hash)
+            assert_equal(struct.unpack('<II', body[-8:]), heights)
+        assert_equal(sorted(hashes), sorted(atxids))
+
+        self.log.info("Recover the second alert")
+        recovery_tx = node.createrawtransaction([{'txid': inputs[1]['txid'], 'vout': inputs[1]['vout']}], {addr: 9.99})
+        recovery_tx = node.signrecoverytransaction(recovery_tx, [ALERT_RECOVERY_PRIVKEY], alert_addr['redeemScript'])
+        recovery_txid = node.sendrawtransaction(recovery_tx['hex'])
+        recovery_height = node.getblockcount() + 1
+        recovery_hash = node.generatetoaddress(1, ADDRESS_BCRT1_UNSPENDABLE)[0]
+        assert recovery_txid in node.getblock(recovery_hash)['tx']
+
+        # Should receive the recovered alert, the recovery and their heights
+        body = self.alertrecovered.receive()
+        assert_equal(bytes_to_hex_str(body[:32]), atxids[1])
+        assert_equal(bytes_to_hex_str(body[32:64]), recovery_txid)
+        assert_equal(struct.unpack('<II', body[64:]), (alert_height, recovery_height))
+
+        self.log.info("Confirm the first alert")
+        node.generatetoaddress(heights[1] - node.getblockcount(), ADDRESS_BCRT1_UNSPENDABLE)
+        assert atxids[0] in node.getblock(node.getbestblockhash())['tx']
+
+        # Should receive the confirmed alert with the mined and confirming heights
+        body = self.alertconfirmed.receive()
+        assert_equal(bytes_to_hex_str(body[:32]), atxids[0])
+        assert_equal(struct.unpack('<II', body[32:]), heights)
+
 if __name__ == '__main__':
     ZMQTest().main()
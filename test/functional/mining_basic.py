@@ -40,6 +40,19 @@ def assert_template(node, block, expect, rehash=True):
     assert_equal(rsp, expect)
 
 
+# Regtest nLwmaAveragingWindow
+LWMA_AVERAGING_WINDOW = 30
+
+
+def assert_hashps(node, mining_info):
+    """The cached estimates of getmininginfo match the ones computed at the tip"""
+    height = mining_info['blocks']
+    assert_equal(mining_info['networkhashps'], node.getnetworkhashps(120))
+    assert_equal(mining_info['networkhashps'], node.getnetworkhashps(120, height))
+    assert_equal(mining_info['lwmanetworkhashps'], node.getnetworkhashps(LWMA_AVERAGING_WINDOW))
+    assert_equal(mining_info['lwmanetworkhashps'], node.getnetworkhashps(LWMA_AVERAGING_WINDOW, height))
+
+
 class MiningTest(BitcoinTestFramework):
     def set_test_params(self):
         self.num_nodes = 2
@@ -54,6 +67,9 @@ class MiningTest(BitcoinTestFramework):
         assert_equal(mining_info['blocks'], 200)
         assert_equal(mining_info['currentblocktx'], 0)
         assert_equal(mining_info['currentblockweight'], 4000)
+        assert_equal(mining_info['currentblockatx'], 0)
+        assert_equal(mining_info['currentblockalertsfee'], Decimal('0'))
+        assert_hashps(self.nodes[0], mining_info)
         self.restart_node(0)
         connect_nodes_bi(self.nodes, 0, 1)
 
@@ -73,8 +89,10 @@ class MiningTest(BitcoinTestFramework):
         assert_equal(mining_info['chain'], 'regtest')
         assert 'currentblocktx' not in mining_info
         assert 'currentblockweight' not in mining_info
+        assert 'currentblockalertsfee' not in mining_info
         assert_equal(mining_info['difficulty'], Decimal('4.656542373906925E-10'))
         assert_equal(mining_info['networkhashps'], Decimal('0.003333333333333334'))
+        assert_hashps(node, mining_info)
         assert_equal(mining_info['pooledtx'], 0)
 
         # Mine a block to leave initial block download
@@ -63,6 +63,8 @@ class BlockchainTest(BitcoinTestFramework):
         self._test_stopatheight()
         self._test_waitforblockheight()
         assert self.nodes[0].verifychain(4, 0)
+        if self.is_wallet_compiled():
+            self._test_gettxoutsetinfo_alerts()
 
     def mine_chain(self):
         self.log.info('Create some old blocks')
@@ -191,6 +193,9 @@ class BlockchainTest(BitcoinTestFramework):
         assert size < 64000
         assert_equal(len(res['bestblock']), 64)
         assert_equal(len(res['hash_serialized_2']), 64)
+        assert_equal(res['alert_spent_txouts'], 0)
+        assert_equal(res['alert_spent_amount'], Decimal('0'))
+        assert_equal(res['stale_alert_spent_txouts'], 0)
 
         self.log.info("Test that gettxoutsetinfo() works for blockchain with just the genesis block")
         b1hash = node.getblockhash(1)
@@ -307,6 +312,57 @@ class BlockchainTest(BitcoinTestFramework):
         assert_waitforheight(current_height)
         assert_waitforheight(current_height + 1)
 
+    def _test_gettxoutsetinfo_alerts(self):
+        self.log.info("Test that gettxoutsetinfo() reports the outputs spent by mined alerts")
+        node = self.nodes[0]
+        alert_recovery_pubkey = "02ecec100acb89f3049285ae01e7f03fb469e6b54d44b0f3c8240b1958e893cb8c"
+        alert_recovery_privkey = "cRfYLWua6WcpGbxuv5rJgA2eDESWxqgzmQjKQuqDFMfgbnEpqhrP"
+        alert_window = 144
+
+        alert_addr = node.getnewvaultalertaddress(alert_recovery_pubkey)
+        other_addr = node.getnewaddress()
+        node.generatetoaddress(110, alert_addr['address'])
+
+        def send_and_mine_alert():
+            amounts = {(u['txid'], u['vout']): u['amount'] for u in node.listunspent()}
+            atxid = node.sendalerttoaddress(other_addr, 10)
+            node.generatetoaddress(1, alert_addr['address'])
+            assert atxid in node.getbestblock()['atx']
+            vin = node.decoderawtransaction(node.gettransaction(atxid)['hex'])['vin']
+            return atxid, len(vin), sum(amounts[(txin['txid'], txin['vout'])] for txin in vin)
+
+        # A mined alert holds its inputs until it is confirmed or recovered
+        atxid, spent_txouts, spent_amount = send_and_mine_alert()
+        res = node.gettxoutsetinfo()
+        assert_equal(res['alert_spent_txouts'], spent_txouts)
+        assert_equal(res['alert_spent_amount'], spent_amount)
+        assert_equal(res['stale_alert_spent_txouts'], 0)
+
+        # Mining its recovery releases them
+        recoverytx = node.createrecoverytransaction(atxid, [{other_addr: spent_amount - Decimal('0.01')}])
+        recoverytx = node.signrecoverytransaction(recoverytx, [alert_recovery_privkey], alert_addr['redeemScript'])
+        assert recoverytx['complete']
+        node.sendrawtransaction(recoverytx['hex'])
+        node.generatetoaddress(1, alert_addr['address'])
+        res = node.gettxoutsetinfo()
+        assert_equal(res['alert_spent_txouts'], 0)
+        assert_equal(res['alert_spent_amount'], Decimal('0'))
+        assert_equal(res['stale_alert_spent_txouts'], 0)
+
+        # An alert whose confirmation is left out of the block closing its
+        # window keeps its inputs past the window, which makes them stale
+        atxid, spent_txouts, spent_amount = send_and_mine_alert()
+        node.generatetoaddress(alert_window - 1, alert_addr['address'])
+        tip = node.getblock(node.getbestblockhash())
+        block = create_block(int(tip['hash'], 16), create_coinbase(tip['height'] + 1), tip['time'] + 1)
+        block.solve()
+        assert_equal(node.submitblock(block.serialize().hex()), None)
+        assert_equal(node.getbestblockhash(), block.hash)
+        res = node.gettxoutsetinfo()
+        assert_equal(res['alert_spent_txouts'], spent_txouts)
+        assert_equal(res['alert_spent_amount'], spent_amount)
+        assert_equal(res['stale_alert_spent_txouts'], spent_txouts)
+
 
 if __name__ == '__main__':
     BlockchainTest().main()
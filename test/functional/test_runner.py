@@ -212,7 +212,10 @@ EXTENDED_SCRIPTS = [
 VAULT_SCRIPTS = [
     'feature_alerts.py',
     'feature_alerts_instant.py',
-    'feature_alerts_reorg.py'
+    'feature_alerts_reorg.py',
+    'feature_alerts_status.py',
+    'feature_dedupalerts.py',
+    'feature_watchtower.py',
 ]
 
 # Place EXTENDED_SCRIPTS first since it has the 3 longest running tests